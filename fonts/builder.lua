@@ -227,23 +227,43 @@ local function build_font_entry_tables(height, tiny_font, fonts, x_offset_tbl, y
     local rom_datas = {}
     local rom_offsets = {}
     local glyph_count_per = {}
+    local glyph_first_per = {}
+    local glyph_last_per = {}
 
     for i=0,max_glyph_id+1,GLYPH_TABLE_PER do
         rom_datas[i // GLYPH_TABLE_PER] = {0, 0}
         glyph_count_per[i // GLYPH_TABLE_PER] = 0
     end
     for i,char in pairs(chars) do
-        glyph_count_per[i // GLYPH_TABLE_PER] = glyph_count_per[i // GLYPH_TABLE_PER] + 1
+        local page = i // GLYPH_TABLE_PER
+        local low = i & (GLYPH_TABLE_PER - 1)
+        glyph_count_per[page] = glyph_count_per[page] + 1
+        if glyph_first_per[page] == nil or low < glyph_first_per[page] then
+            glyph_first_per[page] = low
+        end
+        if glyph_last_per[page] == nil or low > glyph_last_per[page] then
+            glyph_last_per[page] = low
+        end
     end
 
     local function use_small_glyph(id)
         return (id == 0 and not tiny_font) or glyph_count_per[id] >= GLYPH_ENTRY_STATIC_LIMIT
     end
 
+    -- Pages at least half populated between their first and last glyph use
+    -- a direct table covering that range, avoiding a binary search.
+    local function use_ranged_glyph(id)
+        if use_small_glyph(id) or glyph_count_per[id] == 0 then
+            return false
+        end
+        local span = glyph_last_per[id] - glyph_first_per[id] + 1
+        return span < GLYPH_TABLE_PER and span <= glyph_count_per[id] * 2
+    end
+
     local glyph_id_mask = GLYPH_TABLE_PER - 1
     -- preallocate room
     for id, char in pairs(chars) do
-        if not use_small_glyph(id >> GLYPH_TABLE_SHIFT) then
+        if not use_small_glyph(id >> GLYPH_TABLE_SHIFT) and not use_ranged_glyph(id >> GLYPH_TABLE_SHIFT) then
             local rom_data = rom_datas[id >> GLYPH_TABLE_SHIFT]
             for i=1,GLYPH_ENTRY_SIZE do
                 table.insert(rom_data,0)
@@ -258,6 +278,17 @@ local function build_font_entry_tables(height, tiny_font, fonts, x_offset_tbl, y
             for i=1,GLYPH_TABLE_PER*SMALL_GLYPH_ENTRY_SIZE do
                 table.insert(rom_data,0)
             end
+        elseif use_ranged_glyph(i >> GLYPH_TABLE_SHIFT) then
+            local page = i >> GLYPH_TABLE_SHIFT
+            local rom_data = rom_datas[page]
+            local span = glyph_last_per[page] - glyph_first_per[page] + 1
+            rom_data[1] = 0xFE
+            rom_data[2] = 0xFF
+            table.insert(rom_data, glyph_first_per[page])
+            table.insert(rom_data, span)
+            for i=1,span*SMALL_GLYPH_ENTRY_SIZE do
+                table.insert(rom_data,0)
+            end
         end
     end
 
@@ -282,7 +313,9 @@ local function build_font_entry_tables(height, tiny_font, fonts, x_offset_tbl, y
 
         local font_count = rom_data[1] + (rom_data[2] << 8)
         local header_pos
-        if not use_small_glyph(id >> GLYPH_TABLE_SHIFT) then
+        if use_ranged_glyph(id >> GLYPH_TABLE_SHIFT) then
+            header_pos = 5 + (((id & glyph_id_mask) - rom_data[3]) * SMALL_GLYPH_ENTRY_SIZE)
+        elseif not use_small_glyph(id >> GLYPH_TABLE_SHIFT) then
             header_pos = 4 + (font_count * GLYPH_ENTRY_SIZE)
             rom_data[header_pos - 1] = id & glyph_id_mask
 
@@ -310,7 +343,7 @@ local function write_font(filename, font_height, tables, offsets)
     local empty_pointer = string.char(0, 0, 0)
     local file <close> = io.open(filename, "wb")
     file:write(string.pack("<HHHHI3B",
-        0x6653, 0x0100, 12, max_codepoint, 0, font_height
+        0x6653, 0x0101, 12, max_codepoint, 0, font_height
     ))
     local pointers_fpos = file:seek()
     file:write(empty_pointer:rep(max_codepoint+1))
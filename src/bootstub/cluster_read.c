@@ -78,7 +78,7 @@ static uint32_t read_next_cluster(uint32_t cluster) {
     return result;
 }
 
-/* Cluster read code */
+/* Read state */
 
 static uint32_t current_cluster;
 static uint32_t current_sector;
@@ -93,10 +93,58 @@ static LBA_t clst2sect (	/* !=0:Sector number, 0:Failed (invalid cluster#) */
 	return bootstub_data->data_base + (LBA_t)bootstub_data->cluster_size * clst;	/* Start sector number of the cluster */
 }
 
+/* Extent map read code */
+
+static uint16_t current_extent;
+static uint32_t extent_sector;
+static uint32_t extent_sectors_left;
+
+static uint8_t extent_read(void __far* buff, uint16_t btr) {
+	UINT rcnt, cc;
+	BYTE __far* rbuff = (BYTE __far*)buff;
+
+	for ( ; btr > 0; btr -= rcnt, rbuff += rcnt, current_file_ptr += rcnt) {	/* Repeat until btr bytes read */
+		if ((current_file_ptr & 0x1FF) == 0) {			/* On the sector boundary? */
+			if (!extent_sectors_left) {			/* On the extent boundary? */
+				if (++current_extent >= bootstub_data->prog_extent_count) return FR_INT_ERR;
+				extent_sector = bootstub_extents[current_extent].sector;
+				extent_sectors_left = bootstub_extents[current_extent].length;
+			}
+			cc = btr >> 9;					/* When remaining bytes >= sector size, */
+			if (cc > 0) {						/* Read maximum contiguous sectors directly */
+				if (cc > extent_sectors_left) {	/* Clip at extent boundary */
+					cc = extent_sectors_left;
+				}
+				if (disk_read(0, rbuff, extent_sector, cc) != RES_OK) return FR_DISK_ERR;
+				extent_sector += cc;
+				extent_sectors_left -= cc;
+				rcnt = cc << 9;				/* Number of bytes transferred */
+				continue;
+			}
+			current_sector = extent_sector++;
+			extent_sectors_left--;
+		}
+		rcnt = 512 - (current_file_ptr & 0x1FF);	/* Number of bytes remains in the sector */
+		if (rcnt > btr) rcnt = btr;					/* Clip it by btr if needed */
+		if (move_window(current_sector) != FR_OK) return FR_DISK_ERR;	/* Move sector window */
+		_fmemcpy(rbuff, drive_window + (current_file_ptr & 0x1FF), rcnt);	/* Extract partial sector */
+	}
+
+	return FR_OK;
+}
+
+/* Cluster read code */
+
 void cluster_open(uint32_t cluster) {
     current_cluster = cluster;
 	current_sector = clst2sect(current_cluster);
     current_file_ptr = 0;
+
+	if (bootstub_data->prog_extent_count) {
+		current_extent = 0;
+		extent_sector = bootstub_extents[0].sector;
+		extent_sectors_left = bootstub_extents[0].length;
+	}
 }
 
 uint8_t cluster_read(void __far* buff, uint16_t btr) {
@@ -109,6 +157,9 @@ uint8_t cluster_read(void __far* buff, uint16_t btr) {
 	DWORD nextclst, prevclst;
 #endif
 
+	if (bootstub_data->prog_extent_count)
+		return extent_read(buff, btr);
+
 	for ( ; btr > 0; btr -= rcnt, rbuff += rcnt, current_file_ptr += rcnt) {	/* Repeat until btr bytes read */
 		if ((current_file_ptr & 0x1FF) == 0) {			/* On the sector boundary? */
 			csect = (UINT)((current_file_ptr >> 9) & (bootstub_data->cluster_size - 1));	/* Sector offset in the cluster */
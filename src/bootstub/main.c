@@ -233,6 +233,9 @@ int main(void) {
 			} else {
 				progress_init(0xFFFF, total_banks - start_bank);
 			}
+		} else if (bootstub_data->prog_resident == BOOTSTUB_RESIDENT_VALID) {
+			// The image is already present in PSRAM.
+			progress_init(0xFFFF, 0);
 		} else {
 			progress_init(0, (total_banks - start_bank) * 2 - (start_offset >= 0x8000 ? 1 : 0));
 
@@ -256,6 +259,17 @@ int main(void) {
 				offset = 0x0000;
 				bank++;
 			}
+
+			if (bootstub_data->prog_resident == BOOTSTUB_RESIDENT_RECORD) {
+				uint32_t checksum = bootstub_resident_checksum(start_bank, total_banks);
+				outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+				outportw(WS_CART_EXTBANK_RAM_PORT, NILE_SEG_RAM_IPC);
+				BOOTSTUB_RESIDENT_IMAGE->bank_first = start_bank;
+				BOOTSTUB_RESIDENT_IMAGE->bank_end = total_banks;
+				BOOTSTUB_RESIDENT_IMAGE->checksum = checksum;
+				BOOTSTUB_RESIDENT_IMAGE->magic = BOOTSTUB_RESIDENT_MAGIC;
+				outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
+			}
 		}
 	} else {
 	    outportw(WS_CART_EXTBANK_RAM_PORT, total_banks - 1);
@@ -17,6 +17,7 @@
 
 #include <ws.h>
 #include <nilefs.h>
+#include "fs.h"
 #include "lang.h"
 #include "ui/ui_dialog.h"
 
@@ -32,3 +33,83 @@ void fs_init(void) {
 bool fs_initialized(void) {
     return fs.fs_type != 0;
 }
+
+static uint8_t fs_move_window(LBA_t sector) {
+    if (sector != fs.winsect) {
+        // Never discard pending FatFs writes.
+        if (fs.wflag)
+            return FR_INT_ERR;
+        if (disk_read(fs.pdrv, fs.win, sector, 1) != RES_OK) {
+            fs.winsect = (LBA_t) -1;
+            return FR_DISK_ERR;
+        }
+        fs.winsect = sector;
+    }
+    return FR_OK;
+}
+
+LBA_t fs_cluster_to_sector(uint32_t cluster) {
+    if (!fs_is_valid_cluster(cluster))
+        return 0;
+    return fs.database + (LBA_t) fs.csize * (cluster - 2);
+}
+
+uint32_t fs_get_next_cluster(uint32_t cluster) {
+    uint16_t i;
+    if (!fs_is_valid_cluster(cluster))
+        return 1;
+    switch (fs.fs_type) {
+        case FS_FAT12: {
+            uint16_t bc = cluster;
+            bc += bc >> 1;
+            if (fs_move_window(fs.fatbase + (bc >> 9))) break;
+            i = fs.win[bc++ & 0x1FF];
+            if (fs_move_window(fs.fatbase + (bc >> 9))) break;
+            i |= fs.win[bc & 0x1FF] << 8;
+            return (cluster & 1) ? (i >> 4) : (i & 0xFFF);
+        }
+        case FS_FAT16: {
+            if (fs_move_window(fs.fatbase + (cluster >> 8))) break;
+            return ((uint16_t*) fs.win)[cluster & 0xFF];
+        }
+        case FS_FAT32: {
+            if (fs_move_window(fs.fatbase + (cluster >> 7))) break;
+            return ((uint32_t*) fs.win)[cluster & 0x7F] & 0x0FFFFFFF;
+        }
+    }
+    return FS_CLUSTER_ERROR;
+}
+
+const uint8_t *fs_read_sector(LBA_t sector) {
+    if (fs_move_window(sector))
+        return NULL;
+    return fs.win;
+}
+
+uint16_t fs_get_extents(uint32_t cluster, uint32_t size, volatile bootstub_extent_t *extents, uint16_t max_count) {
+    uint32_t clusters_left = (size + ((uint32_t) fs.csize << 9) - 1) / ((uint32_t) fs.csize << 9);
+    uint16_t count = 0;
+
+    while (clusters_left) {
+        if (!fs_is_valid_cluster(cluster) || count >= max_count)
+            return 0;
+
+        uint32_t length = 0;
+        uint32_t next_cluster = 0;
+        do {
+            length++;
+            if (!--clusters_left)
+                break;
+            next_cluster = fs_get_next_cluster(cluster + length - 1);
+            if (next_cluster == FS_CLUSTER_ERROR)
+                return 0;
+        } while (next_cluster == cluster + length);
+
+        extents[count].sector = fs_cluster_to_sector(cluster);
+        extents[count].length = length * fs.csize;
+        count++;
+        cluster = next_cluster;
+    }
+
+    return count;
+}
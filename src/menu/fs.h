@@ -20,8 +20,59 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <nilefs.h>
+#include "bootstub.h"
+
+extern FATFS fs;
+
+#define FS_CLUSTER_ERROR 0xFFFFFFFF
 
 void fs_init(void);
 bool fs_initialized(void);
 
+/**
+ * @brief Check if a cluster number points to a valid data cluster.
+ */
+static inline bool fs_is_valid_cluster(uint32_t cluster) {
+    return cluster >= 2 && cluster < fs.n_fatent;
+}
+
+/**
+ * @brief Convert a cluster number to its first sector.
+ *
+ * @return LBA_t Sector number, or 0 if the cluster is invalid.
+ */
+LBA_t fs_cluster_to_sector(uint32_t cluster);
+
+/**
+ * @brief Read the next cluster in a cluster chain from the FAT.
+ *
+ * This goes through the FatFs sector window, keeping it coherent with FatFs.
+ *
+ * @return uint32_t Next cluster; FS_CLUSTER_ERROR on I/O error.
+ * Any other value for which fs_is_valid_cluster() fails marks the end of the chain.
+ */
+uint32_t fs_get_next_cluster(uint32_t cluster);
+
+/**
+ * @brief Read a sector into the FatFs sector window.
+ *
+ * The returned data is only valid until the next FatFs call.
+ *
+ * @return const uint8_t* Sector data; NULL on I/O error, or if the window holds pending writes.
+ */
+const uint8_t *fs_read_sector(LBA_t sector);
+
+/**
+ * @brief Map a file's cluster chain to runs of contiguous sectors.
+ *
+ * @param cluster First cluster of the file.
+ * @param size File size, in bytes.
+ * @param extents Output extent list.
+ * @param max_count Maximum number of extents.
+ * @return uint16_t Number of extents; 0 on I/O error, on a broken chain,
+ * or if more than max_count extents are needed.
+ */
+uint16_t fs_get_extents(uint32_t cluster, uint32_t size, volatile bootstub_extent_t *extents, uint16_t max_count);
+
 #endif /* FS_H_ */
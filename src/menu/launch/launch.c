@@ -26,9 +26,11 @@
 #include "launch.h"
 #include "bootstub.h"
 #include "errors.h"
+#include "fs.h"
 #include "lang_gen.h"
 #include "cart/mcu.h"
 #include "launch/launch_athena.h"
+#include "launch/launch_eeprom.h"
 #include "settings.h"
 #include "strings.h"
 #include "../../build/menu/build/bootstub_bin.h"
@@ -42,8 +44,6 @@
 __attribute__((section(".iramCx_c000")))
 uint8_t sector_buffer[CONFIG_MEMLAYOUT_SECTOR_BUFFER_SIZE];
 
-extern FATFS fs;
-
 #define NILE_IPC_SAVE_ID ((volatile uint32_t __far*) MK_FP(0x1000, 512 - sizeof(uint32_t)))
 
 uint32_t launch_get_save_id(uint16_t target) {
@@ -99,9 +99,6 @@ static const uint16_t __far eeprom_sizes[] = {
     0, 128, 2048, 0, 0, 1024, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0
 };
-static const uint8_t __far eeprom_bits[] = {
-    0, 6, 10, 0, 0, 10
-};
 static const uint8_t __far eeprom_emu_control[] = {
     0, NILE_EMU_EEPROM_128B, NILE_EMU_EEPROM_2KB, 0, 0, NILE_EMU_EEPROM_1KB
 };
@@ -353,76 +350,6 @@ preallocate_file_end_no_dialog:
     return result;
 }
 
-#define MAX_WRITE_EEPROM_WORDS 64
-
-static int16_t launch_write_eeprom(FIL *fp, uint8_t *buffer, uint16_t words, bool verify) {
-    int16_t result = FR_OK;
-
-    for (uint16_t i = 0; i < words; i += MAX_WRITE_EEPROM_WORDS) {
-        int to_read = words > MAX_WRITE_EEPROM_WORDS ? MAX_WRITE_EEPROM_WORDS : words;
-        mcu_native_start();
-        if (nile_mcu_native_eeprom_read_sync(buffer, i, to_read) < (to_read * 2)) {
-            result = ERR_MCU_COMM_FAILED;
-            break;
-        }
-
-        nile_spi_set_control(NILE_SPI_CLOCK_FAST | NILE_SPI_DEV_TF);
-        result = f_write(fp, buffer, to_read << 1, NULL);
-        if (result != FR_OK)
-            break;
-    }
-
-    if (verify) {
-        uint8_t *cmp_buffer = buffer + (MAX_WRITE_EEPROM_WORDS * 2);
-        f_rewind(fp);
-        for (uint16_t i = 0; i < words; i += MAX_WRITE_EEPROM_WORDS) {
-            int to_read = words > MAX_WRITE_EEPROM_WORDS ? MAX_WRITE_EEPROM_WORDS : words;
-            mcu_native_start();
-            if (nile_mcu_native_eeprom_read_sync(buffer, i, to_read) < (to_read * 2)) {
-                result = ERR_MCU_COMM_FAILED;
-                break;
-            }
-
-            nile_spi_set_control(NILE_SPI_CLOCK_FAST | NILE_SPI_DEV_TF);
-            result = f_read(fp, cmp_buffer, to_read << 1, NULL);
-            if (result != FR_OK)
-                break;
-
-            if (_fmemcmp(buffer, cmp_buffer, MAX_WRITE_EEPROM_WORDS * 2))
-                return ERR_SAVE_VERIFY_FAILED;
-        }
-    }
-
-    return result;
-}
-
-static int16_t launch_read_eeprom(FIL *fp, uint8_t mode, uint16_t words) {
-    uint16_t w;
-    unsigned int br;
-    int16_t result;
-
-    ws_eeprom_handle_t h = ws_eeprom_handle_cartridge(eeprom_bits[mode]);
-    outportb(IO_NILE_EMU_CNT, eeprom_emu_control[mode]);
-
-    nile_spi_set_control(NILE_SPI_CLOCK_CART | NILE_SPI_DEV_NONE);
-    ws_eeprom_write_unlock(h);
-    for (uint16_t i = 0; i < words; i++) {
-         nile_spi_set_control(NILE_SPI_CLOCK_FAST | NILE_SPI_DEV_TF);
-         result = f_read(fp, &w, 2, &br);
-         if (result != FR_OK)
-             break;
-         nile_spi_set_control(NILE_SPI_CLOCK_CART | NILE_SPI_DEV_NONE);
-         if (!ws_eeprom_write_word(h, i << 1, w)) {
-             result = ERR_MCU_COMM_FAILED;
-             break;
-         }
-    }
-    nile_spi_set_control(NILE_SPI_CLOCK_CART | NILE_SPI_DEV_NONE);
-    ws_eeprom_write_lock(h);
-
-    return result;
-}
-
 static void launch_backup_progress_update(ui_popup_dialog_config_t *dlg, uint32_t step, uint32_t max) {
     if (!step) {
         ui_popup_dialog_clear_progress(dlg);
@@ -512,7 +439,7 @@ int16_t launch_backup_save_data(void) {
                 ui_popup_dialog_clear_progress(&dlg);
                 if (file_type == SAVE_ID_FOR_SRAM) {
                     outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
-                    result = f_write_sram_banked(&save_fp, 0, f_size(&save_fp), (fbanked_progress_callback_t) launch_backup_progress_update, &dlg, verify);
+                    result = f_write_banked_blocks(&save_fp, 0, f_size(&save_fp), false, (fbanked_progress_callback_t) launch_backup_progress_update, &dlg, verify);
                 } else if (file_type == SAVE_ID_FOR_EEPROM) {
                     result = launch_write_eeprom(&save_fp, (uint8_t*) buffer, value_num >> 1, verify);
                 } else if (file_type == SAVE_ID_FOR_FLASH) {
@@ -525,7 +452,7 @@ int16_t launch_backup_save_data(void) {
                     // FIXME: This skips the ROM footer to avoid losing the original entrypoint
                     // for runtime patches, which is not ideal.
                     if (((uint8_t) buffer[0]) == 0xEA && ((uint8_t) buffer[4]) >= 0x10) {
-                        result = f_write_rom_banked(&save_fp, 0, f_size(&save_fp) - 16, (fbanked_progress_callback_t) launch_backup_progress_update, &dlg, verify);
+                        result = f_write_banked_blocks(&save_fp, 0, f_size(&save_fp) - 16, true, (fbanked_progress_callback_t) launch_backup_progress_update, &dlg, verify);
                     } else {
                         result = ERR_SAVE_PSRAM_CORRUPT;
                     }
@@ -607,17 +534,18 @@ int16_t launch_restore_save_data(char *path, const launch_rom_metadata_t *meta)
             goto launch_restore_save_data_return_result;
         }
 
-        // switch MCU to EEPROM mode
-        if (!mcu_native_set_mode(1)) {
-            result = ERR_MCU_COMM_FAILED;
+        // copy data to EEPROM, while the MCU still accepts native commands
+        result = launch_read_eeprom(&fp, f_size(&fp) >> 1);
+        if (result != FR_OK) {
+            f_close(&fp);
             goto launch_restore_save_data_return_result;
         }
 
-        // copy data to EEPROM
-        result = launch_read_eeprom(&fp, meta->footer.save_type >> 4,
-            f_size(&fp) >> 1);
-        if (result != FR_OK) {
+        // switch MCU to EEPROM mode
+        mcu_native_start();
+        if (!mcu_native_set_mode(1)) {
             f_close(&fp);
+            result = ERR_MCU_COMM_FAILED;
             goto launch_restore_save_data_return_result;
         }
 
@@ -764,9 +692,67 @@ int16_t launch_set_bootstub_file_entry(const char *path, bootstub_file_entry_t *
     }
     entry->cluster = fp.fclust;
     entry->size = fp.fsize;
+    entry->mtime = ((uint32_t) fp.fdate << 16) | fp.ftime;
     return FR_OK;
 }
 
+// Build a map of the program file's sectors, so that the bootstub does not
+// have to walk the FAT. On failure, the bootstub falls back to doing so.
+static void launch_build_bootstub_extents(void) {
+    bootstub_data->prog_extent_count = 0;
+    if (bootstub_data->prog.cluster == BOOTSTUB_CLUSTER_AT_PSRAM)
+        return;
+
+    bootstub_data->prog_extent_count = fs_get_extents(bootstub_data->prog.cluster, bootstub_data->prog.size,
+        bootstub_extents, BOOTSTUB_EXTENTS_MAX);
+}
+
+// Check if the program image is still present in PSRAM from a previous launch.
+// If not, ask the bootstub to record a fingerprint of it after loading.
+static void launch_check_resident_image(bool allowed) {
+    volatile bootstub_resident_image_t __far *image = BOOTSTUB_RESIDENT_IMAGE;
+    uint8_t prev_cart_flash = inportb(WS_CART_BANK_FLASH_PORT);
+    uint16_t prev_sram_bank = inportw(WS_CART_EXTBANK_RAM_PORT);
+    uint32_t cluster = bootstub_data->prog.cluster;
+
+    allowed &= cluster != 0 && cluster != BOOTSTUB_CLUSTER_AT_PSRAM;
+    bootstub_data->prog_resident = BOOTSTUB_RESIDENT_NONE;
+
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    outportw(WS_CART_EXTBANK_RAM_PORT, NILE_SEG_RAM_IPC);
+    if (allowed
+        && image->magic == BOOTSTUB_RESIDENT_MAGIC
+        && image->cluster == cluster
+        && image->size == bootstub_data->prog.size
+        && image->mtime == bootstub_data->prog.mtime
+        && image->rom_banks == bootstub_data->rom_banks) {
+
+        uint16_t bank_first = image->bank_first;
+        uint16_t bank_end = image->bank_end;
+        uint32_t checksum = image->checksum;
+        outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
+        if (bootstub_resident_checksum(bank_first, bank_end) == checksum)
+            bootstub_data->prog_resident = BOOTSTUB_RESIDENT_VALID;
+        outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+        outportw(WS_CART_EXTBANK_RAM_PORT, NILE_SEG_RAM_IPC);
+    }
+
+    if (bootstub_data->prog_resident != BOOTSTUB_RESIDENT_VALID) {
+        // PSRAM contents are about to be replaced.
+        image->magic = 0;
+        if (allowed) {
+            image->cluster = cluster;
+            image->size = bootstub_data->prog.size;
+            image->mtime = bootstub_data->prog.mtime;
+            image->rom_banks = bootstub_data->rom_banks;
+            bootstub_data->prog_resident = BOOTSTUB_RESIDENT_RECORD;
+        }
+    }
+
+    outportw(WS_CART_EXTBANK_RAM_PORT, prev_sram_bank);
+    outportb(WS_CART_BANK_FLASH_PORT, prev_cart_flash);
+}
+
 __attribute__((noreturn))
 extern void launch_jump_to_bootstub(uint16_t size, uint16_t flags);
 
@@ -781,6 +767,9 @@ int16_t launch_rom_via_bootstub(const launch_rom_metadata_t *meta) {
 
     ui_hide();
 
+    // The extent map overwrites UI tile memory
+    launch_build_bootstub_extents();
+
     // Disable IRQs - avoid other code interfering/overwriting memory
     ia16_disable_irq();
 
@@ -821,6 +810,10 @@ int16_t launch_rom_via_bootstub(const launch_rom_metadata_t *meta) {
         bootstub_data->start_pointer = MK_FP(0xFFFF, 0x0000);
     }
 
+    // Images which are modified after loading, by patches or by flash
+    // save emulation, are always reloaded.
+    launch_check_resident_image(meta != NULL && !meta->flash_size && !bootstub_data->prog_patches);
+
     // Lock IEEPROM
     if (meta != NULL && !(meta->footer.game_version & 0x80)) {
         outportw(WS_IEEP_CTRL_PORT, WS_IEEP_CTRL_PROTECT);
@@ -22,6 +22,7 @@
 #include <nile.h>
 #include <nilefs.h>
 #include "cart/mcu.h"
+#include "bootstub.h"
 #include "errors.h"
 #include "lang.h"
 #include "settings.h"
@@ -108,6 +109,7 @@ int16_t launch_athena_begin(const char __far *bios_path, const char __far *os_pa
     unsigned int br;
     int16_t result;
 
+    bootstub_resident_invalidate(0, 0x100);
     ws_bank_with_flash(WS_CART_BANK_FLASH_ENABLE, {
         strcpy(buffer, bios_path);
         result = f_open(&fp, buffer, FA_OPEN_EXISTING | FA_READ);
@@ -286,6 +288,7 @@ int16_t launch_athena_jump(void) {
 }
 
 int16_t launch_athena_romfile_begin(void) {
+    bootstub_resident_invalidate(0, 0x100);
     ws_bank_with_flash(WS_CART_BANK_FLASH_ENABLE, {
         ws_bank_with_ram(ATHENA_OS_FOOTER_BANK, {
             ATHENA_OS_FOOTER.magic = 0x5AA5;
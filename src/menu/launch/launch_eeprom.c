@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2024, 2025, 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <ws.h>
+#include <nile.h>
+#include <nilefs.h>
+#include "launch_eeprom.h"
+#include "config.h"
+#include "errors.h"
+#include "cart/mcu.h"
+#include "util/file.h"
+
+// Read EEPROM contents in blocks as large as the available buffer allows,
+// only switching between the MCU and the TF card once per block.
+int16_t launch_write_eeprom(FIL *fp, uint8_t *buffer, uint16_t words, bool verify) {
+    int16_t result = FR_OK;
+    uint16_t block_words = MAX_WRITE_EEPROM_WORDS;
+    uint8_t *cmp_buffer = buffer + (MAX_WRITE_EEPROM_WORDS * 2);
+
+    if (sector_buffer_is_active()) {
+        // Use one half of the sector buffer for reads, the other for verification.
+        buffer = sector_buffer;
+        block_words = sizeof(sector_buffer) >> 2;
+        cmp_buffer = sector_buffer + (sizeof(sector_buffer) >> 1);
+    }
+
+    for (uint8_t pass = 0; pass < (verify ? 2 : 1); pass++) {
+        if (pass)
+            f_rewind(fp);
+
+        for (uint16_t i = 0; i < words; i += block_words) {
+            uint16_t to_read = words - i > block_words ? block_words : words - i;
+
+            mcu_native_start();
+            for (uint16_t j = 0; j < to_read; j += MAX_WRITE_EEPROM_WORDS) {
+                uint16_t to_read_cmd = to_read - j > MAX_WRITE_EEPROM_WORDS ? MAX_WRITE_EEPROM_WORDS : to_read - j;
+                if (nile_mcu_native_eeprom_read_sync(buffer + (j << 1), i + j, to_read_cmd) < (to_read_cmd * 2))
+                    return ERR_MCU_COMM_FAILED;
+            }
+
+            nile_spi_set_control(NILE_SPI_CLOCK_FAST | NILE_SPI_DEV_TF);
+            if (!pass) {
+                result = f_write(fp, buffer, to_read << 1, NULL);
+                if (result != FR_OK)
+                    return result;
+            } else {
+                result = f_read(fp, cmp_buffer, to_read << 1, NULL);
+                if (result != FR_OK)
+                    return result;
+
+                if (memcmp(buffer, cmp_buffer, to_read << 1))
+                    return ERR_SAVE_VERIFY_FAILED;
+            }
+        }
+    }
+
+    return result;
+}
+
+// Write file contents to EEPROM, reading the file in blocks as large as
+// the available buffer allows. The words are sent with the same native
+// MCU command batching as launch_write_eeprom(), rather than one
+// cartridge EEPROM bus write at a time.
+int16_t launch_read_eeprom(FIL *fp, uint16_t words) {
+    uint8_t stack_buffer[CONFIG_MEMLAYOUT_STACK_BUFFER_SIZE];
+    uint8_t *buffer;
+    uint16_t block_words;
+    unsigned int br;
+    int16_t result = FR_OK;
+
+    if (sector_buffer_is_active()) {
+        buffer = sector_buffer;
+        block_words = sizeof(sector_buffer) >> 1;
+    } else {
+        buffer = stack_buffer;
+        block_words = sizeof(stack_buffer) >> 1;
+    }
+
+    for (uint16_t i = 0; i < words; i += block_words) {
+        uint16_t to_write = words - i > block_words ? block_words : words - i;
+
+        nile_spi_set_control(NILE_SPI_CLOCK_FAST | NILE_SPI_DEV_TF);
+        result = f_read(fp, buffer, to_write << 1, &br);
+        if (result != FR_OK)
+            return result;
+
+        mcu_native_start();
+        for (uint16_t j = 0; j < to_write; j += MAX_WRITE_EEPROM_WORDS) {
+            uint16_t to_write_cmd = to_write - j > MAX_WRITE_EEPROM_WORDS ? MAX_WRITE_EEPROM_WORDS : to_write - j;
+            if (nile_mcu_native_eeprom_write_sync(buffer + (j << 1), i + j, to_write_cmd) < 0)
+                return ERR_MCU_COMM_FAILED;
+        }
+    }
+
+    return result;
+}
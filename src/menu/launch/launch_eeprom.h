@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2024, 2025, 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAUNCH_EEPROM_H_
+#define LAUNCH_EEPROM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <nilefs.h>
+
+// Maximum number of words transferred by a single MCU EEPROM command.
+#define MAX_WRITE_EEPROM_WORDS 64
+
+/**
+ * @brief Write the MCU's emulated EEPROM contents to a file.
+ *
+ * The MCU must be in native mode.
+ *
+ * @param fp File to write to, positioned at the start.
+ * @param buffer Scratch buffer of at least MAX_WRITE_EEPROM_WORDS * 4 bytes,
+ * used if the sector buffer is not available.
+ * @param words Number of words to transfer.
+ * @param verify Read the file back and compare it with the EEPROM contents.
+ * @return int16_t Error code, if any.
+ */
+int16_t launch_write_eeprom(FIL *fp, uint8_t *buffer, uint16_t words, bool verify);
+
+/**
+ * @brief Write file contents to the MCU's emulated EEPROM.
+ *
+ * The MCU must be in native mode, with the EEPROM type already configured.
+ *
+ * @param fp File to read from.
+ * @param words Number of words to transfer.
+ * @return int16_t Error code, if any.
+ */
+int16_t launch_read_eeprom(FIL *fp, uint16_t words);
+
+#endif /* LAUNCH_EEPROM_H_ */
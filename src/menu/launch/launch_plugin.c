@@ -24,8 +24,10 @@
 #include "errors.h"
 #include "launch.h"
 
+_Static_assert(BOOTSTUB_IPC_PATH_MAX > FF_LFN_BUF + 1, "IPC path area too small");
+
 int16_t launch_plugin_via_ipc(const char __far *plugin_path, const char *filename) {
-    char filepath[0x400 - 0xE0 + 1];
+    char filepath[BOOTSTUB_IPC_PATH_MAX];
     int filepath_pos;
     filepath[sizeof(filepath) - 1] = 0;
 
@@ -42,7 +44,7 @@ int16_t launch_plugin_via_ipc(const char __far *plugin_path, const char *filenam
 
     // Configure IPC area
     ws_bank_with_ram(NILE_SEG_RAM_IPC, {
-        strcpy(MK_FP(0x1000, 0x00E0), filepath);
+        strcpy(MK_FP(0x1000, BOOTSTUB_IPC_PATH_OFFSET), filepath);
     });
 
     // Load plugin as ROM
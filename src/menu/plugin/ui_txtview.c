@@ -18,6 +18,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <ws.h>
 #include <nilefs.h>
 #include <ws/display.h>
@@ -25,8 +26,10 @@
 #include "errors.h"
 #include "lang.h"
 #include "../ui/ui.h"
+#include "../ui/ui_osk.h"
 #include "../util/file.h"
 #include "../util/input.h"
+#include "../util/search.h"
 #include "main.h"
 #include "plugin.h"
 #include "settings.h"
@@ -41,6 +44,35 @@ typedef enum {
     TXT_ENCODING_UNKNOWN
 } txt_encoding_t;
 
+// Banks of PSRAM used as a window into the file; must be a power of two.
+#define TXTVIEW_RING_BANKS 4
+#define TXTVIEW_TBL_BANK TXTVIEW_RING_BANKS
+#define TXTVIEW_NO_BANK 0xFFFF
+// Maximum number of text rows on one screen.
+#define TXTVIEW_MAX_ROWS 32
+// Initial minimum distance between two line index entries, in bytes.
+#define TXTVIEW_INDEX_SPACING_MIN 1024
+// Maximum distance to look back for a line start when resynchronizing.
+#define TXTVIEW_RESYNC_LIMIT 4096
+#define SJIS_TBL_ENTRIES ((0x1F + 0x10) * (0xFD - 0x40))
+
+typedef struct {
+    FIL fp;
+    uint32_t size;
+    int16_t result;
+    uint8_t encoding;
+    uint8_t rows;
+    uint8_t font_height;
+    uint8_t y;
+    // File bank held by each ring slot.
+    uint16_t ring_bank[TXTVIEW_RING_BANKS];
+    // Sparse index of known row starts, in ascending order; index[0] is
+    // always the start of the file.
+    uint8_t index_count;
+    uint32_t index_spacing;
+    uint32_t index[CONFIG_TXTVIEW_INDEX_SIZE];
+} txtview_t;
+
 #define IS_UTF8_CONT_BYTE(c) ((c) >= 0x80 && (c) < 0xC0)
 
 #define DETECT_ENCODING_SIZE_LIMIT (8*1024)
@@ -141,114 +173,401 @@ static uint32_t sjis_decode_next(const char __far** s, uint16_t tbl_bank) {
     }
 }
 
+// Inverse of sjis_decode_next(); returns 0 if the character has no mapping.
+static uint16_t sjis_encode(uint32_t ch, uint16_t tbl_bank) {
+    if (ch < 0x7E) {
+        return ch;
+    } else if (ch == 0x203E) {
+        return 0x7E;
+    } else if (ch >= 0xFF60 && ch < 0xFFA0) {
+        return 0xA0 + (ch - 0xFF60);
+    }
+    ws_bank_rom1_set(tbl_bank);
+    const uint16_t __far *tbl = MK_FP(0x3000, 0);
+    for (uint16_t i = 0; i < SJIS_TBL_ENTRIES; i++) {
+        if (tbl[i] == ch) {
+            uint8_t row = i / (0xFD - 0x40);
+            uint8_t chl = (i % (0xFD - 0x40)) + 0x40;
+            return ((row >= 0x1F ? (row - 0x1F + 0xE0) : (row + 0x81)) << 8) | chl;
+        }
+    }
+    return 0;
+}
+
+static void txtview_load_bank(txtview_t *t, uint16_t bank) {
+    uint8_t slot = bank & (TXTVIEW_RING_BANKS - 1);
+    uint32_t pos = ((uint32_t) bank) << 16;
+    if (t->ring_bank[slot] == bank || pos >= t->size) return;
+
+    int16_t result = f_lseek(&t->fp, pos);
+    if (result == FR_OK) {
+        uint32_t len = t->size - pos;
+        if (len > 0x10000) len = 0x10000;
+        result = f_read_rom_banked(&t->fp, slot, len, NULL, NULL);
+    }
+    if (result != FR_OK) {
+        t->result = result;
+        t->ring_bank[slot] = TXTVIEW_NO_BANK;
+        return;
+    }
+    t->ring_bank[slot] = bank;
+}
+
+// Map a file position into the ROM0 window, loading it from the file if
+// necessary. The following bank is mapped into ROM1 for characters which
+// cross a bank boundary.
+static const char __far *txtview_map(txtview_t *t, uint32_t pos) {
+    uint16_t bank = pos >> 16;
+    txtview_load_bank(t, bank);
+    if ((pos & 0xFFFF) >= 0xFFF0)
+        txtview_load_bank(t, bank + 1);
+    ws_bank_rom0_set(bank & (TXTVIEW_RING_BANKS - 1));
+    ws_bank_rom1_set((bank + 1) & (TXTVIEW_RING_BANKS - 1));
+    return MK_FP(0x2000 | ((pos >> 4) & 0xFFF), pos & 0xF);
+}
+
+static void txtview_index_add(txtview_t *t, uint32_t pos) {
+    uint8_t i = t->index_count;
+    while (i > 0 && t->index[i - 1] > pos) i--;
+    if (i > 0 && pos - t->index[i - 1] < t->index_spacing) return;
+    if (i < t->index_count && t->index[i] - pos < t->index_spacing) return;
+
+    if (t->index_count >= CONFIG_TXTVIEW_INDEX_SIZE) {
+        // Keep every other entry and double the spacing.
+        t->index_count = (t->index_count + 1) >> 1;
+        for (uint8_t j = 1; j < t->index_count; j++)
+            t->index[j] = t->index[j << 1];
+        t->index_spacing <<= 1;
+        txtview_index_add(t, pos);
+        return;
+    }
+
+    memmove(t->index + i + 1, t->index + i, (t->index_count - i) * sizeof(uint32_t));
+    t->index[i] = pos;
+    t->index_count++;
+}
+
+// Lay out one row of text starting at pos, drawing it at y if requested.
+// Returns the start of the next row.
+static uint32_t txtview_row(txtview_t *t, uint32_t pos, uint16_t y, bool draw) {
+    uint16_t x = 1;
+    while (pos < t->size) {
+        const char __far *ptr = txtview_map(t, pos);
+        uint32_t ch;
+        if (t->encoding == TXT_ENCODING_SJIS) {
+            ch = sjis_decode_next(&ptr, TXTVIEW_TBL_BANK);
+        } else {
+            ch = wsx_utf8_decode_next(&ptr);
+        }
+        uint32_t next_pos = (pos & ~0xF) + FP_OFF(ptr);
+
+        if (ch < 0x20) {
+            pos = next_pos;
+            if (ch == '\n') {
+                break;
+            } else if (ch == '\t') {
+                x = (x + 0x11) & ~0xF;
+            }
+            continue;
+        }
+        uint16_t chw = bitmapfont_get_char_width(ch);
+        if ((x + chw) >= screen_width && x > 1) {
+            break;
+        }
+        if (draw)
+            bitmapfont_draw_char(&ui_bitmap, x, y, ch);
+        x += chw;
+        pos = next_pos;
+    }
+    return pos;
+}
+
+// Draw rows from the given row onwards; row_pos[from] must be set.
+static void txtview_draw_rows(txtview_t *t, uint32_t *row_pos, uint8_t from) {
+    for (uint8_t i = from; i < t->rows; i++) {
+        row_pos[i + 1] = txtview_row(t, row_pos[i], t->y + i * t->font_height, true);
+    }
+}
+
+// Find the closest line start in (limit, pos]; returns 0 if there is none.
+static uint32_t txtview_line_start(txtview_t *t, uint32_t pos, uint32_t limit) {
+    for (; pos > limit; pos--) {
+        if (*txtview_map(t, pos - 1) == '\n')
+            return pos;
+    }
+    return 0;
+}
+
+// Find the closest known row start before pos: either an index entry, or
+// a nearby line start.
+static uint32_t txtview_anchor_before(txtview_t *t, uint32_t pos) {
+    uint8_t i = t->index_count;
+    while (i > 1 && t->index[i - 1] >= pos) i--;
+    uint32_t anchor = t->index[i - 1];
+
+    if (pos - anchor > 1) {
+        uint32_t limit = (pos - 1 - anchor) > TXTVIEW_RESYNC_LIMIT ? (pos - 1 - TXTVIEW_RESYNC_LIMIT) : anchor;
+        uint32_t line = txtview_line_start(t, pos - 1, limit);
+        if (line > anchor)
+            anchor = line;
+    }
+    return anchor;
+}
+
+// Find the first character boundary at or after pos.
+static uint32_t txtview_char_start(txtview_t *t, uint32_t pos) {
+    if (t->encoding != TXT_ENCODING_SJIS) {
+        while (pos < t->size && IS_UTF8_CONT_BYTE(*txtview_map(t, pos))) pos++;
+    }
+    return pos;
+}
+
+// Find the start of the row n rows before the row starting at pos.
+static uint32_t txtview_rows_back(txtview_t *t, uint32_t pos, uint8_t n) {
+    uint32_t rows[TXTVIEW_MAX_ROWS];
+    uint32_t end = pos;
+
+    while (end > 0) {
+        uint32_t anchor = txtview_anchor_before(t, end);
+        if (pos - anchor > TXTVIEW_RESYNC_LIMIT) {
+            // No line start or index entry nearby; lay out from the next
+            // character within the limit instead, as txtview_seek() does.
+            anchor = txtview_char_start(t, pos - TXTVIEW_RESYNC_LIMIT);
+            if (anchor >= end)
+                return end;
+        }
+        uint32_t row = anchor;
+        uint16_t count = 0;
+        while (row < pos) {
+            rows[count % n] = row;
+            count++;
+            row = txtview_row(t, row, 0, false);
+        }
+        if (count >= n)
+            return rows[count % n];
+        if (pos - anchor >= TXTVIEW_RESYNC_LIMIT)
+            return anchor;
+        end = anchor;
+    }
+    return 0;
+}
+
+// Find the start of the row containing pos.
+static uint32_t txtview_seek(txtview_t *t, uint32_t pos) {
+    uint32_t row = txtview_anchor_before(t, pos + 1);
+    if (pos - row > TXTVIEW_RESYNC_LIMIT) {
+        // No line start nearby; start at the next character instead.
+        return txtview_char_start(t, pos);
+    }
+    while (true) {
+        uint32_t next = txtview_row(t, row, 0, false);
+        if (next > pos || next >= t->size)
+            return row;
+        row = next;
+    }
+}
+
+// Convert a UTF-8 query to the file's encoding and build its skip table.
+static bool txtview_search_init(txtview_t *t, search_t *s, const char *query) {
+    const char __far *q = query;
+    s->len = 0;
+    s->fold = t->encoding != TXT_ENCODING_SJIS;
+    if (t->encoding == TXT_ENCODING_SJIS) {
+        uint32_t ch;
+        while ((ch = wsx_utf8_decode_next(&q)) != 0) {
+            uint16_t sjis = sjis_encode(ch, TXTVIEW_TBL_BANK);
+            if (!sjis || (s->len + 2) > SEARCH_PATTERN_MAX) return false;
+            if (sjis >= 0x100)
+                s->pattern[s->len++] = sjis >> 8;
+            s->pattern[s->len++] = sjis;
+        }
+    } else {
+        while (*q && s->len < SEARCH_PATTERN_MAX) {
+            s->pattern[s->len++] = *(q++);
+        }
+    }
+    return search_init(s);
+}
+
+// Search for the pattern from pos onwards, one file bank at a time.
+// Returns the position of the match, or the file size if there is none.
+static uint32_t txtview_search(txtview_t *t, const search_t *s, uint32_t pos) {
+    uint8_t edge[(SEARCH_PATTERN_MAX - 1) * 2];
+    uint8_t m1 = s->len - 1;
+
+    while ((pos + s->len) <= t->size) {
+        uint32_t bank_pos = pos & ~0xFFFFUL;
+        uint32_t next_bank_pos = bank_pos + 0x10000;
+        uint16_t last = (t->size - 1 - bank_pos) > 0xFFFF ? 0xFFFF : (t->size - 1 - bank_pos);
+        uint16_t offset;
+
+        txtview_map(t, pos);
+        if (t->result != FR_OK) break;
+        if (search_block(s, MK_FP(0x2000, 0), pos & 0xFFFF, last, &offset))
+            return bank_pos + offset;
+
+        if (next_bank_pos >= t->size) break;
+
+        // Matches crossing into the next bank.
+        if (m1) {
+            uint32_t edge_pos = next_bank_pos - m1;
+            if (edge_pos < pos) edge_pos = pos;
+            uint8_t edge_len = 0;
+            while (edge_len < sizeof(edge) && (edge_pos + edge_len) < t->size && (edge_pos + edge_len) < (next_bank_pos + m1)) {
+                edge[edge_len] = *txtview_map(t, edge_pos + edge_len);
+                edge_len++;
+            }
+            if (t->result != FR_OK) break;
+            if (edge_len && search_block(s, edge, 0, edge_len - 1, &offset))
+                return edge_pos + offset;
+        }
+
+        pos = next_bank_pos;
+        input_update();
+        if (input_pressed & WS_KEY_B) break;
+    }
+    return t->size;
+}
+
+// Check whether pos is at a character boundary, decoding from the known
+// boundary *row. *row is left at the last boundary at or before pos.
+static bool txtview_is_char_start(txtview_t *t, uint32_t *row, uint32_t pos) {
+    uint32_t next = *row;
+    while (next < pos) {
+        *row = next;
+        const char __far *ptr = txtview_map(t, next);
+        sjis_decode_next(&ptr, TXTVIEW_TBL_BANK);
+        next = (next & ~0xF) + FP_OFF(ptr);
+    }
+    if (next != pos)
+        return false;
+    *row = pos;
+    return true;
+}
+
+// Ask for a query and find its next occurrence from pos onwards. Returns
+// the position of the match, or the file size if there is none.
+__attribute__((noinline))
+static uint32_t txtview_find(txtview_t *t, char *query, uint16_t query_len, uint32_t pos) {
+    search_t s;
+    ui_osk_state_t osk = {0};
+    osk.buffer = query;
+    osk.buflen = query_len;
+
+    ui_layout_bars();
+    ui_draw_titlebar(lang_keys[LK_UI_TXTVIEW_SEARCH]);
+    ui_draw_statusbar(NULL);
+    ui_osk(&osk);
+
+    ui_layout_bars();
+    ui_draw_statusbar(lang_keys[LK_UI_STATUS_SEARCHING]);
+    if (!txtview_search_init(t, &s, query)) return t->size;
+
+    // A known character boundary at or before the current match.
+    uint32_t row = 0;
+    while (true) {
+        pos = txtview_search(t, &s, pos);
+        if (pos >= t->size || t->encoding != TXT_ENCODING_SJIS)
+            return pos;
+        // Shift-JIS trail bytes can also be lead bytes; skip matches which
+        // do not start at a character boundary. Line starts are always
+        // boundaries; without one, decode on from the previous match, or
+        // from the start of the file.
+        uint32_t line = txtview_line_start(t, pos, row);
+        if (line > row)
+            row = line;
+        if (txtview_is_char_start(t, &row, pos))
+            return pos;
+        pos++;
+    }
+}
+
 int ui_txtview(const char *path) {
-    FIL fp;
+    txtview_t t;
+    uint32_t row_pos[TXTVIEW_MAX_ROWS + 1];
     char buf[64];
+    char query[SEARCH_PATTERN_MAX + 1];
 
     ui_layout_bars();
 
-    int16_t result = f_open(&fp, path, FA_READ);
+    if (asset_heap_get_free_first_banks() < TXTVIEW_RING_BANKS + 1) {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    int16_t result = f_open(&t.fp, path, FA_READ);
     if (result != FR_OK) return result;
 
     ui_draw_titlebar_filename(path);
     ui_draw_statusbar(lang_keys[LK_UI_STATUS_LOADING]);
 
-    uint32_t size = f_size(&fp);
-    if ((size >> 16) > asset_heap_get_free_first_banks()) {
-        return ERR_FILE_TOO_LARGE;
-    }
-
-    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
-    result = f_read_rom_banked(&fp, 0, size, NULL, NULL);
-    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    t.size = f_size(&t.fp);
+    t.result = FR_OK;
+    memset(t.ring_bank, 0xFF, sizeof(t.ring_bank));
+    t.index[0] = 0;
+    t.index_count = 1;
+    t.index_spacing = TXTVIEW_INDEX_SPACING_MIN;
 
-    f_close(&fp);
-    if (result != FR_OK) return result;
+    txtview_map(&t, 0);
+    if (t.result != FR_OK) goto ui_txtview_end;
 
-    txt_encoding_t encoding = detect_encoding(size);
-    uint16_t tbl_bank = (size + 65535) >> 16;
-    if (encoding == TXT_ENCODING_SJIS) {
+    t.encoding = detect_encoding(t.size);
+    if (t.encoding == TXT_ENCODING_SJIS) {
+        FIL tbl_fp;
         strcpy(buf, s_path_tbl_shiftjis);
-        result = f_open(&fp, buf, FA_READ);
-        if (result != FR_OK) return result;
-        result = f_read_rom_banked(&fp, tbl_bank, f_size(&fp), NULL, NULL);
-        f_close(&fp);
-        if (result != FR_OK) return result;
+        t.result = f_open(&tbl_fp, buf, FA_READ);
+        if (t.result != FR_OK) goto ui_txtview_end;
+        t.result = f_read_rom_banked(&tbl_fp, TXTVIEW_TBL_BANK, f_size(&tbl_fp), NULL, NULL);
+        f_close(&tbl_fp);
+        if (t.result != FR_OK) goto ui_txtview_end;
     }
 
     ui_draw_statusbar(NULL);
 
+    bitmapfont_set_active_font((settings.file_flags & SETTING_FILE_TEXT_READER_SMALL) ? font8_bitmap : font16_bitmap);
+    t.font_height = bitmapfont_get_font_height();
+    t.y = 8 + (t.font_height > 12 ? 1 : 0);
+    t.rows = (screen_height - 8 - t.y + t.font_height - 1) / t.font_height;
+    if (t.rows > TXTVIEW_MAX_ROWS) t.rows = TXTVIEW_MAX_ROWS;
+
     uint32_t file_start_pos = 0;
-    uint32_t file_next_pos = 0;
-    uint32_t file_last_end_pos = 0;
+    uint32_t last_match_pos = t.size;
+    uint8_t redraw_from = 0;
     bool reader_open = true;
-    bool reader_redraw = true;
+    const char __far *status = NULL;
+    query[0] = 0;
 
     while (reader_open) {
-        if (reader_redraw) {
+        if (redraw_from == 0) {
             ui_layout_bars();
-            reader_redraw = false;
-            file_last_end_pos = 0;
+            row_pos[0] = file_start_pos;
         }
 
         // Display text
         bitmapfont_set_active_font((settings.file_flags & SETTING_FILE_TEXT_READER_SMALL) ? font8_bitmap : font16_bitmap);
-        int font_height = bitmapfont_get_font_height();
-        int y = 8 + (font_height > 12 ? 1 : 0);
-        int x = 1;
-        uint32_t file_pos = file_start_pos;
-        file_next_pos = 0;
-        while (file_pos < size) {
-            uint32_t file_prev_pos = file_pos;
-            ws_bank_rom0_set(file_pos >> 16);
-            ws_bank_rom1_set((file_pos >> 16) + 1);
-            const char __far *ptr = MK_FP(0x2000 | ((file_pos >> 4) & 0xFFF), file_pos & 0xF);
-            uint32_t ch;
-            if (encoding == TXT_ENCODING_SJIS) {
-                ch = sjis_decode_next(&ptr, tbl_bank);
-            } else {
-                ch = wsx_utf8_decode_next(&ptr);
-            }
-            file_pos = (file_pos & ~0xF) + FP_OFF(ptr);
-
-            if (ch < 0x20) {
-                if (ch == '\n') {
-                    x = 1;
-                    y += font_height;
-                    if (!file_next_pos) {
-                        file_next_pos = file_pos;
-                    }
-                    if (y >= (screen_height - 8)) {
-                        break;
-                    }
-                } else if (ch == '\t') {
-                    x = (x + 0x11) & ~0xF;
-                }
-                continue;
-            }
-            uint16_t chw = bitmapfont_get_char_width(ch);
-            if ((x + chw) >= screen_width) {
-                x = 1;
-                y += font_height;
-                if (!file_next_pos) {
-                    file_next_pos = file_prev_pos;
-                }
-                if (y >= (screen_height - 8)) {
-                    break;
-                }
+        txtview_draw_rows(&t, row_pos, redraw_from);
+        if (t.result != FR_OK) break;
+        txtview_index_add(&t, file_start_pos);
+
+        uint32_t file_pos = row_pos[t.rows];
+        if (status) {
+            ui_draw_statusbar(status);
+            status = NULL;
+        } else {
+            // Scale both down so that the multiplication cannot overflow.
+            uint32_t pos = file_pos, size = t.size;
+            while (size > UINT32_MAX / 100) {
+                pos >>= 1;
+                size >>= 1;
             }
-            if (file_pos >= file_last_end_pos)
-                bitmapfont_draw_char(&ui_bitmap, x, y, ch);
-            x += chw;
+            uint16_t percent = size ? ((pos * 100) / size) : 100;
+            snprintf(buf, sizeof(buf) - 1, s_percent, percent);
+            ui_draw_statusbar(buf);
         }
-        file_last_end_pos = file_pos;
 
         uint32_t file_drawn_pos = file_start_pos;
-        uint16_t percent = (file_pos * 100) / size;
-        snprintf(buf, sizeof(buf) - 1, s_percent, percent);
-        ui_draw_statusbar(buf);
-
-        while (file_start_pos == file_drawn_pos) {
+        bool reader_redraw = false;
+        redraw_from = 0;
+        while (file_start_pos == file_drawn_pos && !reader_redraw) {
             idle_until_vblank();
             input_update();
             if (!input_pressed) continue;
@@ -257,42 +576,50 @@ int ui_txtview(const char *path) {
                 reader_open = false;
                 break;
             }
-            if (input_pressed & (WS_KEY_X1 | WS_KEY_Y1 | WS_KEY_X4 | WS_KEY_Y4)) {
-                if (file_start_pos > 1) {
-                    file_start_pos--;
-                    while (file_start_pos > 0) {
-                        file_start_pos--;
-                        ws_bank_rom0_set(file_start_pos >> 16);
-                        ws_bank_rom1_set(file_start_pos >> 16);
-                        const char __far *ptr = MK_FP(0x2000 | ((file_start_pos >> 4) & 0xFFF), file_start_pos & 0xF);
-                        if (*ptr == '\n') {
-                            file_start_pos++;
-                            break;
-                        }
-                    }
-                    reader_redraw = true;
+            if (input_pressed & WS_KEY_A) {
+                // Continue from the last match if it is on screen.
+                uint32_t pos = (last_match_pos >= file_start_pos && last_match_pos < file_pos) ? (last_match_pos + 1) : file_start_pos;
+                pos = txtview_find(&t, query, sizeof(query), pos);
+                if (pos < t.size) {
+                    last_match_pos = pos;
+                    file_start_pos = txtview_seek(&t, pos);
+                } else if (query[0]) {
+                    status = lang_keys[LK_UI_STATUS_NOT_FOUND];
                 }
-            } else if (input_pressed & (WS_KEY_X2 | WS_KEY_Y2)) {
-                if (file_pos < size) {
+                reader_redraw = true;
+            } else if (input_pressed & (WS_KEY_X1 | WS_KEY_Y1)) {
+                file_start_pos = txtview_rows_back(&t, file_start_pos, 1);
+            } else if (input_pressed & WS_KEY_X4) {
+                file_start_pos = txtview_rows_back(&t, file_start_pos, t.rows);
+            } else if (input_pressed & WS_KEY_X2) {
+                if (file_pos < t.size) {
                     file_start_pos = file_pos;
-                    reader_redraw = true;
+                }
+            } else if (input_pressed & WS_KEY_Y4) {
+                uint32_t step = t.size / 10;
+                file_start_pos = txtview_seek(&t, file_start_pos > step ? file_start_pos - step : 0);
+            } else if (input_pressed & WS_KEY_Y2) {
+                uint32_t step = t.size / 10;
+                if (file_pos < t.size) {
+                    file_start_pos = txtview_seek(&t, (t.size - file_start_pos) > step ? file_start_pos + step : t.size - 1);
                 }
             } else {
-                if (file_pos < size) {
-                    file_start_pos = file_next_pos;
-                    if (bitmap_rotation) {
-                        for (int i = 0; i < (screen_width >> 3); i++) {
-                            bitmap_vscroll_row(&ui_bitmap, i, 8 + font_height, 8, 128 - font_height);
-                            bitmap_rect_fill(&ui_bitmap, i << 3, 8 + 128 - font_height, 8, font_height, BITMAP_COLOR_2BPP(2));
-                        }
-                    } else {
-                        // TODO: add fast path for vertical mode
-                        reader_redraw = true;
-                    }
+                if (file_pos < t.size) {
+                    file_start_pos = row_pos[1];
+                    // Move the text up by one row and only draw the new last row.
+                    uint16_t text_height = screen_height - 16;
+                    bitmap_scroll_rows(&ui_bitmap, 8 + t.font_height, 8, text_height - t.font_height);
+                    bitmap_rect_fill(&ui_bitmap, 0, 8 + text_height - t.font_height, screen_width, t.font_height, BITMAP_COLOR_2BPP(2));
+                    memmove(row_pos, row_pos + 1, t.rows * sizeof(uint32_t));
+                    redraw_from = t.rows - 1;
                 }
             }
+            if (t.result != FR_OK) break;
         }
+        if (t.result != FR_OK) break;
     }
 
-    return 0;
+ui_txtview_end:
+    f_close(&t.fp);
+    return t.result;
 }
@@ -23,12 +23,14 @@
 #include <nilefs.h>
 #include <ws/memory.h>
 #include <ws/system.h>
+#include "bootstub.h"
 #include "errors.h"
 #include "lang.h"
 #include "../ui/ui.h"
 #include "../util/file.h"
 #include "../util/input.h"
 #include "../util/memops.h"
+#include "../util/puff/puff.h"
 #include "../util/util.h"
 #include "plugin.h"
 #include "settings.h"
@@ -36,7 +38,23 @@
 #include "util/asset_heap.h"
 #include "vgm/vgm.h"
 
+// Banks of PSRAM used to stream compressed files.
+#define VGM_STREAM_RING_BANKS_MIN 4
+#define VGM_STREAM_RING_BANKS_MAX 64
+// Bytes to inflate before starting playback; covers the VGM header.
+#define VGM_STREAM_START_SIZE 0x100
+
+typedef struct {
+    puff_ring_t ring;
+    // Logical bank the current inflate pass started at.
+    uint8_t pass_bank;
+    bool playing;
+    uint32_t gd3_offset;
+    int16_t result;
+} vgm_stream_t;
+
 static vgm_state_t *vgm_state;
+static volatile bool vgm_finished;
 
 void  __attribute__((interrupt, assume_ss_data)) vgm_interrupt_handler(void) {
     while (true) {
@@ -44,7 +62,7 @@ void  __attribute__((interrupt, assume_ss_data)) vgm_interrupt_handler(void) {
         uint16_t result = vgm_play(vgm_state);
         uint16_t ticks_elapsed = inportw(WS_TIMER_HBL_COUNTER_PORT) ^ 65535;
         if (result == VGM_PLAYBACK_FINISHED) {
-            vgm_state->bank = 0xFF;
+            vgm_finished = true;
             outportb(WS_TIMER_CTRL_PORT, 0);
         } else if (result > (ticks_elapsed + 1)) {
             outportw(WS_TIMER_HBL_RELOAD_PORT, result - ticks_elapsed);
@@ -63,32 +81,46 @@ static int strlen16(const uint16_t __far* text) {
     return i;
 }
 
+static inline uint16_t vgm_physical_bank(uint8_t bank) {
+    return vgm_state->bank_first + (bank & vgm_state->bank_mask);
+}
+
+static uint32_t vgm_get_gd3_offset(void) {
+    uint16_t old_bank = ws_bank_rom0_save(vgm_physical_bank(vgm_state->start_bank));
+    uint32_t gd3_offset = *((uint32_t __far*) MK_FP(WS_ROM0_SEGMENT, 0x0014));
+    ws_bank_rom0_set(old_bank);
+    return gd3_offset;
+}
+
 #define MAX_GD3_TEXT_LEN 127
 
 __attribute__((noinline))
-static void print_gd3_metadata(uint16_t vgm_bank) {
-    uint16_t old_bank = ws_bank_rom0_save(vgm_bank);
+static void print_gd3_metadata(uint32_t gd3_offset) {
     uint16_t text16[MAX_GD3_TEXT_LEN+1];
 
-    uint32_t gd3_offset = *((uint32_t __far*) MK_FP(WS_ROM0_SEGMENT, 0x0014));
     if (gd3_offset != 0) {
         gd3_offset += 0x20;
 
+        uint8_t gd3_bank = vgm_state->start_bank + (gd3_offset >> 16);
         const uint16_t __far* gd3_data = MK_FP(WS_ROM0_SEGMENT + ((gd3_offset & 0xFFF0) >> 4), (gd3_offset & 0xF));
 
         int x = 8;
         int y = 16;
         for (int i = 0; i < 8; i++) {
-            ws_bank_rom0_set(vgm_bank + (gd3_offset >> 16));
-            ws_bank_rom1_set(vgm_bank + (gd3_offset >> 16) + 1);
+            // Playback may be using the ROM banks at the same time.
+            ia16_disable_irq();
+            uint16_t old_bank = ws_bank_rom0_save(vgm_physical_bank(gd3_bank));
+            ws_bank_rom1_set(vgm_physical_bank(gd3_bank + 1));
 
             int len = strlen16(gd3_data);
+            memcpy(text16, gd3_data, MIN(len, MAX_GD3_TEXT_LEN) * 2);
+            text16[MIN(len, MAX_GD3_TEXT_LEN)] = 0;
+
+            ws_bank_rom0_set(old_bank);
+            ia16_enable_irq();
 
             if (len > 0 && (i == 0 || i == 2 || i == 4 || i == 6)) {
                 // Print text
-                memcpy(text16, gd3_data, MIN(len, MAX_GD3_TEXT_LEN) * 2);
-                text16[MIN(len, MAX_GD3_TEXT_LEN)] = 0;
-
                 bitmapfont_set_active_font(i == 0 ? font16_bitmap : font8_bitmap);
                 bitmapfont_draw_string16(&ui_bitmap, x, y, text16, 248);
                 y += i == 0 ? 16 : 12;
@@ -97,8 +129,181 @@ static void print_gd3_metadata(uint16_t vgm_bank) {
             gd3_data += len + 1;
         }
     }
+}
 
-    ws_bank_rom0_set(old_bank);
+static bool vgm_load(uint16_t bank_first, uint8_t bank_mask) {
+    ui_draw_statusbar(NULL);
+
+    ws_sound_reset();
+    outportb(WS_SOUND_WAVE_BASE_PORT, WS_SOUND_WAVE_BASE_ADDR(0x3FC0));
+
+    ui_unload_wallpaper();
+
+    if (!vgm_init_banked(vgm_state, bank_first, bank_mask, 0, 0)) {
+        ws_sound_reset();
+        return false;
+    }
+
+    return true;
+}
+
+static void vgm_start(void) {
+    input_wait_clear();
+    outportb(WS_SOUND_OUT_CTRL_PORT, WS_SOUND_OUT_CTRL_SPEAKER_ENABLE | WS_SOUND_OUT_CTRL_HEADPHONE_ENABLE | WS_SOUND_OUT_CTRL_SPEAKER_VOLUME_100);
+
+    outportw(WS_TIMER_HBL_RELOAD_PORT, 2);
+    outportb(WS_TIMER_CTRL_PORT, WS_TIMER_CTRL_HBL_REPEAT);
+
+    ws_int_set_handler(WS_INT_HBL_TIMER, (ia16_int_handler_t) vgm_interrupt_handler);
+    ws_int_enable(WS_INT_ENABLE_HBL_TIMER);
+}
+
+static int16_t vgm_play_memory(void) {
+    if (!vgm_load(0, 0xFF)) {
+        return ERR_FILE_FORMAT_INVALID;
+    }
+
+    print_gd3_metadata(vgm_get_gd3_offset());
+    vgm_start();
+
+    while (!vgm_finished) {
+        input_update();
+        if (input_pressed) {
+            break;
+        }
+    }
+
+    return FR_OK;
+}
+
+static bool vgm_stream_start(vgm_stream_t *stream) {
+    if (!vgm_load(stream->ring.bank_first, stream->ring.bank_mask)) {
+        stream->result = ERR_FILE_FORMAT_INVALID;
+        return false;
+    }
+
+    // The header will not stay in memory for long files.
+    stream->gd3_offset = vgm_get_gd3_offset();
+
+    vgm_state->flags = VGM_FLAG_STREAM_LIMIT | VGM_FLAG_STREAM_LOOP;
+    vgm_state->end_bank = stream->ring.bank;
+    vgm_state->end_pos = stream->ring.pos;
+    stream->playing = true;
+
+    vgm_start();
+    return true;
+}
+
+static bool vgm_stream_poll(puff_ring_t *ring) {
+    vgm_stream_t *stream = (vgm_stream_t*) ring;
+
+    if (!stream->playing) {
+        if (ring->bank == stream->pass_bank && ring->pos < VGM_STREAM_START_SIZE) {
+            return true;
+        }
+        if (!vgm_stream_start(stream)) {
+            return false;
+        }
+    }
+
+    ia16_disable_irq();
+    vgm_state->end_bank = ring->bank;
+    vgm_state->end_pos = ring->pos;
+    ring->read_bank = vgm_state->bank;
+    ia16_enable_irq();
+
+    input_update();
+    return !input_pressed;
+}
+
+static int16_t vgm_play_stream(uint32_t size, uint16_t offset) {
+    vgm_stream_t stream;
+    int16_t input_banks = (size + 65535L) >> 16;
+    int16_t free_banks = asset_heap_get_free_first_banks() - input_banks;
+
+    uint8_t ring_banks = VGM_STREAM_RING_BANKS_MAX;
+    while (ring_banks > free_banks) {
+        ring_banks >>= 1;
+    }
+    if (ring_banks < VGM_STREAM_RING_BANKS_MIN) {
+        return ERR_FILE_TOO_LARGE;
+    }
+
+    memset(&stream, 0, sizeof(stream));
+    stream.ring.bank_first = input_banks;
+    stream.ring.bank_mask = ring_banks - 1;
+    stream.ring.poll = vgm_stream_poll;
+    bootstub_resident_invalidate(input_banks, input_banks + ring_banks);
+
+    while (true) {
+        // Inflate the file from the start, while it is being played.
+        int err;
+        ws_bank_with_rom0(0, {
+            err = puff_ring(&stream.ring, MK_FP(WS_ROM0_SEGMENT, offset), size - offset);
+        });
+        if (err == PUFF_RING_ABORTED) {
+            return stream.result;
+        } else if (err != 0) {
+            return ERR_FILE_FORMAT_INVALID;
+        }
+
+        if (!stream.playing) {
+            if (!vgm_stream_start(&stream)) {
+                return stream.result;
+            }
+            print_gd3_metadata(stream.gd3_offset);
+        } else if (stream.pass_bank == 0) {
+            // The GD3 tag is at the end of the file, so it may only be printed now.
+            uint8_t gd3_bank = (stream.gd3_offset + 0x20) >> 16;
+            if ((uint8_t) (stream.ring.bank - gd3_bank) <= stream.ring.bank_mask) {
+                print_gd3_metadata(stream.gd3_offset);
+            }
+        }
+
+        ia16_disable_irq();
+        vgm_state->end_bank = stream.ring.bank;
+        vgm_state->end_pos = stream.ring.pos;
+        vgm_state->flags &= ~VGM_FLAG_STREAM_LIMIT;
+        ia16_enable_irq();
+
+        while (true) {
+            if (vgm_finished) {
+                return FR_OK;
+            }
+            input_update();
+            if (input_pressed) {
+                return FR_OK;
+            }
+
+            if (vgm_state->flags & VGM_FLAG_LOOP_PENDING) {
+                uint8_t loop_bank = stream.pass_bank + vgm_state->loop_bank;
+                bool resident = (uint8_t) (stream.ring.bank - loop_bank) <= stream.ring.bank_mask;
+                if (!resident) {
+                    // The loop point has been overwritten; inflate the file again.
+                    stream.pass_bank = stream.ring.bank + 1;
+                    stream.ring.bank = stream.pass_bank;
+                    stream.ring.pos = 0;
+                    loop_bank = stream.pass_bank + vgm_state->loop_bank;
+                }
+
+                ia16_disable_irq();
+                vgm_state->bank = loop_bank;
+                vgm_state->pos = vgm_state->loop_pos;
+                if (!resident) {
+                    vgm_state->end_bank = stream.ring.bank;
+                    vgm_state->end_pos = 0;
+                    vgm_state->flags |= VGM_FLAG_STREAM_LIMIT;
+                }
+                vgm_state->flags &= ~VGM_FLAG_LOOP_PENDING;
+                stream.ring.read_bank = loop_bank;
+                ia16_enable_irq();
+
+                if (!resident) {
+                    break;
+                }
+            }
+        }
+    }
 }
 
 int ui_vgmplay(const char *path) {
@@ -130,40 +335,15 @@ int ui_vgmplay(const char *path) {
         return result;
     }
 
-    uint16_t vgm_bank = 0;
-    uint16_t vgm_banks_used = (size + 65535L) >> 16;
-    memops_unpack_psram_data_if_gzip(&vgm_bank, vgm_banks_used);
-
-    ui_draw_statusbar(NULL);
-
     vgm_state = &local_vgm_state;
-
-    ws_sound_reset();
-    outportb(WS_SOUND_WAVE_BASE_PORT, WS_SOUND_WAVE_BASE_ADDR(0x3FC0));
-
-    ui_unload_wallpaper();
-
-    if (!vgm_init(&local_vgm_state, vgm_bank, 0)) {
-        ws_sound_reset();
-        return ERR_FILE_FORMAT_INVALID;
-    }
-
-    print_gd3_metadata(vgm_bank);
-
-    input_wait_clear();
-    outportb(WS_SOUND_OUT_CTRL_PORT, WS_SOUND_OUT_CTRL_SPEAKER_ENABLE | WS_SOUND_OUT_CTRL_HEADPHONE_ENABLE | WS_SOUND_OUT_CTRL_SPEAKER_VOLUME_100);
-
-    outportw(WS_TIMER_HBL_RELOAD_PORT, 2);
-    outportb(WS_TIMER_CTRL_PORT, WS_TIMER_CTRL_HBL_REPEAT);
-
-    ws_int_set_handler(WS_INT_HBL_TIMER, (ia16_int_handler_t) vgm_interrupt_handler);
-    ws_int_enable(WS_INT_ENABLE_HBL_TIMER);
-
-    while (vgm_state->bank != 0xFF) {
-        input_update();
-        if (input_pressed) {
-            break;
-        }
+    vgm_finished = false;
+
+    // Compressed files are inflated while playing.
+    uint16_t gzip_offset;
+    if (memops_find_psram_gzip_data(0, &gzip_offset) == FR_OK) {
+        result = vgm_play_stream(size, gzip_offset);
+    } else {
+        result = vgm_play_memory();
     }
 
     ws_int_disable(WS_INT_ENABLE_HBL_TIMER | WS_INT_ENABLE_LINE_MATCH);
@@ -178,5 +358,5 @@ int ui_vgmplay(const char *path) {
     ui_init();
     settings_load();
 
-    return 0;
+    return result;
 }
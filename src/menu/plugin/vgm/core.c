@@ -27,13 +27,18 @@
 #include "ui/ui.h"
 #include "vgm_internal.h"
 
+// Largest command size, other than PCM data blocks.
+#define VGM_STREAM_MARGIN 16
+// Samples to wait for when streamed data is not yet available.
+#define VGM_STREAM_WAIT_SAMPLES 88
+
 void dprint(const char __far* format, ...);
 
 static uint8_t __far* vgm_state_to_ptr(vgm_state_t *state, uint16_t *backup) {
     if (backup != NULL) *backup = inportw(WS_CART_EXTBANK_ROM0_PORT);
 
-    outportw(WS_CART_EXTBANK_ROM0_PORT, state->bank);
-    outportw(WS_CART_EXTBANK_ROM1_PORT, state->bank + 1);
+    outportw(WS_CART_EXTBANK_ROM0_PORT, state->bank_first + (state->bank & state->bank_mask));
+    outportw(WS_CART_EXTBANK_ROM1_PORT, state->bank_first + ((uint8_t) (state->bank + 1) & state->bank_mask));
 
     return MK_FP(WS_ROM0_SEGMENT | (state->pos >> 4), state->pos & 0xF);
 }
@@ -70,16 +75,9 @@ static void vgm_jump_to_start_point(vgm_state_t *state) {
     outportw(WS_CART_EXTBANK_ROM0_PORT, bank_backup);
 }
 
-static void vgm_jump_to_loop_point(vgm_state_t *state) {
-    uint16_t bank_backup;
-
-    state->bank = state->start_bank;
-    state->pos = state->start_pos;
-
-    uint8_t __far* ptr = vgm_state_to_ptr(state, &bank_backup);
-
-    uint16_t offset = vgm_get_offset(ptr);
-    state->pos += offset;
+static void vgm_find_loop_point(vgm_state_t *state, uint8_t __far* ptr) {
+    state->loop_bank = 0;
+    state->loop_pos = state->start_pos + vgm_get_offset(ptr);
 
     uint32_t loop_point = *((uint32_t __far*) (ptr + 0x1C));
     if (loop_point == 0 || (loop_point & 0xFF000000)) {
@@ -87,17 +85,46 @@ static void vgm_jump_to_loop_point(vgm_state_t *state) {
     } else {
         // loop point
         loop_point += 0x1C;
-        state->pos = loop_point;
-        state->bank = (loop_point >> 16) + state->bank;
+        state->loop_pos = loop_point;
+        state->loop_bank = loop_point >> 16;
     }
+}
 
-    outportw(WS_CART_EXTBANK_ROM0_PORT, bank_backup);
+static void vgm_jump_to_loop_point(vgm_state_t *state) {
+    if (state->flags & VGM_FLAG_STREAM_LOOP) {
+        // the loop point may no longer be in memory
+        state->flags |= VGM_FLAG_LOOP_PENDING;
+        return;
+    }
+
+    state->bank = state->start_bank + state->loop_bank;
+    state->pos = state->loop_pos;
+}
+
+uint32_t vgm_divider_ratio(uint32_t num, uint32_t den) {
+    if (!den) return 0;
+
+    // Long division, eight fractional bits at a time.
+    uint32_t result = num / den;
+    uint32_t rem = num % den;
+    for (uint8_t i = 0; i < 2; i++) {
+        rem <<= 8;
+        result = (result << 8) | (rem / den);
+        rem %= den;
+    }
+    return result;
 }
 
 bool vgm_init(vgm_state_t *state, uint8_t bank, uint16_t pos) {
+    return vgm_init_banked(state, 0, 0xFF, bank, pos);
+}
+
+bool vgm_init_banked(vgm_state_t *state, uint16_t bank_first, uint8_t bank_mask, uint8_t bank, uint16_t pos) {
     uint16_t bank_backup;
 
     memset(state, 0, sizeof(vgm_state_t));
+    state->bank_first = bank_first;
+    state->bank_mask = bank_mask;
     state->start_bank = bank;
     state->start_pos = pos;
     state->bank = bank;
@@ -191,6 +218,7 @@ bool vgm_init(vgm_state_t *state, uint8_t bank, uint16_t pos) {
     if (offset > 56*4 && version >= 0x171 && ((uint32_t __far*) ptr)[56]) { error = true; goto on_error; }
     if (offset > 57*4 && version >= 0x172 && ((uint32_t __far*) ptr)[57]) { error = true; goto on_error; }
 
+    vgm_find_loop_point(state, ptr);
     vgm_jump_to_start_point(state);
 
 #ifdef VGM_USE_PCM
@@ -206,9 +234,34 @@ on_error:
 uint16_t vgm_play(vgm_state_t *state) {
     uint16_t bank_backup;
     uint16_t hblanks = 0;
+    uint16_t ptr_limit = 0xFFFF;
+
+    if (state->flags & VGM_FLAG_LOOP_PENDING) {
+        return VGM_SAMPLES_TO_LINES(VGM_STREAM_WAIT_SAMPLES);
+    }
+
     state->ptr = vgm_state_to_ptr(state, &bank_backup);
 
+    if (state->flags & VGM_FLAG_STREAM_LIMIT) {
+        // Commands may only start this many bytes before the end of available data.
+        int32_t avail = ((int32_t) (int8_t) (state->end_bank - state->bank) << 16)
+            + state->end_pos - state->pos - VGM_STREAM_MARGIN;
+        if (avail < 0) {
+            outportw(WS_CART_EXTBANK_ROM0_PORT, bank_backup);
+            return VGM_SAMPLES_TO_LINES(VGM_STREAM_WAIT_SAMPLES);
+        }
+        if (avail < (uint16_t) (0xFFFF - FP_OFF(state->ptr))) {
+            ptr_limit = FP_OFF(state->ptr) + avail;
+        }
+    }
+
     while (hblanks == 0) {
+        if (FP_OFF(state->ptr) > ptr_limit) {
+            // wait for more data to be streamed in
+            hblanks = VGM_STREAM_WAIT_SAMPLES;
+            break;
+        }
+
         // play routine! <3
         uint8_t cmd = *(state->ptr++);
         switch (cmd) {
@@ -234,6 +287,12 @@ uint16_t vgm_play(vgm_state_t *state) {
             state->ptr++; // 0x66
             state->ptr++; // type - TODO: handle that?
             uint32_t len = *((uint32_t __far*) state->ptr); state->ptr += 4;
+            if (ptr_limit != 0xFFFF && len > (uint32_t) ptr_limit + VGM_STREAM_MARGIN - FP_OFF(state->ptr)) {
+                // wait for the whole data block to be streamed in
+                state->ptr -= 7;
+                hblanks = VGM_STREAM_WAIT_SAMPLES;
+                break;
+            }
 try_copy_pcm:
             if (ws_system_is_color_active()) {
                 if (state->pcm_data_block_count >= VGM_MAX_DATA_BLOCKS) {
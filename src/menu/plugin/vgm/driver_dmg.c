@@ -52,8 +52,7 @@ static const uint8_t __far duty_waveforms[] = {
 };
 
 static inline void dmg_sync_period(vgm_state_t *state, uint8_t idx) {
-    uint8_t shift = 2;
-    uint16_t divider = (1536000L * (2048 - (state->dmg.period[idx] & 0x7FF))) / (state->clock >> shift);
+    uint16_t divider = vgm_divider(state->divider_ratio[0], 2048 - (state->dmg.period[idx] & 0x7FF));
     outportw(0x80 + (idx << 1), -divider);
 }
 
@@ -171,6 +170,9 @@ bool vgm_init_dmg(vgm_state_t *state, uint8_t __far *header) {
     vstate = state;
     lcd_set_vtotal(188);
 
+    // Period dividers are 1536000 * (2048 - period) / (clock >> 2).
+    state->divider_ratio[0] = vgm_divider_ratio(1536000L, state->clock >> 2);
+
     outportb(WS_DISPLAY_LINE_IRQ_PORT, 10);
     ws_int_set_handler(WS_INT_LINE_MATCH, dmg_line_int_handler);
     ws_int_enable(WS_INT_ENABLE_LINE_MATCH);
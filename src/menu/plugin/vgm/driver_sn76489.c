@@ -41,6 +41,15 @@ bool vgm_init_sn76489(vgm_state_t *state, uint8_t __far *header) {
 
     state->sn76489.stereo = 0xFF;
 
+    // Tone and noise dividers are 3072000 * tone / (clock >> shift).
+    if (state->sn76489.flags & 0x08) {
+        state->divider_ratio[0] = vgm_divider_ratio(3072000L, state->clock >> 4);
+        state->divider_ratio[1] = vgm_divider_ratio(3072000L, state->clock >> 8);
+    } else {
+        state->divider_ratio[0] = vgm_divider_ratio(3072000L, state->clock >> 1);
+        state->divider_ratio[1] = vgm_divider_ratio(3072000L, state->clock >> 5);
+    }
+
     uint8_t __far *noise_wavetable_data = MK_FP(0x0000, (inportb(WS_SOUND_WAVE_BASE_PORT) << 6) + (SN_TO_WS_CHANNEL(3) << 4));
     for (int i = 0; i < 16; i++) {
         noise_wavetable_data[i] = (i & 7) ? 0x00 : 0x0F;
@@ -57,13 +66,7 @@ static inline void update_noise_freq(vgm_state_t *state) {
     case 2: tone = 0x40; break;
     case 3: tone = state->sn76489.tone[2]; break;
     }
-    uint16_t divider;
-    
-    if (state->sn76489.flags & 0x08) {
-        divider = (3072000L * tone) / (state->clock >> 8);
-    } else {
-        divider = (3072000L * tone) / (state->clock >> 5);
-    }
+    uint16_t divider = vgm_divider(state->divider_ratio[1], tone);
     outportw(0x80 + SN_TO_WS_CHANNEL(3) * 2, -divider);
     outportb(WS_SOUND_CH_CTRL_PORT, state->sn76489.noise & 0x4 ? 0x8F : 0x0F);                    
 }
@@ -114,12 +117,7 @@ uint16_t vgm_cmd_driver_sn76489(vgm_state_t *state, uint8_t cmd) {
                         tone = 0x400;
                     }
                     uint8_t __far *wavetable_data = MK_FP(0x0000, (inportb(WS_SOUND_WAVE_BASE_PORT) << 6) + (SN_TO_WS_CHANNEL(channel) << 4));
-                    uint16_t divider;
-                    if (state->sn76489.flags & 0x08) {
-                        divider = (3072000L * tone) / (state->clock >> 4);
-                    } else {
-                        divider = (3072000L * tone) / (state->clock >> 1);
-                    }
+                    uint16_t divider = vgm_divider(state->divider_ratio[0], tone);
                     outportw(0x80 + SN_TO_WS_CHANNEL(channel) * 2, -divider);
                     if (tone > 1) {
                         for (int i = 0; i < 16; i++) {
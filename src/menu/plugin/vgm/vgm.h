@@ -34,6 +34,13 @@
 #define VGM_DAC_FREQ_24000 0x03
 #define VGM_DAC_FREQ_MASK  0x03
 
+// Stop playback at end_bank:end_pos, waiting for more data to be streamed in.
+#define VGM_FLAG_STREAM_LIMIT 0x01
+// Leave jumping to the loop point to the caller, via VGM_FLAG_LOOP_PENDING.
+#define VGM_FLAG_STREAM_LOOP  0x02
+// Set when the loop point has been reached with VGM_FLAG_STREAM_LOOP set.
+#define VGM_FLAG_LOOP_PENDING 0x04
+
 #define VGM_USE_PCM
 #define VGM_MAX_STREAMS 1
 #define VGM_MAX_DATA_BLOCKS 16
@@ -48,9 +55,22 @@ typedef struct vgm_state {
     uint8_t flags;
     vgm_cmd_driver_t cmd_driver;
 
+    // Logical bank n is stored in physical bank bank_first + (n & bank_mask).
+    uint16_t bank_first;
+    uint8_t bank_mask;
+    // Loop point, relative to start_bank.
+    uint8_t loop_bank;
+    uint16_t loop_pos;
+    // End of available data, if VGM_FLAG_STREAM_LIMIT is set.
+    uint8_t end_bank;
+    uint16_t end_pos;
+
     uint8_t __far *ptr;
 
     uint32_t clock;
+    // 16.16 fixed-point frequency divider ratios, derived from the clock
+    // by the chip driver at init; see vgm_divider().
+    uint32_t divider_ratio[2];
     union {
         struct {
             uint8_t volume[4];
@@ -103,6 +123,8 @@ typedef struct vgm_state {
 #define VGM_PLAYBACK_FINISHED 0xFFFF
 
 bool vgm_init(vgm_state_t *state, uint8_t bank, uint16_t pos);
+// bank_mask + 1 must be a power of two.
+bool vgm_init_banked(vgm_state_t *state, uint16_t bank_first, uint8_t bank_mask, uint8_t bank, uint16_t pos);
 // return: amount of HBLANK lines to wait
 uint16_t vgm_play(vgm_state_t *state);
 
@@ -22,6 +22,9 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+#ifndef VGM_INTERNAL_H_
+#define VGM_INTERNAL_H_
+
 #include <stddef.h>
 #include <wonderful.h>
 #include <ws.h>
@@ -29,10 +32,20 @@
 
 #define VGM_SAMPLES_TO_LINES(x) (((((uint32_t) (x)) * 120) + 440L) / 441)
 
+// Returns (num << 16) / den, for den < 2^24.
+uint32_t vgm_divider_ratio(uint32_t num, uint32_t den);
+
+// Returns (ratio * value) >> 16, truncated to 16 bits.
+static inline uint16_t vgm_divider(uint32_t ratio, uint16_t value) {
+    return ((uint16_t) (ratio >> 16)) * value + (uint16_t) ((((uint32_t) ((uint16_t) ratio)) * value) >> 16);
+}
+
 bool vgm_init_dmg(vgm_state_t *state, uint8_t __far *header);
 uint16_t vgm_cmd_driver_dmg(vgm_state_t *state, uint8_t cmd);
 
 bool vgm_init_sn76489(vgm_state_t *state, uint8_t __far *header);
 uint16_t vgm_cmd_driver_sn76489(vgm_state_t *state, uint8_t cmd);
 
-uint16_t vgm_cmd_driver_ws(vgm_state_t *state, uint8_t cmd);
\ No newline at end of file
+uint16_t vgm_cmd_driver_ws(vgm_state_t *state, uint8_t cmd);
+
+#endif /* VGM_INTERNAL_H_ */
@@ -18,6 +18,7 @@
 #include <nile.h>
 #include <nilefs.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ws.h>
 #include "shell.h"
@@ -27,12 +28,16 @@
 #include "lang_gen.h"
 #include "launch/launch_athena.h"
 #include "strings.h"
+#include "util/bench.h"
 #include "util/file.h"
+#include "util/hash/crc32.h"
+#include "util/hash/sha1.h"
 #include "util/task/task.h"
 #include "errors.h"
 #include "lang.h"
 #include "launch/launch.h"
 #include "tokenizer.h"
+#include "ui/ui_file_type.h"
 #include "xmodem.h"
 
 uint8_t shell_task_mem[1216];
@@ -46,17 +51,23 @@ uint8_t shell_line_pos;
 #define SHELL_FLAG_INTERACTIVE 0x01
 uint8_t shell_flags = SHELL_FLAG_NOT_INITIALIZED;
 
+// Block size used by the hash and sync commands.
+#define SHELL_SYNC_BLOCK_SHIFT 16
+// Largest length passed to SHA1_Update(), which counts bits in a size_t.
+#define SHELL_SHA1_CHUNK_SIZE 4096
+
 DEFINE_STRING_LOCAL(s_line_too_long, "\r\nLine too long");
 DEFINE_STRING_LOCAL(s_new_line, "\r\n");
 DEFINE_STRING_LOCAL(s_new_prompt, "\r\n> ");
-DEFINE_STRING_LOCAL(s_dot_local, ".");
 DEFINE_STRING_LOCAL(s_space, " ");
 DEFINE_STRING_LOCAL(s_about, "about");
+DEFINE_STRING_LOCAL(s_bench, "bench");
 DEFINE_STRING_LOCAL(s_cat, "cat");
 DEFINE_STRING_LOCAL(s_cd, "cd");
 DEFINE_STRING_LOCAL(s_date, "date");
 DEFINE_STRING_LOCAL(s_download, "download");
 DEFINE_STRING_LOCAL(s_echo, "echo");
+DEFINE_STRING_LOCAL(s_hash, "hash");
 DEFINE_STRING_LOCAL(s_help, "help");
 DEFINE_STRING_LOCAL(s_launch, "launch");
 DEFINE_STRING_LOCAL(s_ls, "ls");
@@ -65,9 +76,14 @@ DEFINE_STRING_LOCAL(s_pwd, "pwd");
 DEFINE_STRING_LOCAL(s_reboot, "reboot");
 DEFINE_STRING_LOCAL(s_rm, "rm");
 DEFINE_STRING_LOCAL(s_rmdir, "rmdir");
+DEFINE_STRING_LOCAL(s_sha1, "sha1");
+DEFINE_STRING_LOCAL(s_sync, "sync");
 DEFINE_STRING_LOCAL(s_upload, "upload");
+DEFINE_STRING_LOCAL(s_upload_tmp_ext, ".TMP");
 DEFINE_STRING_LOCAL(s_ls_size, "%10ld ");
 DEFINE_STRING_LOCAL(s_ls_date, "%04d-%02d-%02d %02d:%02d ");
+DEFINE_STRING_LOCAL(s_hash_sum, "%08lx");
+DEFINE_STRING_LOCAL(s_sha1_byte, "%02x");
 DEFINE_STRING_LOCAL(s_invalid_argument, "Invalid argument");
 DEFINE_STRING_LOCAL(s_too_many_arguments, "Too many arguments");
 DEFINE_STRING_LOCAL(s_missing_argument, "Missing argument");
@@ -76,15 +92,16 @@ DEFINE_STRING_LOCAL(s_backspace, "\x08 \x08");
 DEFINE_STRING_LOCAL(s_awaiting_xmodem_transfer, "Awaiting XMODEM transfer");
 DEFINE_STRING_LOCAL(s_rtc_communication_error, "RTC communication error");
 DEFINE_STRING_LOCAL(s_invalid_date_format, "Invalid date format");
-DEFINE_STRING_LOCAL(s_saving_file, "Saving file");
 DEFINE_STRING_LOCAL(s_help_output,
 "Commands:\n"
 "about            \tAbout swanshell\n"
+"bench            \tBenchmark storage card and MCU link\n"
 "cat <path>       \tPrint text from file at path\n"
 "cd <path>        \tChange current directory to specified path\n"
 "date [date]      \tQuery or change RTC date and time\n"
 "download <path>  \tDownload file from storage card via XMODEM\n"
 "echo <text>      \tEcho text\n"
+"hash <path>      \tPrint size, date and 64 KB block CRC-32s of file\n"
 "help             \tPrint help information\n"
 "launch [path]    \tLaunch file via XMODEM or via path\n"
 "ls [path]        \tList files in path\n"
@@ -93,6 +110,9 @@ DEFINE_STRING_LOCAL(s_help_output,
 "reboot           \tSoft reboot cartridge\n"
 "rm <path>        \tRemove file at path\n"
 "rmdir <path>     \tRemove directory at path\n"
+"sha1 <path>      \tPrint SHA-1 digest of file\n"
+"sync <path> <size> <block> [count]\n"
+"                 \tReplace 64 KB blocks of file via XMODEM\n"
 "upload <path>    \tUpload file to storage card via XMODEM\n"
 );
 
@@ -165,9 +185,8 @@ static void shell_print_error(int16_t result) {
 
 __attribute__((noinline))
 static int16_t shell_launch_file(char *path) {
-    const char *ext = (const char*) strrchr(path, '.');
-    if (ext == NULL) return ERR_FILE_NOT_EXECUTABLE;
-    if (!strcasecmp(ext, s_file_ext_ws) || !strcasecmp(ext, s_file_ext_wsc) || !strcasecmp(ext, s_file_ext_pc2)) {
+    switch (file_type_from_filename(path)) {
+    case FILE_TYPE_ROM: {
         launch_rom_metadata_t meta;
         int16_t result = launch_get_rom_metadata(path, &meta);
         if (result == FR_OK) {
@@ -192,22 +211,27 @@ static int16_t shell_launch_file(char *path) {
             shell_task_yield(SHELL_RET_REFRESH_UI);
         }
         return result;
-    } else if (!strcasecmp(ext, s_file_ext_fx) || !strcasecmp(ext, s_file_ext_bin)) {
+    }
+    case FILE_TYPE_ATHENA_PROGRAM:
+    case FILE_TYPE_ATHENA_BINARY:
         // TODO: Do some checks on the .bin file
         return launch_athena_boot_curdir_as_rom_wip(path);
-    } else if (!strcasecmp(ext, s_file_ext_bfb)) {
+    case FILE_TYPE_BFB: {
         int16_t result = launch_bfb(path);
         shell_task_yield(SHELL_RET_REFRESH_UI);
         return result;
-    } else if (!strcasecmp(ext, s_file_ext_com)) {
+    }
+    case FILE_TYPE_COM: {
         int16_t result = launch_com(path);
         shell_task_yield(SHELL_RET_REFRESH_UI);
         return result;
-    } else if (!strcasecmp(ext, s_file_ext_rom)) {
+    }
+    case FILE_TYPE_UXN: {
         int16_t result = launch_plugin_via_ipc(s_path_plugin_uxn, path);
         shell_task_yield(SHELL_RET_REFRESH_UI);
         return result;
-    } else {
+    }
+    default:
         return ERR_FILE_NOT_EXECUTABLE;
     }
 }
@@ -230,27 +254,48 @@ static void shell_launch(void) {
     }
 }
 
-static void shell_file_callback(void *userdata, uint32_t step, uint32_t max) {
-    nile_mcu_native_cdc_write_string_const(s_dot_local);
-}
-
+__attribute__((noinline))
 static void shell_upload(const char *path) {
-    if (shell_flags & SHELL_FLAG_INTERACTIVE) {
-        nile_mcu_native_cdc_write_string_const(s_awaiting_xmodem_transfer);
+    FIL fp;
+    FILINFO fno;
+    char tmp_path[SHELL_LINE_LENGTH + 5];
+
+    // Never replace a directory with the uploaded file.
+    int16_t result = f_stat(path, &fno);
+    if (result == FR_OK && (fno.fattrib & AM_DIR))
+        result = FR_DENIED;
+    else if (result == FR_NO_FILE)
+        result = FR_OK;
+
+    // Receive into a temporary file, so that a failed transfer does not
+    // destroy an existing file of the same name. An existing temporary
+    // file is not overwritten.
+    strcpy(tmp_path, path);
+    strcat(tmp_path, s_upload_tmp_ext);
+
+    if (result == FR_OK) {
+        result = f_open(&fp, tmp_path, FA_WRITE | FA_CREATE_NEW);
+        if (result == FR_EXIST)
+            result = FR_DENIED;
     }
-    uint32_t size = 0;
-    int16_t result = xmodem_recv_to_psram(0, &size);
-    ws_delay_ms(10);
-    nile_mcu_native_cdc_write_string_const(s_new_line);
     if (result == FR_OK) {
-        FIL fp;
-        nile_mcu_native_cdc_write_string_const(s_saving_file);
-        result = f_open(&fp, path, FA_WRITE | FA_CREATE_ALWAYS);
-        if (result == FR_OK) {
-            result = f_write_rom_banked(&fp, 0, size, shell_file_callback, NULL, false);
-            f_close(&fp);
+        if (shell_flags & SHELL_FLAG_INTERACTIVE) {
+            nile_mcu_native_cdc_write_string_const(s_awaiting_xmodem_transfer);
         }
+        uint32_t size = 0;
+        result = xmodem_recv_to_file(&fp, 0, 0, &size);
+        ws_delay_ms(10);
         nile_mcu_native_cdc_write_string_const(s_new_line);
+        f_close(&fp);
+        if (result == FR_OK) {
+            result = f_unlink(path);
+            if (result == FR_OK || result == FR_NO_FILE) {
+                result = f_rename(tmp_path, path);
+            }
+        }
+        if (result != FR_OK) {
+            f_unlink(tmp_path);
+        }
     }
     if (result != FR_OK) {
         shell_print_error(result);
@@ -287,6 +332,188 @@ static void shell_download(const char *path) {
     }
 }
 
+static void shell_print_file_info(const FILINFO *fno, bool flag_size, bool flag_date) {
+    char buf[20];
+    if (flag_size) {
+        sprintf(buf, s_ls_size, fno->fsize);
+        nile_mcu_native_cdc_write_string(buf);
+    }
+    if (flag_date) {
+        sprintf(buf, s_ls_date,
+            1980 + (fno->fdate >> 9),
+            (fno->fdate >> 5) & 0xF,
+            fno->fdate & 0x1F,
+            fno->ftime >> 11,
+            (fno->ftime >> 5) & 0x3F,
+            (fno->ftime & 0x1F) << 1
+        );
+        nile_mcu_native_cdc_write_string(buf);
+    }
+    nile_mcu_native_cdc_write_string(fno->fname);
+    nile_mcu_native_cdc_write_string_const(s_new_line);
+}
+
+// Prints the file's "ls -l" line, followed by the CRC-32 of every 64 KB
+// block, as computed by zlib.
+__attribute__((noinline))
+static void shell_hash(const char *path) {
+    FIL fp;
+    FILINFO fno;
+    char buf[10];
+    int16_t result = f_stat(path, &fno);
+    if (result == FR_OK && (fno.fattrib & AM_DIR))
+        result = FR_NO_FILE;
+    if (result == FR_OK)
+        result = f_open(&fp, path, FA_READ | FA_OPEN_EXISTING);
+    if (result == FR_OK) {
+        shell_print_file_info(&fno, true, true);
+
+        uint16_t rom0_bank = ws_bank_rom0_save(0);
+        for (uint32_t pos = 0; pos < fno.fsize; pos += 1UL << SHELL_SYNC_BLOCK_SHIFT) {
+            uint32_t len = fno.fsize - pos;
+            if (len > (1UL << SHELL_SYNC_BLOCK_SHIFT))
+                len = 1UL << SHELL_SYNC_BLOCK_SHIFT;
+
+            result = f_read_rom_banked(&fp, 0, len, NULL, NULL);
+            if (result != FR_OK)
+                break;
+
+            // A block may be 64 KB long; crc32_update() takes at most
+            // 64 KB - 1 bytes at a time.
+            uint16_t half = len >> 1;
+            uint32_t crc = crc32_update(CRC32_INIT, half, MK_FP(WS_ROM0_SEGMENT, 0));
+            crc = crc32_update(crc, len - half, MK_FP(WS_ROM0_SEGMENT, half));
+
+            sprintf(buf, s_hash_sum, crc32_final(crc));
+            nile_mcu_native_cdc_write_string(buf);
+            nile_mcu_native_cdc_write_string_const(s_new_line);
+        }
+        ws_bank_rom0_restore(rom0_bank);
+
+        f_close(&fp);
+    }
+    if (result != FR_OK) {
+        shell_print_error(result);
+    }
+}
+
+__attribute__((noinline))
+static void shell_sha1(const char *path) {
+    SHA1_CTX context;
+    FIL fp;
+    uint8_t digest[SHA1_DIGEST_SIZE];
+    char buf[SHA1_DIGEST_SIZE * 2 + 1];
+    int16_t result = f_open(&fp, path, FA_READ | FA_OPEN_EXISTING);
+    if (result == FR_OK) {
+        SHA1_Init(&context);
+
+        uint16_t rom0_bank = ws_bank_rom0_save(0);
+        for (uint32_t pos = 0; pos < f_size(&fp); pos += 1UL << SHELL_SYNC_BLOCK_SHIFT) {
+            uint32_t len = f_size(&fp) - pos;
+            if (len > (1UL << SHELL_SYNC_BLOCK_SHIFT))
+                len = 1UL << SHELL_SYNC_BLOCK_SHIFT;
+
+            result = f_read_rom_banked(&fp, 0, len, NULL, NULL);
+            if (result != FR_OK)
+                break;
+
+            for (uint32_t i = 0; i < len; i += SHELL_SHA1_CHUNK_SIZE) {
+                SHA1_Update(&context, MK_FP(WS_ROM0_SEGMENT, (uint16_t) i),
+                    (len - i) > SHELL_SHA1_CHUNK_SIZE ? SHELL_SHA1_CHUNK_SIZE : (len - i));
+            }
+        }
+        ws_bank_rom0_restore(rom0_bank);
+
+        f_close(&fp);
+    }
+    if (result != FR_OK) {
+        shell_print_error(result);
+    } else {
+        SHA1_Final(&context, digest);
+        for (uint8_t i = 0; i < SHA1_DIGEST_SIZE; i++)
+            sprintf(buf + (i << 1), s_sha1_byte, digest[i]);
+        nile_mcu_native_cdc_write_string(buf);
+        nile_mcu_native_cdc_write_string_const(s_new_line);
+    }
+}
+
+static void shell_bench_result(const bench_result_t *result, void *userdata) {
+    char buf[48];
+    bench_format_result(buf, result);
+    // The benchmark leaves the SPI bus at the fast clock.
+    nile_spi_set_control(NILE_SPI_CLOCK_CART | NILE_SPI_DEV_NONE);
+    nile_mcu_native_cdc_write_string(buf);
+    nile_mcu_native_cdc_write_string_const(s_new_line);
+}
+
+// Also measures CDC throughput, as the shell always has a host attached.
+__attribute__((noinline))
+static void shell_bench(void) {
+    int16_t result = bench_run(BENCH_FLAG_CDC, shell_bench_result, NULL);
+    nile_spi_set_control(NILE_SPI_CLOCK_CART | NILE_SPI_DEV_NONE);
+    shell_print_error(result);
+}
+
+// sync <path> <size> <block> [count]
+// Receives count 64 KB blocks, starting at block, and writes them to the file
+// in place, then truncates it to size.
+__attribute__((noinline))
+static void shell_sync(char *path) {
+    char *arg;
+    uint32_t size;
+    uint16_t block, count = 1;
+
+    if (!(arg = shell_token_next(path))) {
+        nile_mcu_native_cdc_write_string_const(s_missing_argument);
+        return;
+    }
+    size = strtoul(arg, NULL, 0);
+    if (!(arg = shell_token_next(arg))) {
+        nile_mcu_native_cdc_write_string_const(s_missing_argument);
+        return;
+    }
+    block = strtoul(arg, NULL, 0);
+    if ((arg = shell_token_next(arg))) {
+        count = strtoul(arg, NULL, 0);
+    }
+
+    uint32_t offset = (uint32_t) block << SHELL_SYNC_BLOCK_SHIFT;
+    if (!count || offset >= size) {
+        nile_mcu_native_cdc_write_string_const(s_invalid_argument);
+        return;
+    }
+    uint32_t length = size - offset;
+    if (length > ((uint32_t) count << SHELL_SYNC_BLOCK_SHIFT))
+        length = (uint32_t) count << SHELL_SYNC_BLOCK_SHIFT;
+
+    FIL fp;
+    int16_t result = f_open(&fp, path, FA_WRITE | FA_OPEN_ALWAYS);
+    if (result == FR_OK) {
+        result = f_lseek(&fp, offset);
+        if (result == FR_OK) {
+            if (shell_flags & SHELL_FLAG_INTERACTIVE) {
+                nile_mcu_native_cdc_write_string_const(s_awaiting_xmodem_transfer);
+            }
+            uint32_t received = 0;
+            result = xmodem_recv_to_file(&fp, 0, length, &received);
+            ws_delay_ms(10);
+            nile_mcu_native_cdc_write_string_const(s_new_line);
+            if (result == FR_OK && received < length)
+                result = ERR_DATA_TRANSFER_CANCEL;
+        }
+        if (result == FR_OK && f_size(&fp) > size) {
+            result = f_lseek(&fp, size);
+            if (result == FR_OK)
+                result = f_truncate(&fp);
+        }
+        f_close(&fp);
+    }
+    if (result != FR_OK) {
+        shell_print_error(result);
+    }
+    shell_task_yield(SHELL_RET_REFRESH_UI);
+}
+
 static void shell_cd(const char *path) {
     char buf[2];
     if (path == NULL) {
@@ -354,7 +581,7 @@ static void shell_ls(char *arg) {
     char *path = NULL;
     bool flag_size = false;
     bool flag_date = false;
-    char buf[20];
+    char buf[2];
     bool parsing_flags = true;
 
     while (true) {
@@ -395,23 +622,7 @@ static void shell_ls(char *arg) {
                 break;
     		if (fno.fname[0] == 0)
     			break;
-            if (flag_size) {
-                sprintf(buf, s_ls_size, fno.fsize);
-                nile_mcu_native_cdc_write_string(buf);
-            }
-            if (flag_date) {
-                sprintf(buf, s_ls_date,
-                    1980 + (fno.fdate >> 9),
-                    (fno.fdate >> 5) & 0xF,
-                    fno.fdate & 0x1F,
-                    fno.ftime >> 11,
-                    (fno.ftime >> 5) & 0x3F,
-                    (fno.ftime & 0x1F) << 1
-                );
-                nile_mcu_native_cdc_write_string(buf);
-            }
-            nile_mcu_native_cdc_write_string(fno.fname);
-            nile_mcu_native_cdc_write_string_const(s_new_line);
+            shell_print_file_info(&fno, flag_size, flag_date);
     	}
 
         f_closedir(&dp);
@@ -516,6 +727,8 @@ static void shell_run_command(void) {
             return;
         }
         shell_mkdir(arg);
+    } else if (!strcmp_const(shell_line, s_bench)) {
+        shell_bench();
     } else if (!strcmp_const(shell_line, s_help)) {
         shell_help();
     } else if (!strcmp_const(shell_line, s_reboot)) {
@@ -540,6 +753,24 @@ static void shell_run_command(void) {
             return;
         }
         shell_upload(arg);
+    } else if (!strcmp_const(shell_line, s_hash)) {
+        if (!(arg = shell_token_next(arg))) {
+            nile_mcu_native_cdc_write_string_const(s_missing_argument);
+            return;
+        }
+        shell_hash(arg);
+    } else if (!strcmp_const(shell_line, s_sha1)) {
+        if (!(arg = shell_token_next(arg))) {
+            nile_mcu_native_cdc_write_string_const(s_missing_argument);
+            return;
+        }
+        shell_sha1(arg);
+    } else if (!strcmp_const(shell_line, s_sync)) {
+        if (!(arg = shell_token_next(arg))) {
+            nile_mcu_native_cdc_write_string_const(s_missing_argument);
+            return;
+        }
+        shell_sync(arg);
     } else if (!strcmp_const(shell_line, s_echo)) {
         int i = 0;
         while ((arg = shell_token_next(arg))) {
@@ -64,6 +64,9 @@ DEFINE_STRING(s_file_ext_rtc, ".rtc");
 DEFINE_STRING(s_path_save_ini, "/NILESWAN/SAVE.INI");
 DEFINE_STRING(s_path_config_ini, "/NILESWAN/CONFIG.INI");
 DEFINE_STRING(s_path_wallpaper_bmp, "/NILESWAN/WALLPAPER.BMP");
+DEFINE_STRING(s_path_dircache, "/NILESWAN/DIRCACHE.BIN");
+DEFINE_STRING(s_path_bench_tmp, "/NILESWAN/BENCH.TMP");
+DEFINE_STRING(s_path_bench_log, "/NILESWAN/BENCH.LOG");
 
 DEFINE_STRING(s_path_plugin_uxn, "/NILESWAN/PLUG_UXN.BIN");
 
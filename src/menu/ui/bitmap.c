@@ -263,22 +263,37 @@ void bitmap_draw_glyph(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, uin
     }
 }
 
-void bitmap_vscroll_row(const bitmap_t *bitmap, uint16_t ix, uint16_t row_from, uint16_t row_to, uint16_t height) {
+static void bitmap_move(uint8_t *dst, const uint8_t *src, uint16_t length) {
     if (ws_system_is_color_active()) {
-        uint16_t dst = (uint16_t) BITMAP_AT(bitmap, ix << 3, row_to);
-        uint16_t src = (uint16_t) BITMAP_AT(bitmap, ix << 3, row_from);
         uint8_t mode = WS_GDMA_CTRL_INC | WS_GDMA_CTRL_START;
-        if (row_from < row_to) {
-            src += (bitmap->bpp * height) - 2;
-            dst += (bitmap->bpp * height) - 2;
+        if (src < dst) {
+            src += length - 2;
+            dst += length - 2;
             mode |= WS_GDMA_CTRL_DEC;
         }
-        outportw(WS_GDMA_LENGTH_PORT, (bitmap->bpp * height));
-        outportw(WS_GDMA_SOURCE_L_PORT, src);
-        outportw(WS_GDMA_DEST_PORT, dst);
+        outportw(WS_GDMA_LENGTH_PORT, length);
+        outportw(WS_GDMA_SOURCE_L_PORT, (uint16_t) src);
+        outportw(WS_GDMA_DEST_PORT, (uint16_t) dst);
         outportb(WS_GDMA_SOURCE_H_PORT, 0);
         outportb(WS_GDMA_CTRL_PORT, mode);
     } else {
-        _nmemmove(BITMAP_AT(bitmap, ix << 3, row_to), BITMAP_AT(bitmap, ix << 3, row_from), bitmap->bpp * height);
+        _nmemmove(dst, src, length);
+    }
+}
+
+void bitmap_vscroll_row(const bitmap_t *bitmap, uint16_t ix, uint16_t row_from, uint16_t row_to, uint16_t height) {
+    bitmap_move(BITMAP_AT(bitmap, ix << 3, row_to), BITMAP_AT(bitmap, ix << 3, row_from), bitmap->bpp * height);
+}
+
+void bitmap_scroll_rows(const bitmap_t *bitmap, uint16_t row_from, uint16_t row_to, uint16_t height) {
+    if (bitmap_rotation) {
+        for (uint16_t ix = 0; ix < bitmap->width; ix++) {
+            bitmap_vscroll_row(bitmap, ix, row_from, row_to, height);
+        }
+    } else {
+        // Rows are tile columns in vertical mode, stored contiguously.
+        uint16_t x_from = (bitmap->width << 3) - height - row_from;
+        uint16_t x_to = (bitmap->width << 3) - height - row_to;
+        bitmap_move(BITMAP_AT(bitmap, x_to, 0), BITMAP_AT(bitmap, x_from, 0), (height >> 3) * bitmap->x_pitch);
     }
 }
@@ -22,6 +22,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <wonderful.h>
+#include "config.h"
 
 // 0 - vertical
 // 1 - horizontal
@@ -81,6 +82,8 @@ static inline void bitmap_hline(bitmap_t *bitmap, uint16_t x, uint16_t y, uint16
 void bitmap_vline(bitmap_t *bitmap, uint16_t x, uint16_t y, uint16_t length, uint16_t color);
 void bitmap_draw_glyph(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, uint16_t w, uint16_t h, uint16_t layer, const uint8_t __far* font_data);
 void bitmap_vscroll_row(const bitmap_t *bitmap, uint16_t ix, uint16_t row_from, uint16_t row_to, uint16_t height);
+// Move a band of rows, in screen coordinates; all values must be multiples of 8.
+void bitmap_scroll_rows(const bitmap_t *bitmap, uint16_t row_from, uint16_t row_to, uint16_t height);
 
 #define font8_bitmap 0
 #define font16_bitmap 2
@@ -97,9 +100,43 @@ typedef struct __attribute__((packed)) {
 } bitmapfont_header_t;
 
 #define BITMAPFONT_HEADER_MAGIC 0x6653
+#define BITMAPFONT_VERSION_MAJOR 1
+#define BITMAPFONT_VERSION_MINOR 1
+
+#define BITMAPFONT_PAGE_DENSE  0xFFFF
+#define BITMAPFONT_PAGE_RANGED 0xFFFE
 
 #define BITMAPFONT_BOX_CENTERED 0x0001
 
+typedef struct __attribute__((packed)) {
+    uint16_t offset; // Glyph entry offset in ROM0
+    uint16_t bank; // Glyph entry bank in ROM0
+    uint8_t width;
+} bitmapfont_layout_glyph_t;
+
+typedef struct {
+    uint8_t first;
+    uint8_t count;
+    uint16_t width;
+} bitmapfont_layout_line_t;
+
+// line_count value for strings which did not fit in the run buffer
+#define BITMAPFONT_LAYOUT_OVERFLOW 0xFF
+
+typedef struct {
+    const char __far* str;
+    uint8_t font;
+    uint8_t generation;
+    uint8_t line_count;
+    uint8_t glyph_count;
+    int8_t linegap;
+    uint16_t width;
+    uint16_t height;
+    // Points into the glyph run buffer shared by all layouts.
+    const bitmapfont_layout_glyph_t *glyphs;
+    bitmapfont_layout_line_t lines[CONFIG_FONT_LAYOUT_MAX_LINES];
+} bitmapfont_layout_t;
+
 void bitmapfont_update_active_font(void);
 void bitmapfont_set_active_font(uint16_t font);
 uint16_t bitmapfont_get_font_height(void);
@@ -111,4 +148,15 @@ uint16_t bitmapfont_draw_string16(const bitmap_t *bitmap, uint16_t xofs, uint16_
 void bitmapfont_get_string_box(const char __far* str, uint16_t *width, uint16_t *height, int linegap);
 uint16_t bitmapfont_draw_string_box(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const char __far* str, uint16_t width, int linegap, uint16_t flags);
 
+// Layouts decode and measure a string once; they can then be drawn any number
+// of times while the font active at layout time remains active. All layouts
+// share one glyph run buffer: bitmapfont_layout_reset() empties it, which
+// invalidates every layout made before it.
+void bitmapfont_layout_reset(void);
+void bitmapfont_layout_string_box(bitmapfont_layout_t *layout, const char __far* str, uint16_t width, int linegap);
+void bitmapfont_layout_string(bitmapfont_layout_t *layout, const char __far* str);
+bool bitmapfont_layout_is_valid(const bitmapfont_layout_t *layout);
+uint16_t bitmapfont_draw_layout(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const bitmapfont_layout_t *layout, uint16_t flags);
+uint16_t bitmapfont_draw_layout_line(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const bitmapfont_layout_t *layout, uint16_t first, uint16_t max_width);
+
 #endif /* BITMAP_H_ */
@@ -22,6 +22,7 @@
 #include <nilefs.h>
 #include "bitmap.h"
 #include "config.h"
+#include "errors.h"
 #include "lang.h"
 #include "settings.h"
 #include "strings.h"
@@ -75,11 +76,20 @@ static const uint16_t __far* __bitmapfont_find_char(uint32_t ch) {
         ws_bank_rom0_set(base_ptr->bank + font_banks[active_font]);
     }
     uint16_t nmemb = *((const uint16_t __far*) (base - 2));
-    if (nmemb == 0xFFFF) {
+    if (nmemb == BITMAPFONT_PAGE_DENSE) {
         const uint16_t __far* ptr = (const uint16_t __far*) (base + (ch_low << 2));
         if (*ptr == 0)
             return NULL;
         return ptr;
+    } else if (nmemb == BITMAPFONT_PAGE_RANGED) {
+        // base[0] = first low byte, base[1] = entry count
+        uint8_t idx = ch_low - base[0];
+        if (idx >= base[1])
+            return NULL;
+        const uint16_t __far* ptr = (const uint16_t __far*) (base + 2 + (idx << 2));
+        if (*ptr == 0)
+            return NULL;
+        return ptr;
     }
 
     const uint8_t __far* pivot;
@@ -120,6 +130,97 @@ static inline uint16_t __bitmapfont_get_char_width(const uint16_t __far* data16)
     }
 }
 
+// Glyph cache. Finding a glyph takes a binary search over banked font data,
+// while most text repeats a small set of characters. Printable ASCII, which
+// shares a bank within each font, gets a dedicated table per font size.
+#define GLYPH_CACHE_SIZE 64
+#define GLYPH_ASCII_FIRST 0x20
+#define GLYPH_ASCII_COUNT 0x5F
+
+typedef struct {
+    uint16_t ch;
+    uint16_t offset;
+    uint16_t bank;
+    uint8_t font;
+    uint8_t width;
+} bitmapfont_glyph_entry_t;
+
+typedef struct {
+    uint8_t font;
+    uint16_t bank;
+    uint16_t offset[GLYPH_ASCII_COUNT]; // 0 if not cached
+    uint8_t width[GLYPH_ASCII_COUNT];
+} bitmapfont_glyph_ascii_t;
+
+static bitmapfont_glyph_entry_t glyph_cache[GLYPH_CACHE_SIZE];
+static bitmapfont_glyph_ascii_t glyph_ascii[2] = {{.font = 0xFF}, {.font = 0xFF}};
+
+static void bitmapfont_glyph_cache_clear(void) {
+    memset(glyph_cache, 0xFF, sizeof(glyph_cache));
+    glyph_ascii[0].font = 0xFF;
+    glyph_ascii[1].font = 0xFF;
+}
+
+// Returns glyph data, falling back to the error glyph, with ROM0 set to its bank.
+static const uint16_t __far* __bitmapfont_get_glyph(uint32_t ch, uint16_t *width) {
+    const uint16_t __far* data;
+
+    if (ch < GLYPH_ASCII_FIRST + GLYPH_ASCII_COUNT) {
+        bitmapfont_glyph_ascii_t *ascii = &glyph_ascii[active_font >> 1];
+        uint8_t idx = ch - GLYPH_ASCII_FIRST;
+
+        if (ascii->font != active_font) {
+            memset(ascii->offset, 0, sizeof(ascii->offset));
+            ascii->font = active_font;
+            ascii->bank = 0xFFFF;
+        } else if (ascii->offset[idx]) {
+            ws_bank_rom0_set(ascii->bank);
+            *width = ascii->width[idx];
+            return MK_FP(WS_ROM0_SEGMENT, ascii->offset[idx]);
+        }
+
+        data = __bitmapfont_find_char(ch);
+        if (!FP_SEG(data)) {
+            data = __bitmapfont_get_error_glyph();
+            *width = __bitmapfont_get_char_width(data);
+            return data;
+        }
+
+        *width = __bitmapfont_get_char_width(data);
+        uint16_t bank = inportw(WS_CART_EXTBANK_ROM0_PORT);
+        if (ascii->bank == 0xFFFF) {
+            ascii->bank = bank;
+        }
+        if (ascii->bank == bank) {
+            ascii->offset[idx] = FP_OFF(data);
+            ascii->width[idx] = *width;
+        }
+        return data;
+    }
+
+    bitmapfont_glyph_entry_t *entry = &glyph_cache[(uint16_t) ch & (GLYPH_CACHE_SIZE - 1)];
+    if (entry->ch == ch && entry->font == active_font) {
+        ws_bank_rom0_set(entry->bank);
+        *width = entry->width;
+        return MK_FP(WS_ROM0_SEGMENT, entry->offset);
+    }
+
+    data = __bitmapfont_find_char(ch);
+    if (!FP_SEG(data)) {
+        data = __bitmapfont_get_error_glyph();
+    }
+    *width = __bitmapfont_get_char_width(data);
+
+    if (ch <= 0xFFFF) {
+        entry->ch = ch;
+        entry->font = active_font;
+        entry->offset = FP_OFF(data);
+        entry->bank = inportw(WS_CART_EXTBANK_ROM0_PORT);
+        entry->width = *width;
+    }
+    return data;
+}
+
 static inline uint16_t __bitmapfont_draw_char(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const uint16_t __far* data) {
     if (!FP_SEG(data))
         data = __bitmapfont_get_error_glyph();
@@ -156,7 +257,9 @@ uint16_t bitmapfont_get_char_width(uint32_t ch) {
         return 0;
     }
     ws_bank_with_rom0(font_banks[active_font], {
-        return __bitmapfont_get_char_width(__bitmapfont_find_char(ch));
+        uint16_t width;
+        __bitmapfont_get_glyph(ch, &width);
+        return width;
     });
 }
 
@@ -164,7 +267,8 @@ uint16_t bitmapfont_draw_char(const bitmap_t *bitmap, uint16_t xofs, uint16_t yo
     if (ch < 0x20) {
         return 0;
     }
-    return __bitmapfont_draw_char(bitmap, xofs, yofs, __bitmapfont_find_char(ch));
+    uint16_t width;
+    return __bitmapfont_draw_char(bitmap, xofs, yofs, __bitmapfont_get_glyph(ch, &width));
 }
 
 uint16_t bitmapfont_get_string_width(const char __far* str, uint16_t max_width) {
@@ -176,7 +280,9 @@ uint16_t bitmapfont_get_string_width(const char __far* str, uint16_t max_width)
             if (ch < 0x20) {
                 continue;
             }
-            uint16_t new_width = width + __bitmapfont_get_char_width(__bitmapfont_find_char(ch));
+            uint16_t char_width;
+            __bitmapfont_get_glyph(ch, &char_width);
+            uint16_t new_width = width + char_width;
             if (new_width > max_width)
                 return width - CONFIG_FONT_CHAR_GAP;
 
@@ -196,8 +302,9 @@ uint16_t bitmapfont_draw_string(const bitmap_t *bitmap, uint16_t xofs, uint16_t
             if (ch < 0x20) {
                 continue;
             }
-            const uint16_t __far* data = __bitmapfont_find_char(ch);
-            uint16_t new_width = width + __bitmapfont_get_char_width(data);
+            uint16_t char_width;
+            const uint16_t __far* data = __bitmapfont_get_glyph(ch, &char_width);
+            uint16_t new_width = width + char_width;
             if (new_width > max_width)
                 return width - CONFIG_FONT_CHAR_GAP;
 
@@ -219,8 +326,9 @@ uint16_t bitmapfont_draw_string16(const bitmap_t *bitmap, uint16_t xofs, uint16_
             if (*str < 0x20) {
                 str++; continue;
             }
-            const uint16_t __far* data = __bitmapfont_find_char(*(str++));
-            uint16_t new_width = width + __bitmapfont_get_char_width(data);
+            uint16_t char_width;
+            const uint16_t __far* data = __bitmapfont_get_glyph(*(str++), &char_width);
+            uint16_t new_width = width + char_width;
             if (new_width > max_width)
                 return width - CONFIG_FONT_CHAR_GAP;
 
@@ -347,6 +455,217 @@ uint16_t bitmapfont_draw_string_box(const bitmap_t *bitmap, uint16_t xofs, uint1
     return yofs - start_yofs;
 }
 
+// Glyph runs of all layouts live in this buffer, one after the other, until
+// the next bitmapfont_layout_reset().
+static bitmapfont_layout_glyph_t layout_glyphs[CONFIG_FONT_LAYOUT_MAX_GLYPHS];
+static uint8_t layout_glyphs_used;
+static uint8_t layout_generation;
+
+void bitmapfont_layout_reset(void) {
+    layout_glyphs_used = 0;
+    layout_generation++;
+}
+
+static bool __bitmapfont_layout_add_line(bitmapfont_layout_t *layout, uint8_t first, uint8_t last, uint16_t width) {
+    if (layout->line_count >= CONFIG_FONT_LAYOUT_MAX_LINES)
+        return false;
+
+    bitmapfont_layout_line_t *line = &layout->lines[layout->line_count++];
+    line->first = first;
+    line->count = last - first;
+    line->width = width;
+    if (layout->width < width)
+        layout->width = width;
+    return true;
+}
+
+// Same line breaking rules as bitmapfont_get_string_box().
+static void bitmapfont_layout_inner(bitmapfont_layout_t *layout, const char __far* str, uint16_t width, int linegap, bool wrap) {
+    uint32_t ch;
+    uint8_t count = 0;
+    uint8_t line_first = 0;
+    uint16_t line_width = 0;
+    uint8_t break_glyph = 0xFF;
+    uint16_t break_width = 0;
+    uint16_t font_height;
+    bool overflow = false;
+    bitmapfont_layout_glyph_t *glyphs = layout_glyphs + layout_glyphs_used;
+    uint8_t glyph_capacity = CONFIG_FONT_LAYOUT_MAX_GLYPHS - layout_glyphs_used;
+
+    layout->str = str;
+    layout->font = active_font;
+    layout->generation = layout_generation;
+    layout->glyphs = glyphs;
+    layout->line_count = 0;
+    layout->linegap = linegap;
+    layout->width = 0;
+
+    ws_bank_with_rom0(font_banks[active_font], {
+        font_height = bitmapfont_get_header_ptr()->font_height;
+
+        while (true) {
+            ch = wsx_utf8_decode_next(&str);
+            if (!ch || ch == '\n') {
+                if (!__bitmapfont_layout_add_line(layout, line_first, count, line_width)) {
+                    overflow = true;
+                    break;
+                }
+                if (!ch) {
+                    break;
+                }
+                line_first = count;
+                line_width = 0;
+                break_glyph = 0xFF;
+                continue;
+            }
+            if (ch < 0x20) {
+                continue;
+            }
+            bool is_soft_break = wrap && ch == ' ';
+            if (is_soft_break && count == line_first) {
+                continue;
+            }
+            if (count >= glyph_capacity) {
+                overflow = true;
+                break;
+            }
+
+            uint16_t char_width;
+            const uint16_t __far* data = __bitmapfont_get_glyph(ch, &char_width);
+            uint16_t bank = inportw(WS_CART_EXTBANK_ROM0_PORT);
+
+            while (wrap && count != line_first && line_width + CONFIG_FONT_CHAR_GAP + char_width > width) {
+                if (is_soft_break || break_glyph == 0xFF) {
+                    // Break before this character; a space is dropped.
+                    overflow = !__bitmapfont_layout_add_line(layout, line_first, count, line_width);
+                    line_first = count;
+                    line_width = 0;
+                } else {
+                    // Move the glyphs following the last space to a new line.
+                    overflow = !__bitmapfont_layout_add_line(layout, line_first, break_glyph, break_width);
+                    line_first = break_glyph + 1;
+                    line_width = 0;
+                    for (uint8_t i = line_first; i < count; i++) {
+                        if (i != line_first) line_width += CONFIG_FONT_CHAR_GAP;
+                        line_width += glyphs[i].width;
+                    }
+                }
+                break_glyph = 0xFF;
+                if (overflow) {
+                    break;
+                }
+            }
+            if (overflow) {
+                break;
+            }
+            if (is_soft_break) {
+                if (count == line_first) {
+                    continue;
+                }
+                break_glyph = count;
+                break_width = line_width;
+            }
+
+            bitmapfont_layout_glyph_t *glyph = &glyphs[count++];
+            glyph->offset = FP_OFF(data);
+            glyph->bank = bank;
+            glyph->width = char_width;
+            if (count - 1 != line_first) {
+                line_width += CONFIG_FONT_CHAR_GAP;
+            }
+            line_width += char_width;
+        }
+    });
+
+    layout->glyph_count = count;
+    if (!overflow) {
+        layout_glyphs_used += count;
+    }
+    if (overflow) {
+        // Too long for the run buffer; measure and draw directly from the string.
+        layout->line_count = BITMAPFONT_LAYOUT_OVERFLOW;
+        if (wrap) {
+            layout->width = width;
+            bitmapfont_get_string_box(layout->str, &layout->width, &layout->height, linegap);
+        } else {
+            layout->width = bitmapfont_get_string_width(layout->str, 65535);
+            layout->height = font_height;
+        }
+    } else {
+        layout->height = layout->line_count * (font_height + linegap) - linegap;
+    }
+}
+
+void bitmapfont_layout_string_box(bitmapfont_layout_t *layout, const char __far* str, uint16_t width, int linegap) {
+    bitmapfont_layout_inner(layout, str, width, linegap, true);
+}
+
+void bitmapfont_layout_string(bitmapfont_layout_t *layout, const char __far* str) {
+    bitmapfont_layout_inner(layout, str, 65535, 0, false);
+}
+
+bool bitmapfont_layout_is_valid(const bitmapfont_layout_t *layout) {
+    return layout->font == active_font && layout->generation == layout_generation;
+}
+
+static uint16_t __bitmapfont_draw_layout_glyphs(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const bitmapfont_layout_glyph_t *glyph, uint8_t count, uint16_t max_width) {
+    uint16_t bank = 0xFFFF;
+    uint16_t width = 0;
+
+    for (; count; count--, glyph++) {
+        uint16_t new_width = width + glyph->width;
+        if (new_width > max_width)
+            break;
+        if (glyph->bank != bank) {
+            bank = glyph->bank;
+            ws_bank_rom0_set(bank);
+        }
+
+        __bitmapfont_draw_char(bitmap, xofs + width, yofs, MK_FP(WS_ROM0_SEGMENT, glyph->offset));
+        width = new_width + CONFIG_FONT_CHAR_GAP;
+    }
+
+    return width ? width - CONFIG_FONT_CHAR_GAP : 0;
+}
+
+uint16_t bitmapfont_draw_layout(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const bitmapfont_layout_t *layout, uint16_t flags) {
+    if (layout->line_count == BITMAPFONT_LAYOUT_OVERFLOW)
+        return bitmapfont_draw_string_box(bitmap, xofs, yofs, layout->str, layout->width, layout->linegap, flags);
+
+    uint16_t line_height = bitmapfont_get_font_height() + layout->linegap;
+    const bitmapfont_layout_line_t *line = layout->lines;
+
+    ws_bank_with_rom0(font_banks[active_font], {
+        for (uint8_t i = 0; i < layout->line_count; i++, line++) {
+            uint16_t line_xofs = xofs;
+            if (flags & BITMAPFONT_BOX_CENTERED) {
+                line_xofs += (layout->width - line->width) >> 1;
+            }
+            __bitmapfont_draw_layout_glyphs(bitmap, line_xofs, yofs, layout->glyphs + line->first, line->count, 65535);
+            yofs += line_height;
+        }
+    });
+
+    return layout->line_count * line_height;
+}
+
+uint16_t bitmapfont_draw_layout_line(const bitmap_t *bitmap, uint16_t xofs, uint16_t yofs, const bitmapfont_layout_t *layout, uint16_t first, uint16_t max_width) {
+    if (layout->line_count == BITMAPFONT_LAYOUT_OVERFLOW) {
+        const char __far* str = layout->str;
+        while (first-- && *str)
+            wsx_utf8_decode_next(&str);
+        return bitmapfont_draw_string(bitmap, xofs, yofs, str, max_width);
+    }
+
+    const bitmapfont_layout_line_t *line = layout->lines;
+    if (first >= line->count)
+        return 0;
+
+    ws_bank_with_rom0(font_banks[active_font], {
+        return __bitmapfont_draw_layout_glyphs(bitmap, xofs, yofs, layout->glyphs + line->first + first, line->count - first, max_width);
+    });
+}
+
 static int16_t bitmapfont_load_font(uint16_t id, const char __far *filename) {
     char buf[49];
     int16_t result;
@@ -360,9 +679,21 @@ static int16_t bitmapfont_load_font(uint16_t id, const char __far *filename) {
     uint16_t start_bank = asset_heap_alloc_banks(bank_count);
     result = f_read_rom_banked(&fp, start_bank, f_size(&fp), NULL, NULL);
     f_close(&fp);
+    if (result == FR_OK) {
+        ws_bank_with_rom0(start_bank, {
+            bitmapfont_header_t __far* header = MK_FP(WS_ROM0_SEGMENT, 0x0000);
+            if (header->magic != BITMAPFONT_HEADER_MAGIC
+                || header->version_major != BITMAPFONT_VERSION_MAJOR
+                || header->version_minor > BITMAPFONT_VERSION_MINOR)
+                result = ERR_FILE_FORMAT_INVALID;
+        });
+    }
     if (result == FR_OK) {
         font_banks[id] = start_bank;
         font_offsets[id] = 0x0000;
+        bitmapfont_glyph_cache_clear();
+        // Layouts hold glyph offsets and banks of the previous font.
+        bitmapfont_layout_reset();
     } else {
         asset_heap_free_last_banks(bank_count);
     }
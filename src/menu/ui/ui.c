@@ -17,10 +17,12 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <ws.h>
 #include <ws/display.h>
 #include <wsx/planar_convert.h>
 #include "bitmap.h"
+#include "bootstub.h"
 #include "cart/status.h"
 #include "strings.h"
 #include "ui.h"
@@ -47,6 +49,12 @@ ws_display_tile_4bpp_t bitmap_tiles_c2[512];
 
 bitmap_t ui_bitmap;
 static uint8_t icons_visible;
+// Icon last drawn at each status bar position, to skip unchanged ones
+static uint8_t icons_drawn[WS_DISPLAY_WIDTH_TILES];
+
+static void ui_icons_invalidate(void) {
+    memset(icons_drawn, 0xFF, sizeof(icons_drawn));
+}
 
 void ui_draw_titlebar(const char __far* text) {
     bitmap_rect_fill(&ui_bitmap, 0, 0, screen_width, 8, BITMAP_COLOR_2BPP(2));
@@ -87,6 +95,13 @@ static void ui_draw_icon(int x, int idx) {
     }
 }
 
+static void ui_set_icon(int x, int idx) {
+    if (icons_drawn[x] != idx) {
+        ui_draw_icon(x, idx);
+        icons_drawn[x] = idx;
+    }
+}
+
 uint16_t ui_icon_update(void) {
     if (!icons_visible) return screen_width;
     uint16_t prev_icon_pos = icons_visible;
@@ -96,33 +111,33 @@ uint16_t ui_icon_update(void) {
     bool mcu_data_valid = mcu_present && cart_status.version >= CART_FW_VERSION_1_1_0 && mcu_info_ok;
 
     if (!mcu_present) {
-        ui_draw_icon(--icon_pos, UI_BAR_ICON_MCU_ERROR);
+        ui_set_icon(--icon_pos, UI_BAR_ICON_MCU_ERROR);
     }
 
     if (mcu_data_valid) {
         if (cart_status.mcu_info.status & NILE_MCU_NATIVE_INFO_BATTERY_OK) {
-            ui_draw_icon(--icon_pos, UI_BAR_ICON_BATTERY_3);
+            ui_set_icon(--icon_pos, UI_BAR_ICON_BATTERY_3);
         } else {
-            ui_draw_icon(--icon_pos, UI_BAR_ICON_BATTERY_NONE);
+            ui_set_icon(--icon_pos, UI_BAR_ICON_BATTERY_NONE);
         }
     }
 
     if (!(inportb(WS_SYSTEM_CTRL_PORT) & WS_SYSTEM_CTRL_IPL_LOCK))
-        ui_draw_icon(--icon_pos, UI_BAR_ICON_BOOTROM_UNLOCK);
+        ui_set_icon(--icon_pos, UI_BAR_ICON_BOOTROM_UNLOCK);
 
     if (mcu_data_valid) {
         if (cart_status.mcu_info.status & NILE_MCU_NATIVE_INFO_USB_CONNECT) {
-            ui_draw_icon(--icon_pos, UI_BAR_ICON_USB_CONNECT);
+            ui_set_icon(--icon_pos, UI_BAR_ICON_USB_CONNECT);
         } else if (cart_status.mcu_info.status & NILE_MCU_NATIVE_INFO_USB_DETECT) {
-            ui_draw_icon(--icon_pos, UI_BAR_ICON_USB_DETECT);
+            ui_set_icon(--icon_pos, UI_BAR_ICON_USB_DETECT);
         }
     } else if (cart_status.present & CART_PRESENT_MCU_INFO_ERROR) {
-        ui_draw_icon(--icon_pos, UI_BAR_ICON_MCU_ERROR);
+        ui_set_icon(--icon_pos, UI_BAR_ICON_MCU_ERROR);
     }
 
     if (prev_icon_pos < icon_pos) {
         for (int i = prev_icon_pos; i < icon_pos; i++)
-            ui_draw_icon(i, UI_BAR_ICON_NONE);
+            ui_set_icon(i, UI_BAR_ICON_NONE);
     }
     icons_visible = icon_pos;
 
@@ -131,10 +146,12 @@ uint16_t ui_icon_update(void) {
 
 void ui_hide_icons(void) {
     icons_visible = 0;
+    ui_icons_invalidate();
 }
 
 void ui_draw_statusbar_lr(const char __far* text, const char __far* right_text) {
     icons_visible = right_text == NULL ? (screen_width >> 3) : 0;
+    ui_icons_invalidate();
     uint16_t icon_end = ui_icon_update();
     bitmap_rect_fill(&ui_bitmap, 0, screen_height-8, icon_end, 8, BITMAP_COLOR_2BPP(2));
     if (icon_end < screen_width) {
@@ -166,6 +183,7 @@ void ui_draw_statusbar(const char __far* text) {
 void ui_init(void) {
     ui_hide();
     icons_visible = 0;
+    ui_icons_invalidate();
 
     // initialize palettes
 #ifdef CONFIG_DEBUG_FORCE_MONO
@@ -256,6 +274,8 @@ static inline void load_wallpaper(void) {
     ui_show_inner();
     wallpaper_status = 2;
 
+    uint16_t bank = inportw(WS_CART_EXTBANK_RAM_PORT);
+    bootstub_resident_invalidate(bank, bank + 1);
     ws_bank_with_flash(WS_CART_BANK_FLASH_ENABLE, {
         result = f_read(&fp, MK_FP(0x1000, 0x0000), f_size(&fp), &br);
         f_close(&fp);
@@ -308,6 +328,7 @@ void ui_show(void) {
 
 void ui_layout_clear(uint16_t pal) {
     icons_visible = 0;
+    ui_icons_invalidate();
     if (pal == 0 && !ui_has_wallpaper()) {
         bitmap_rect_fill(&ui_bitmap, 0, 0, screen_width, screen_height, BITMAP_COLOR_4BPP(2));
     } else {
@@ -336,3 +357,86 @@ void ui_screen_modify_tiles(void ws_iram *dest, uint16_t mask, uint16_t value, u
         ws_screen_modify_tiles(dest, mask, value, x, y, width, height);
     }
 }
+
+// The marquee renders a line of text once into the second tile bank, then
+// shows it through screen 1, under a transparent hole in screen 2. Scrolling
+// it only changes the screen 1 scroll register and a ring of 32 map entries.
+#define MARQUEE_BLANK_TILE 511
+
+static struct {
+    bool active;
+    uint8_t band_tiles;
+    uint8_t band_tile_y;
+    uint8_t columns;
+    uint8_t x;
+} marquee;
+
+bool ui_marquee_start(const bitmapfont_layout_t *layout, uint16_t x, uint16_t y, uint32_t suffix) {
+    ui_marquee_stop();
+    if (ws_system_get_mode() != WS_MODE_COLOR_4BPP || ui_has_wallpaper())
+        return false;
+
+    uint16_t band_tiles = ((y & 7) + bitmapfont_get_font_height() + 7) >> 3;
+    uint16_t width = layout->width;
+    if (suffix)
+        width += CONFIG_FONT_CHAR_GAP + bitmapfont_get_char_width(suffix);
+    uint16_t columns = (width + 7) >> 3;
+    if (columns > 255 || (columns * band_tiles) > MARQUEE_BLANK_TILE)
+        return false;
+
+    bitmap_t strip = bitmap_rotation
+        ? BITMAP(bitmap_tiles_c2, columns, band_tiles, 4)
+        : BITMAP(bitmap_tiles_c2, band_tiles, columns, 4);
+    bitmap_rect_fill(&strip, 0, 0, columns << 3, band_tiles << 3, BITMAP_COLOR_4BPP(2));
+    width = bitmapfont_draw_layout_line(&strip, 0, y & 7, layout, 0, 65535);
+    if (suffix)
+        bitmapfont_draw_char(&strip, width + CONFIG_FONT_CHAR_GAP, y & 7, suffix);
+    memset(bitmap_tiles_c2 + MARQUEE_BLANK_TILE, 0, sizeof(ws_display_tile_4bpp_t));
+
+    marquee.band_tiles = band_tiles;
+    marquee.band_tile_y = y >> 3;
+    marquee.columns = columns;
+    marquee.x = x;
+
+    ws_screen_fill_tiles(bitmap_screen1, WS_SCREEN_ATTR_PALETTE(1) | WS_SCREEN_ATTR_BANK(1) | MARQUEE_BLANK_TILE,
+        0, 0, 32, 32);
+    ui_marquee_set_position(0);
+    bitmap_rect_clear(&ui_bitmap, x, y & ~7, screen_width - x, band_tiles << 3);
+    outportb(WS_DISPLAY_CTRL_PORT, inportb(WS_DISPLAY_CTRL_PORT) | WS_DISPLAY_CTRL_SCR1_ENABLE);
+    marquee.active = true;
+    return true;
+}
+
+void ui_marquee_set_position(uint16_t position) {
+    uint16_t first = position >> 3;
+
+    for (uint16_t i = 0; i < 32; i++) {
+        uint16_t column = first + ((i - first) & 31);
+        for (uint16_t j = 0; j < marquee.band_tiles; j++) {
+            uint16_t tile = MARQUEE_BLANK_TILE;
+            if (column < marquee.columns) {
+                tile = bitmap_rotation
+                    ? (column * marquee.band_tiles + j)
+                    : (j * marquee.columns + column);
+            }
+            tile |= WS_SCREEN_ATTR_PALETTE(1) | WS_SCREEN_ATTR_BANK(1);
+            if (bitmap_rotation) {
+                ws_screen_put_tile(bitmap_screen1, tile, i, marquee.band_tile_y + j);
+            } else {
+                ws_screen_put_tile(bitmap_screen1, tile, WS_DISPLAY_WIDTH_TILES - marquee.band_tiles - marquee.band_tile_y + j, i);
+            }
+        }
+    }
+
+    uint8_t scroll = position - marquee.x;
+    outportw(WS_SCR1_SCRL_X_PORT, bitmap_rotation ? scroll : (scroll << 8));
+}
+
+void ui_marquee_stop(void) {
+    if (!marquee.active)
+        return;
+
+    outportb(WS_DISPLAY_CTRL_PORT, inportb(WS_DISPLAY_CTRL_PORT) & ~WS_DISPLAY_CTRL_SCR1_ENABLE);
+    outportw(WS_SCR1_SCRL_X_PORT, 0);
+    marquee.active = false;
+}
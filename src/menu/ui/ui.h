@@ -53,6 +53,13 @@ void ui_hide_icons(void);
 uint16_t ui_icon_update(void);
 void ui_screen_modify_tiles(void ws_iram *dest, uint16_t mask, uint16_t value, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
 
+// Scrolling single line of text, optionally followed by a suffix character,
+// in the selection palette. Only available in color mode without a wallpaper;
+// returns false otherwise.
+bool ui_marquee_start(const bitmapfont_layout_t *layout, uint16_t x, uint16_t y, uint32_t suffix);
+void ui_marquee_set_position(uint16_t position);
+void ui_marquee_stop(void);
+
 static inline uint8_t ui_rgb_to_shade(uint16_t rgb) {
     return (math_color_to_greyscale(rgb) >> 1) ^ 7;
 }
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <nilefs.h>
+#include <stdint.h>
+#include <wonderful.h>
+#include <ws.h>
+#include "bitmap.h"
+#include "lang.h"
+#include "lang_gen.h"
+#include "ui/ui.h"
+#include "util/bench.h"
+#include "util/input.h"
+#include "ui_bench.h"
+
+#define TEXT_X_START 4
+#define TEXT_Y_START 12
+
+static void ui_bench_draw_result(const bench_result_t *result, void *userdata) {
+    int *text_y = (int*) userdata;
+    char buf[48];
+
+    bench_format_result(buf, result);
+    bitmapfont_draw_string(&ui_bitmap, TEXT_X_START, *text_y, buf, screen_width - TEXT_X_START);
+    *text_y += bitmapfont_get_font_height();
+}
+
+int16_t ui_bench(void) {
+    int text_y = TEXT_Y_START;
+
+    ui_layout_bars();
+    ui_draw_titlebar(lang_keys[LK_SUBMENU_OPTION_TOOLS_BENCHMARK]);
+    ui_draw_statusbar(lang_keys[LK_UI_STATUS_RUNNING]);
+    bitmapfont_set_active_font(font8_bitmap);
+
+    int16_t result = bench_run(0, ui_bench_draw_result, &text_y);
+
+    ui_draw_statusbar(NULL);
+    if (result == FR_OK)
+        input_wait_any_key();
+    return result;
+}
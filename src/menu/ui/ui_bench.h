@@ -0,0 +1,26 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UI_BENCH_H_
+#define UI_BENCH_H_
+
+#include <stdint.h>
+#include <wonderful.h>
+
+int16_t ui_bench(void);
+
+#endif /* UI_BENCH_H_ */
@@ -21,7 +21,6 @@
 #include <wonderful.h>
 #include <ws.h>
 #include <nilefs.h>
-#include <wsx/utf8.h>
 #include "bitmap.h"
 #include "cart/mcu.h"
 #include "cart/status.h"
@@ -40,32 +39,13 @@
 #include "../../../build/menu/assets/menu/icons.h"
 #include "lang.h"
 
-#define COMPARE(a, b) (((a) == (b)) ? 0 : (((a) < (b)) ? -1 : 1))
-
+// Only called for name sort modes, when the precomputed sort keys are equal.
 static int compare_filenames(const file_selector_entry_t __far* a, const file_selector_entry_t __far* b, void *userdata) {
     uint8_t mode = (uint8_t) userdata;
-    bool a_dir = a->fno.fattrib & AM_DIR;
-    bool b_dir = b->fno.fattrib & AM_DIR;
-    if (a_dir && !b_dir) {
-        return -1;
-    } else if (!a_dir && b_dir) {
-        return 1;
-    } else switch(mode) {
-        case SETTING_FILE_SORT_NAME_ASC:
-            return strcasecmp(a->fno.fname, b->fno.fname);
-        case SETTING_FILE_SORT_NAME_DESC:
-            return strcasecmp(b->fno.fname, a->fno.fname);
-        case SETTING_FILE_SORT_DATE_ASC:
-            return COMPARE(a->fno.fdate, b->fno.fdate) || COMPARE(a->fno.ftime, b->fno.ftime);
-        case SETTING_FILE_SORT_DATE_DESC:
-            return COMPARE(b->fno.fdate, a->fno.fdate) || COMPARE(b->fno.ftime, a->fno.ftime);
-        case SETTING_FILE_SORT_SIZE_ASC:
-            return COMPARE(a->fno.fsize, b->fno.fsize);
-        case SETTING_FILE_SORT_SIZE_DESC:
-            return COMPARE(b->fno.fsize, a->fno.fsize);
-        default:
-            return 0;
-    }
+    if (mode == SETTING_FILE_SORT_NAME_DESC)
+        return strcasecmp(b->fname, a->fname);
+    else
+        return strcasecmp(a->fname, b->fname);
 }
 
 bool ui_file_selector_default_predicate(const FILINFO __far *fno, const char __far* ext) {
@@ -75,12 +55,8 @@ bool ui_file_selector_default_predicate(const FILINFO __far *fno, const char __f
     }
 
     if (!(settings.file_flags & SETTING_FILE_SHOW_SAVES)) {
-        if (ext != NULL) {
-            if (!strcasecmp(ext, s_file_ext_sram)) return false;
-            if (!strcasecmp(ext, s_file_ext_eeprom)) return false;
-            if (!strcasecmp(ext, s_file_ext_flash)) return false;
-            if (!strcasecmp(ext, s_file_ext_rtc)) return false;
-        }
+        if (file_type_has_flag(file_type_from_extension(ext), FILE_TYPE_FLAG_SAVE))
+            return false;
     }
 
     return true;
@@ -88,30 +64,58 @@ bool ui_file_selector_default_predicate(const FILINFO __far *fno, const char __f
 
 int16_t ui_file_selector_scan_directory(const char *path, filinfo_predicate_t predicate, uint16_t *count) {
     DIR dir;
+    FILINFO fno;
     uint16_t file_count = 0;
+    uint16_t entry_pos = 0;
     *count = 0;
 
     uint8_t result = f_opendir(&dir, path);
 	if (result != FR_OK)
 		return result;
+
+    // Only the default file listing is cached.
+    uint32_t dir_cluster = dir.obj.sclust;
+    bool use_cache = predicate == ui_file_selector_default_predicate;
+    if (use_cache && ui_file_selector_cache_load(dir_cluster, count)) {
+        f_closedir(&dir);
+        return FR_OK;
+    }
+
 	while (true) {
-        file_selector_entry_t __far* fno = ui_file_selector_open_fno_direct(file_count);
-		result = f_readdir(&dir, &fno->fno);
+		result = f_readdir(&dir, &fno);
 
         // Invalid/empty result?
 		if (result != FR_OK) {
             f_closedir(&dir);
             return result;
         }
-		if (fno->fno.fname[0] == 0)
+		if (fno.fname[0] == 0)
 			break;
 
-  		const char __far* ext_loc = (fno->fno.fattrib & AM_DIR) ? NULL : strrchr(fno->fno.fname, '.');
-  		if (!predicate(&fno->fno, ext_loc))
+  		const char __far* ext_loc = (fno.fattrib & AM_DIR) ? NULL : strrchr(fno.fname, '.');
+  		if (!predicate(&fno, ext_loc))
             continue;
 
-        // Cache extension location
-        fno->extension_loc = ext_loc == NULL ? 255 : ext_loc - fno->fno.fname;
+        // Allocate a record which does not cross a bank boundary
+        uint8_t name_len = strlen(fno.fname);
+        uint16_t entry_units = (sizeof(file_selector_entry_t) + name_len + 1 + (1 << FILE_SELECTOR_ENTRY_SHIFT) - 1) >> FILE_SELECTOR_ENTRY_SHIFT;
+        if (((entry_pos & ((1 << FILE_SELECTOR_ENTRY_BANK_SHIFT) - 1)) + entry_units) > (1 << FILE_SELECTOR_ENTRY_BANK_SHIFT))
+            entry_pos = (entry_pos | ((1 << FILE_SELECTOR_ENTRY_BANK_SHIFT) - 1)) + 1;
+        if (entry_pos + entry_units > FILE_SELECTOR_ENTRY_AREA_END)
+            break;
+
+        file_selector_entry_t __far* entry = ui_file_selector_open_fno_direct(entry_pos);
+        entry->fsize = fno.fsize;
+        entry->fdate = fno.fdate;
+        entry->ftime = fno.ftime;
+        entry->fattrib = fno.fattrib;
+        entry->type = (fno.fattrib & AM_DIR) ? FILE_TYPE_DIRECTORY : file_type_from_extension(ext_loc);
+        entry->name_len = name_len;
+        memcpy(entry->fname, fno.fname, name_len + 1);
+
+        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+        ui_file_selector_sort_key_init(FILE_SELECTOR_SORT_KEYS + file_count, &fno, entry_pos, file_count, settings.file_sort);
+        entry_pos += entry_units;
 
         file_count++;
         if (file_count >= FILE_SELECTOR_MAX_FILES)
@@ -119,38 +123,17 @@ int16_t ui_file_selector_scan_directory(const char *path, filinfo_predicate_t pr
 	}
 	f_closedir(&dir);
 
-    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
-    for (int i = 0; i < file_count; i++)
-        FILE_SELECTOR_INDEXES[i] = i;
-    ui_file_selector_qsort(file_count, compare_filenames, (void*) settings.file_sort);
+    ui_file_selector_qsort(file_count,
+        ui_file_selector_sort_key_is_exact(settings.file_sort) ? NULL : compare_filenames,
+        (void*) settings.file_sort);
+
+    if (use_cache)
+        ui_file_selector_cache_store(dir_cluster, file_count, entry_pos);
 
     *count = file_count;
     return FR_OK;
 }
 
-int ui_file_selector_get_file_icon_idx(const char __far *ext) {
-    if (ext != NULL) {
-        if (!strcasecmp(ext, s_file_ext_ws) || !strcasecmp(ext, s_file_ext_wsc) || !strcasecmp(ext, s_file_ext_pc2)) {
-            return 2;
-        } else if (!strcasecmp(ext, s_file_ext_fx)) {
-            return 9;
-        } else if (!strcasecmp(ext, s_file_ext_zip)) {
-            return 8;
-        } else if (!strcasecmp(ext, s_file_ext_fr) || !strcasecmp(ext, s_file_ext_il)) {
-            return 7;
-        } else if (!strcasecmp(ext, s_file_ext_wav) || !strcasecmp(ext, s_file_ext_vgm) || !strcasecmp(ext, s_file_ext_vgz)) {
-            return 4;
-        } else if (!strcasecmp(ext, s_file_ext_bmp)) {
-            return 3;
-        } else if (!strcasecmp(ext, s_file_ext_bfb)) {
-            return 5;
-        } else if (!strcasecmp(ext, s_file_ext_com)) {
-            return 6;
-        }
-    }
-    return 1;
-}
-
 void ui_file_selector_draw_icon(uint16_t x, uint16_t y, uint16_t icon_idx, uint16_t style) {
     uint16_t tile_idx = bitmap_rotation ? ((y >> 3) + ((x >> 3) * 18)) : ((((WS_DISPLAY_WIDTH_TILES - (style == UI_SELECTOR_STYLE_16 ? 2 : 1)) - (y >> 3)) * 18) + (x >> 3));
     if (style == UI_SELECTOR_STYLE_16) {
@@ -174,50 +157,94 @@ void ui_file_selector_draw_icon(uint16_t x, uint16_t y, uint16_t icon_idx, uint1
     }
 }
 
-static void ui_file_selector_draw(struct ui_selector_config *config, uint16_t offset, uint16_t y, uint16_t scroll_tick) {
-    int x_offset;
+static inline int ui_file_selector_x_offset(struct ui_selector_config *config) {
     if (settings.file_flags & SETTING_FILE_HIDE_ICONS)
-        x_offset = 2;
+        return 2;
     else
-        x_offset = config->style == UI_SELECTOR_STYLE_16 ? 16 : 10;
+        return config->style == UI_SELECTOR_STYLE_16 ? 16 : 10;
+}
 
+// Layout of the most recently scrolled entry; reused by the scrolling and
+// highlight redraws of that row.
+static bitmapfont_layout_t scroll_layout;
+static uint16_t scroll_layout_offset = 0xFFFF;
+static uint16_t scroll_width;
+static bool scroll_is_directory;
+static bool scroll_marquee;
+
+static void ui_file_selector_draw(struct ui_selector_config *config, uint16_t offset, uint16_t y, uint16_t scroll_tick) {
+    int x_offset = ui_file_selector_x_offset(config);
     file_selector_entry_t __far *fno = ui_file_selector_open_fno(offset);
 
-    const char __far *s = fno->fno.fname;
     int max_width = screen_width - x_offset;
-    if (scroll_tick) {
-        int width = bitmapfont_get_string_width(s, 65535);
-        if (width <= max_width)
-            scroll_tick = 0;
-        else {
-            int width_cropped = width;
-            while (width_cropped > max_width) {
-                width_cropped -= bitmapfont_get_char_width(wsx_utf8_decode_next(&s)) + CONFIG_FONT_CHAR_GAP;
-            }
-            int tick_count = (s - fno->fno.fname) + 2;
-            scroll_tick %= (tick_count + 8);
-            if (scroll_tick > tick_count) scroll_tick = 0;
+    uint16_t x;
 
-            s = fno->fno.fname;
-            while (scroll_tick--)
-                wsx_utf8_decode_next(&s);
-
-            while (inportb(WS_DISPLAY_LINE_PORT) != (y + bitmapfont_get_font_height() - 1));
-            bitmap_rect_fill(&ui_bitmap, x_offset & ~7, y, screen_width - (x_offset & ~7), bitmapfont_get_font_height(), BITMAP_COLOR_2BPP(ui_has_wallpaper() ? 0 : 2));
-        }
+    if (scroll_layout_offset == offset && bitmapfont_layout_is_valid(&scroll_layout)) {
+        x = x_offset + bitmapfont_draw_layout_line(&ui_bitmap, x_offset, y, &scroll_layout, 0, max_width);
+    } else {
+        x = x_offset + bitmapfont_draw_string(&ui_bitmap, x_offset, y, fno->fname, max_width);
     }
-
-    uint16_t x = x_offset + bitmapfont_draw_string(&ui_bitmap, x_offset, y, s, max_width);
-    uint8_t icon_idx = 1;
-    if (fno->fno.fattrib & AM_DIR) {
-        icon_idx = 0;
+    if (fno->type == FILE_TYPE_DIRECTORY) {
         bitmapfont_draw_char(&ui_bitmap, x + CONFIG_FONT_CHAR_GAP, y, '/');
-    } else if (FILE_SELECTOR_ENTRY_HAS_EXTENSION(fno)) {
-        icon_idx = ui_file_selector_get_file_icon_idx(FILE_SELECTOR_ENTRY_GET_EXTENSION(fno));
     }
 
     if (!(settings.file_flags & SETTING_FILE_HIDE_ICONS)) {
-        ui_file_selector_draw_icon(0, y, icon_idx, config->style);
+        ui_file_selector_draw_icon(0, y, file_type_get_icon(fno->type), config->style);
+    }
+}
+
+// Marquee: frames per pixel (as a shift), and frames to hold at either end.
+#define SCROLL_PIXEL_SHIFT 2
+#define SCROLL_HOLD_TICKS 64
+// Without a marquee: frames per character (as a shift).
+#define SCROLL_CHAR_SHIFT 5
+#define SCROLL_CHAR_MASK ((1 << (SCROLL_CHAR_SHIFT)) - 1)
+
+static void ui_file_selector_scroll(struct ui_selector_config *config, uint16_t offset, uint16_t y, uint16_t scroll_tick) {
+    int x_offset = ui_file_selector_x_offset(config);
+    int max_width = screen_width - x_offset;
+
+    if (scroll_tick == 1 || scroll_layout_offset != offset || !bitmapfont_layout_is_valid(&scroll_layout)) {
+        file_selector_entry_t __far *fno = ui_file_selector_open_fno(offset);
+        bitmapfont_layout_reset();
+        bitmapfont_layout_string(&scroll_layout, fno->fname);
+        scroll_layout_offset = offset;
+        scroll_is_directory = fno->type == FILE_TYPE_DIRECTORY;
+        scroll_width = scroll_layout.width;
+        if (scroll_is_directory)
+            scroll_width += CONFIG_FONT_CHAR_GAP + bitmapfont_get_char_width('/');
+
+        scroll_marquee = scroll_width > max_width
+            && scroll_layout.line_count != BITMAPFONT_LAYOUT_OVERFLOW
+            && ui_marquee_start(&scroll_layout, x_offset, y, scroll_is_directory ? '/' : 0);
+    }
+    if (scroll_width <= max_width)
+        return;
+
+    if (scroll_marquee) {
+        uint16_t max_position = scroll_width - max_width;
+        uint16_t tick = scroll_tick % ((max_position << SCROLL_PIXEL_SHIFT) + (SCROLL_HOLD_TICKS * 2));
+        uint16_t position = 0;
+        if (tick >= SCROLL_HOLD_TICKS)
+            position = MIN((tick - SCROLL_HOLD_TICKS) >> SCROLL_PIXEL_SHIFT, max_position);
+        ui_marquee_set_position(position);
+    } else if (!(scroll_tick & SCROLL_CHAR_MASK)) {
+        // Redrawn right after VBlank, by skipping whole characters.
+        const bitmapfont_layout_glyph_t *glyph = scroll_layout.glyphs;
+        int width_cropped = scroll_width;
+        uint16_t tick_count = 2;
+        while (width_cropped > max_width && tick_count < scroll_layout.glyph_count) {
+            width_cropped -= (glyph++)->width + CONFIG_FONT_CHAR_GAP;
+            tick_count++;
+        }
+        uint16_t first = (scroll_tick >> SCROLL_CHAR_SHIFT) % (tick_count + 8);
+        if (first > tick_count) first = 0;
+
+        bitmap_rect_fill(&ui_bitmap, x_offset & ~7, y, screen_width - (x_offset & ~7), bitmapfont_get_font_height(), BITMAP_COLOR_2BPP(ui_has_wallpaper() ? 0 : 2));
+        uint16_t x = x_offset + bitmapfont_draw_layout_line(&ui_bitmap, x_offset, y, &scroll_layout, first, max_width);
+        if (scroll_is_directory) {
+            bitmapfont_draw_char(&ui_bitmap, x + CONFIG_FONT_CHAR_GAP, y, '/');
+        }
     }
 }
 
@@ -236,6 +263,7 @@ void ui_file_selector(void) {
 
 rescan_directory:
     config.draw = ui_file_selector_draw;
+    config.scroll = ui_file_selector_scroll;
     config.key_mask = WS_KEY_A | WS_KEY_B | WS_KEY_START;
     config.style = settings.file_view;
 
@@ -283,7 +311,9 @@ rescan_directory:
         ui_draw_titlebar(draw_path);
     }
     if (reinit_dirs) {
+        scroll_layout_offset = 0xFFFF;
         config.offset = path_depth_pos >= CONFIG_FILESELECT_PATH_MEMORY_DEPTH ? 0 : path_depth[path_depth_pos];
+        config.top = 0;
         strcpy(strbuf, s_dot);
         int16_t result = ui_file_selector_scan_directory(strbuf, ui_file_selector_default_predicate, &config.count);
         if (ui_dialog_error_check(result, NULL, 0)) {
@@ -309,83 +339,79 @@ rescan_directory:
             path_depth[path_depth_pos] = config.offset;
 
             file_selector_entry_t __far *fno = ui_file_selector_open_fno(config.offset);
-            strncpy(strbuf, fno->fno.fname, sizeof(fno->fno.fname));
-            if (fno->fno.fattrib & AM_DIR) {
+            strcpy(strbuf, fno->fname);
+            uint8_t type = fno->type;
+            if (type == FILE_TYPE_DIRECTORY) {
                 path_depth[++path_depth_pos] = 0;
                 f_chdir(strbuf);
             } else {
                 ui_selector_clear_selection(&config);
-                if (FILE_SELECTOR_ENTRY_HAS_EXTENSION(fno)) {
-                    const char __far* ext = FILE_SELECTOR_ENTRY_GET_EXTENSION(fno);
-                    if (!strcasecmp(ext, s_file_ext_ws) || !strcasecmp(ext, s_file_ext_wsc) || !strcasecmp(ext, s_file_ext_pc2)) {
-                        launch_rom_metadata_t meta;
-                        int16_t result = launch_get_rom_metadata(strbuf, &meta);
+                switch (type) {
+                case FILE_TYPE_ROM: {
+                    launch_rom_metadata_t meta;
+                    int16_t result = launch_get_rom_metadata(strbuf, &meta);
+                    if (result == FR_OK) {
+                        result = launch_restore_save_data(strbuf, &meta);
+                        reinit_dirs = true;
+                        if (result == ERR_MCU_COMM_FAILED) {
+                            if (launch_ui_handle_mcu_comm_error(&meta))
+                                result = FR_OK;
+                            else
+                                goto exit_no_launch;
+                        } else {
+                            if (launch_is_battery_required(&meta))
+                                if (cart_status_mcu_info_valid() && !cart_status_mcu_battery_ok())
+                                    if (!launch_ui_handle_battery_missing_error(&meta))
+                                        goto exit_no_launch;
+                        }
                         if (result == FR_OK) {
-                            result = launch_restore_save_data(strbuf, &meta);
-                            reinit_dirs = true;
-                            if (result == ERR_MCU_COMM_FAILED) {
-                                if (launch_ui_handle_mcu_comm_error(&meta))
-                                    result = FR_OK;
-                                else
-                                    goto exit_no_launch;
-                            } else {
-                                if (launch_is_battery_required(&meta))
-                                    if (cart_status_mcu_info_valid() && !cart_status_mcu_battery_ok())
-                                        if (!launch_ui_handle_battery_missing_error(&meta))
-                                            goto exit_no_launch;
-                            }
+                            result = launch_set_bootstub_file_entry(strbuf, &bootstub_data->prog);
                             if (result == FR_OK) {
-                                result = launch_set_bootstub_file_entry(strbuf, &bootstub_data->prog);
-                                if (result == FR_OK) {
-                                    result = launch_rom_via_bootstub(&meta);
-                                }
+                                result = launch_rom_via_bootstub(&meta);
                             }
                         }
+                    }
 
-                        ui_dialog_error_check(result, NULL, 0);
+                    ui_dialog_error_check(result, NULL, 0);
 exit_no_launch:
-                        mcu_reset_if_not_native();
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else if (!strcasecmp(ext, s_file_ext_fx) || !strcasecmp(ext, s_file_ext_bin)) {
-                        // TODO: Do some checks on the .bin file
-                        ui_dialog_error_check(launch_athena_boot_curdir_as_rom_wip(fno->fno.fname), NULL, 0);
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else if (!strcasecmp(ext, s_file_ext_vgm) || !strcasecmp(ext, s_file_ext_vgz)) {
-                        ui_dialog_error_check(ui_vgmplay(strbuf), NULL, 0);
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else if (!strcasecmp(ext, s_file_ext_wav)) {
-                        ui_dialog_error_check(ui_wavplay(strbuf), NULL, 0);
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else if (!strcasecmp(ext, s_file_ext_bmp)) {
-                        ui_dialog_error_check(ui_bmpview(strbuf), NULL, 0);
-                    } else if (!strcasecmp(ext, s_file_ext_bfb)) {
-                        ui_selector_clear_selection(&config);
-                        int option = ui_file_selector_actions_bfb();
-                        if (option == 0) {
-                            ui_dialog_error_check(launch_bfb(strbuf), NULL, 0);
-                        }
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else if (!strcasecmp(ext, s_file_ext_com)) {
-                        ui_selector_clear_selection(&config);
-                        ui_dialog_error_check(launch_com(strbuf), NULL, 0);
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else if (!strcasecmp(ext, s_file_ext_rom)) {
-                        ui_selector_clear_selection(&config);
-                        ui_dialog_error_check(launch_plugin_via_ipc(s_path_plugin_uxn, strbuf), NULL, 0);
-                        reinit_ui = true;
-                        goto rescan_directory;
-                    } else {
-                        goto txtview;
+                    mcu_reset_if_not_native();
+                    reinit_ui = true;
+                    goto rescan_directory;
+                }
+                case FILE_TYPE_ATHENA_PROGRAM:
+                case FILE_TYPE_ATHENA_BINARY:
+                    // TODO: Do some checks on the .bin file
+                    ui_dialog_error_check(launch_athena_boot_curdir_as_rom_wip(strbuf), NULL, 0);
+                    reinit_ui = true;
+                    goto rescan_directory;
+                case FILE_TYPE_VGM:
+                    ui_dialog_error_check(ui_vgmplay(strbuf), NULL, 0);
+                    reinit_ui = true;
+                    goto rescan_directory;
+                case FILE_TYPE_WAV:
+                    ui_dialog_error_check(ui_wavplay(strbuf), NULL, 0);
+                    reinit_ui = true;
+                    goto rescan_directory;
+                case FILE_TYPE_BMP:
+                    ui_dialog_error_check(ui_bmpview(strbuf), NULL, 0);
+                    break;
+                case FILE_TYPE_BFB: {
+                    int option = ui_file_selector_actions_bfb();
+                    if (option == 0) {
+                        ui_dialog_error_check(launch_bfb(strbuf), NULL, 0);
                     }
-                } else {
-txtview:
-                    ui_selector_clear_selection(&config);
+                    reinit_ui = true;
+                    goto rescan_directory;
+                }
+                case FILE_TYPE_COM:
+                    ui_dialog_error_check(launch_com(strbuf), NULL, 0);
+                    reinit_ui = true;
+                    goto rescan_directory;
+                case FILE_TYPE_UXN:
+                    ui_dialog_error_check(launch_plugin_via_ipc(s_path_plugin_uxn, strbuf), NULL, 0);
+                    reinit_ui = true;
+                    goto rescan_directory;
+                default:
                     ui_dialog_error_check(ui_txtview(strbuf), NULL, 0);
                     reinit_ui = true;
                     goto rescan_directory;
@@ -411,7 +437,7 @@ txtview:
             file_selector_entry_t __far *fno = ui_file_selector_open_fno(config.offset);
 
             ui_selector_clear_selection(&config);
-            if (ui_file_selector_options(fno->fno.fname, fno->fno.fattrib)) {
+            if (ui_file_selector_options(fno->fname, fno->fattrib, fno->type)) {
                 reinit_dirs = true;
             }
             reinit_ui = true;
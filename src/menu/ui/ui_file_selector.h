@@ -21,31 +21,56 @@
 #include <ws.h>
 #include <nilefs.h>
 #include "ui.h"
+#include "ui_file_type.h"
 #include "ui_selector.h"
 #include "../util/file.h"
 
-#define FILE_SELECTOR_ENTRY_SHIFT 8
-#define FILE_SELECTOR_MAX_FILES 1524
+// Directory entries are stored as variable-length records in SRAM, starting
+// at bank FILE_SELECTOR_RAM_BANK_OFFSET. Records are aligned to 16 bytes and
+// never cross a bank boundary, which allows addressing them with a 16-bit
+// value (4 bits of bank, 12 bits of 16-byte unit offset).
+#define FILE_SELECTOR_ENTRY_SHIFT 4
+#define FILE_SELECTOR_ENTRY_BANK_SHIFT 12
+#define FILE_SELECTOR_MAX_FILES 4096
 #define FILE_SELECTOR_RAM_BANK_OFFSET 1
 #define FILE_SELECTOR_INDEX_BANK 6
-#define FILE_SELECTOR_INDEXES ((uint16_t __far*) MK_FP(0x1000, 0xF410))
+#define FILE_SELECTOR_SORT_KEY_OFFSET 0x6000
+#define FILE_SELECTOR_SORT_KEYS ((file_selector_sort_key_t __far*) MK_FP(0x1000, FILE_SELECTOR_SORT_KEY_OFFSET))
+#define FILE_SELECTOR_INDEX_OFFSET 0xE000
+#define FILE_SELECTOR_INDEXES ((uint16_t __far*) MK_FP(0x1000, FILE_SELECTOR_INDEX_OFFSET))
+// End of the record area, in 16-byte units.
+#define FILE_SELECTOR_ENTRY_AREA_END (((FILE_SELECTOR_INDEX_BANK - FILE_SELECTOR_RAM_BANK_OFFSET) << FILE_SELECTOR_ENTRY_BANK_SHIFT) | (FILE_SELECTOR_SORT_KEY_OFFSET >> FILE_SELECTOR_ENTRY_SHIFT))
 
-typedef struct {
-    FILINFO fno;
-    uint8_t extension_loc;
+typedef struct __attribute__((packed)) {
+    uint32_t fsize;
+    uint16_t fdate;
+    uint16_t ftime;
+    uint8_t fattrib;
+    uint8_t type;
+    uint8_t name_len;
+    char fname[];
 } file_selector_entry_t;
 
-#define FILE_SELECTOR_ENTRY_HAS_EXTENSION(entry) ((entry)->extension_loc != 255)
-#define FILE_SELECTOR_ENTRY_GET_EXTENSION(entry) ((entry)->fno.fname + (entry)->extension_loc)
+// Sort keys are stored in the same bank as the index array, so that most
+// comparisons do not have to touch the records themselves. The key holds
+// six bytes, compared as three big-endian words: the directory flag,
+// followed by the first five case-folded name bytes, the date and time,
+// the file size or the directory position, depending on the sort mode.
+typedef struct {
+    uint16_t key[3];
+    uint16_t entry;
+} file_selector_sort_key_t;
+
+#define FILE_SELECTOR_ENTRY_SIZE(entry) (sizeof(file_selector_entry_t) + (entry)->name_len + 1)
 
 __attribute__((always_inline))
 static inline bool ui_file_selector_fno_direct_same_bank(uint16_t a, uint16_t b) {
-    return (a >> FILE_SELECTOR_ENTRY_SHIFT) == (b >> FILE_SELECTOR_ENTRY_SHIFT);
+    return (a >> FILE_SELECTOR_ENTRY_BANK_SHIFT) == (b >> FILE_SELECTOR_ENTRY_BANK_SHIFT);
 }
 
 __attribute__((always_inline))
 static inline file_selector_entry_t __far *ui_file_selector_open_fno_direct(uint16_t offset) {
-    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_RAM_BANK_OFFSET + (offset >> FILE_SELECTOR_ENTRY_SHIFT));
+    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_RAM_BANK_OFFSET + (offset >> FILE_SELECTOR_ENTRY_BANK_SHIFT));
     return MK_FP(0x1000, offset << FILE_SELECTOR_ENTRY_SHIFT);
 }
 
@@ -60,18 +85,23 @@ static inline file_selector_entry_t __far *ui_file_selector_open_fno(uint16_t of
     return ui_file_selector_open_fno_direct(FILE_SELECTOR_INDEXES[offset]);
 }
 
-int ui_file_selector_get_file_icon_idx(const char __far *ext);
 void ui_file_selector_draw_icon(uint16_t x, uint16_t y, uint16_t icon_idx, uint16_t style);
 
 void ui_file_selector(void);
 bool ui_file_selector_default_predicate(const FILINFO __far *fno, const char __far *ext);
 int16_t ui_file_selector_scan_directory(const char *path, filinfo_predicate_t predicate, uint16_t *count);
 
+// ui_file_selector_cache.c
+bool ui_file_selector_cache_load(uint32_t cluster, uint16_t *count);
+void ui_file_selector_cache_store(uint32_t cluster, uint16_t count, uint16_t entry_area_size);
+
 // ui_file_selector_options.c
 int ui_file_selector_actions_bfb(void);
-bool ui_file_selector_options(const char __far *filename, uint8_t attrib);
+bool ui_file_selector_options(const char __far *filename, uint8_t attrib, uint8_t type);
 
 // ui_file_selector_qsort.c
+bool ui_file_selector_sort_key_is_exact(uint8_t mode);
+void ui_file_selector_sort_key_init(file_selector_sort_key_t __far *key, const FILINFO *fno, uint16_t entry, uint16_t position, uint8_t mode);
 void ui_file_selector_qsort(size_t nmemb, int (*compar)(const file_selector_entry_t __far*, const file_selector_entry_t __far*, void*), void *userdata);
 
 #endif /* __UI_FILE_SELECTOR_H__ */
@@ -0,0 +1,240 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <wonderful.h>
+#include <ws.h>
+#include <nilefs.h>
+#include "fs.h"
+#include "settings.h"
+#include "strings.h"
+#include "ui_file_selector.h"
+#include "util/file.h"
+#include "util/hash/crc32.h"
+
+// The directory listing cache stores the most recently scanned (large)
+// directory on the storage card, already filtered and sorted.
+//
+// It is validated by a CRC-32 of the raw directory table, which avoids
+// the long filename decoding, entry copies and sorting of a full scan.
+// Only fields which affect the listing for the current sort mode are
+// hashed, so that save files being written back by the menu on boot
+// do not invalidate the cache for the directory containing the game.
+
+#define FILE_SELECTOR_CACHE_MAGIC 0x34435344 /* DSC4 */
+#define FILE_SELECTOR_CACHE_FILTER_FLAGS (SETTING_FILE_SHOW_HIDDEN | SETTING_FILE_SHOW_SAVES)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t cluster;
+    uint32_t signature;
+    uint16_t count;
+    uint16_t entry_area_size;
+    uint8_t sort;
+    uint8_t filter_flags;
+} file_selector_cache_header_t;
+
+#define DIR_ENTRY_SIZE 32
+#define DIR_ENTRY_ATTR 11
+#define DIR_ENTRY_WRITE_TIME 22
+#define DIR_ENTRY_FILE_SIZE 28
+#define DIR_ENTRY_DELETED 0xE5
+#define DIR_ENTRY_ATTR_LFN 0x0F
+
+typedef struct {
+    uint32_t crc;
+    uint8_t sort;
+    bool finished;
+} dir_signature_t;
+
+static void dir_signature_update(dir_signature_t *sig, const uint8_t *data, uint16_t len) {
+    for (; len >= DIR_ENTRY_SIZE; len -= DIR_ENTRY_SIZE, data += DIR_ENTRY_SIZE) {
+        if (data[0] == 0) {
+            // End of directory table
+            sig->finished = true;
+            return;
+        }
+        if (data[0] == DIR_ENTRY_DELETED)
+            continue;
+
+        if ((data[DIR_ENTRY_ATTR] & 0x3F) == DIR_ENTRY_ATTR_LFN) {
+            sig->crc = crc32_update(sig->crc, DIR_ENTRY_SIZE, data);
+            continue;
+        }
+
+        // Short name and attributes
+        sig->crc = crc32_update(sig->crc, DIR_ENTRY_ATTR + 1, data);
+        switch (sig->sort) {
+        case SETTING_FILE_SORT_DATE_ASC:
+        case SETTING_FILE_SORT_DATE_DESC:
+            sig->crc = crc32_update(sig->crc, 4, data + DIR_ENTRY_WRITE_TIME);
+            break;
+        case SETTING_FILE_SORT_SIZE_ASC:
+        case SETTING_FILE_SORT_SIZE_DESC:
+            sig->crc = crc32_update(sig->crc, 4, data + DIR_ENTRY_FILE_SIZE);
+            break;
+        }
+    }
+}
+
+static bool dir_signature_read(dir_signature_t *sig, LBA_t sector, uint16_t sectors) {
+    const uint8_t *buffer;
+    uint16_t count;
+
+    while (sectors && !sig->finished) {
+        if (sector_buffer_is_active()) {
+            count = sectors > (sizeof(sector_buffer) >> 9) ? (sizeof(sector_buffer) >> 9) : sectors;
+            if (disk_read(fs.pdrv, sector_buffer, sector, count) != RES_OK)
+                return false;
+            buffer = sector_buffer;
+        } else {
+            // The stack buffer cannot hold a sector; go through the FatFs window.
+            count = 1;
+            buffer = fs_read_sector(sector);
+            if (buffer == NULL)
+                return false;
+        }
+        dir_signature_update(sig, buffer, count << 9);
+        sector += count;
+        sectors -= count;
+    }
+    return true;
+}
+
+static bool ui_file_selector_cache_signature(uint32_t cluster, uint32_t *signature) {
+    dir_signature_t sig;
+
+    // Raw sector reads would not see pending FatFs writes.
+    if (fs.wflag)
+        return false;
+
+    sig.crc = CRC32_INIT;
+    sig.sort = settings.file_sort;
+    sig.finished = false;
+    if (cluster == 0 && fs.fs_type != FS_FAT32) {
+        // FAT12/FAT16 root directory
+        if (!dir_signature_read(&sig, fs.dirbase, fs.n_rootdir >> 4))
+            return false;
+    } else {
+        if (cluster == 0)
+            cluster = fs.dirbase;
+        while (!sig.finished && fs_is_valid_cluster(cluster)) {
+            if (!dir_signature_read(&sig, fs_cluster_to_sector(cluster), fs.csize))
+                return false;
+            cluster = fs_get_next_cluster(cluster);
+            if (cluster == FS_CLUSTER_ERROR)
+                return false;
+        }
+    }
+
+    *signature = crc32_final(sig.crc);
+    return true;
+}
+
+bool ui_file_selector_cache_load(uint32_t cluster, uint16_t *count) {
+    FIL fp;
+    file_selector_cache_header_t header;
+    unsigned int br;
+    uint32_t signature;
+    bool loaded = false;
+
+    if (f_open_far(&fp, s_path_dircache, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+        return false;
+
+    if (f_read(&fp, &header, sizeof(header), &br) != FR_OK || br != sizeof(header))
+        goto ui_file_selector_cache_load_end;
+    if (header.magic != FILE_SELECTOR_CACHE_MAGIC
+        || header.cluster != cluster
+        || header.sort != settings.file_sort
+        || header.filter_flags != (settings.file_flags & FILE_SELECTOR_CACHE_FILTER_FLAGS)
+        || header.count > FILE_SELECTOR_MAX_FILES
+        || header.entry_area_size > FILE_SELECTOR_ENTRY_AREA_END)
+        goto ui_file_selector_cache_load_end;
+    if (!ui_file_selector_cache_signature(cluster, &signature) || header.signature != signature)
+        goto ui_file_selector_cache_load_end;
+
+    if (f_read_sram_banked(&fp, FILE_SELECTOR_RAM_BANK_OFFSET, (uint32_t) header.entry_area_size << FILE_SELECTOR_ENTRY_SHIFT, NULL, NULL) != FR_OK)
+        goto ui_file_selector_cache_load_end;
+    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+    if (f_read(&fp, FILE_SELECTOR_INDEXES, header.count * sizeof(uint16_t), &br) != FR_OK || br != header.count * sizeof(uint16_t))
+        goto ui_file_selector_cache_load_end;
+
+    *count = header.count;
+    loaded = true;
+
+ui_file_selector_cache_load_end:
+    f_close(&fp);
+    return loaded;
+}
+
+void ui_file_selector_cache_store(uint32_t cluster, uint16_t count, uint16_t entry_area_size) {
+    FIL fp;
+    file_selector_cache_header_t header;
+    uint8_t stack_buffer[CONFIG_MEMLAYOUT_STACK_BUFFER_SIZE];
+    uint8_t *buffer;
+    uint16_t buffer_size;
+    unsigned int bw;
+
+    if (count < CONFIG_FILESELECT_CACHE_MIN_FILES)
+        return;
+    if (!ui_file_selector_cache_signature(cluster, &header.signature))
+        return;
+
+    if (sector_buffer_is_active()) {
+        buffer = sector_buffer;
+        buffer_size = sizeof(sector_buffer);
+    } else {
+        buffer = stack_buffer;
+        buffer_size = sizeof(stack_buffer);
+    }
+
+    if (f_open_far(&fp, s_path_dircache, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+        return;
+
+    // Write an invalid header first, so that an interrupted write
+    // is never mistaken for a valid cache.
+    header.magic = 0;
+    header.cluster = cluster;
+    header.count = count;
+    header.entry_area_size = entry_area_size;
+    header.sort = settings.file_sort;
+    header.filter_flags = settings.file_flags & FILE_SELECTOR_CACHE_FILTER_FLAGS;
+    if (f_write(&fp, &header, sizeof(header), &bw) != FR_OK)
+        goto ui_file_selector_cache_store_end;
+
+    if (f_write_sram_banked(&fp, FILE_SELECTOR_RAM_BANK_OFFSET, (uint32_t) entry_area_size << FILE_SELECTOR_ENTRY_SHIFT, NULL, NULL, false) != FR_OK)
+        goto ui_file_selector_cache_store_end;
+
+    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+    for (uint16_t i = 0; i < count * sizeof(uint16_t); i += buffer_size) {
+        uint16_t len = count * sizeof(uint16_t) - i;
+        if (len > buffer_size)
+            len = buffer_size;
+        _fmemcpy(buffer, ((uint8_t __far*) FILE_SELECTOR_INDEXES) + i, len);
+        if (f_write(&fp, buffer, len, &bw) != FR_OK)
+            goto ui_file_selector_cache_store_end;
+    }
+
+    header.magic = FILE_SELECTOR_CACHE_MAGIC;
+    if (f_lseek(&fp, 0) != FR_OK)
+        goto ui_file_selector_cache_store_end;
+    f_write(&fp, &header, sizeof(header), &bw);
+
+ui_file_selector_cache_store_end:
+    f_close(&fp);
+}
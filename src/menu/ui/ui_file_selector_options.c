@@ -27,7 +27,9 @@
 #include "strings.h"
 #include "ui/ui.h"
 #include "ui_about.h"
+#include "ui_bench.h"
 #include "ui_dialog.h"
+#include "ui_file_type.h"
 #include "ui_fileops.h"
 #include "ui_popup_list.h"
 #include "ui_settings.h"
@@ -47,19 +49,19 @@ int ui_file_selector_actions_bfb(void) {
     return ui_popup_list(&lst);
 }
 
-static enum tristate ui_file_selector_tools_witch(ui_popup_list_config_t *lst, const char __far *filename) {
+static enum tristate ui_file_selector_tools_witch(ui_popup_list_config_t *lst, const char __far *filename, uint8_t type) {
     while (true) {
         memset(lst, 0, sizeof(ui_popup_list_config_t));
         uint8_t i = 0;
         uint8_t options[4];
-        if (fileops_has_rom_contents(filename)) {
+        if (file_type_has_flag(type, FILE_TYPE_FLAG_ROM_CONTENTS)) {
             options[i] = 0;
             lst->option[i++] = lang_keys[LK_SUBMENU_OPTION_WITCH_REPLACE_BIOS];
             options[i] = 1;
             lst->option[i++] = lang_keys[LK_SUBMENU_OPTION_WITCH_REPLACE_OS];
             options[i] = 2;
             lst->option[i++] = lang_keys[LK_SUBMENU_OPTION_WITCH_EXTRACT_BIOS_OS];
-        } else if (fileops_has_extension(filename, s_file_ext_il)) {
+        } else if (type == FILE_TYPE_ATHENA_LIBRARY) {
             options[i] = 3;
             lst->option[i++] = lang_keys[LK_SUBMENU_OPTION_WITCH_ADD_GLOBAL_LIBRARY];
         }
@@ -95,12 +97,13 @@ static enum tristate ui_file_selector_tools_witch(ui_popup_list_config_t *lst, c
     }
 }
 
-static enum tristate ui_file_selector_tools(ui_popup_list_config_t *lst, const char __far *filename) {
+static enum tristate ui_file_selector_tools(ui_popup_list_config_t *lst, const char __far *filename, uint8_t type) {
     while (true) {
         memset(lst, 0, sizeof(ui_popup_list_config_t));
         lst->option[0] = lang_keys[LK_SUBMENU_OPTION_TOOLS_LAUNCH_VIA_XMODEM];
         lst->option[1] = lang_keys[LK_SUBMENU_OPTION_WITCH];
         lst->option[2] = lang_keys[LK_SUBMENU_OPTION_CONTROLLER_MODE];
+        lst->option[3] = lang_keys[LK_SUBMENU_OPTION_TOOLS_BENCHMARK];
 
         switch (ui_popup_list(lst)) {
         case UI_POPUP_ACTION_START:
@@ -119,7 +122,7 @@ static enum tristate ui_file_selector_tools(ui_popup_list_config_t *lst, const c
             return TRISTATE_TRUE;
         }
         case 1: {
-            enum tristate result = ui_file_selector_tools_witch(lst, filename);
+            enum tristate result = ui_file_selector_tools_witch(lst, filename, type);
             if (result != TRISTATE_NONE)
                 return result;
             break;
@@ -127,16 +130,19 @@ static enum tristate ui_file_selector_tools(ui_popup_list_config_t *lst, const c
         case 2:
             ui_hidctrl();
             return TRISTATE_TRUE;
+        case 3:
+            ui_dialog_error_check(ui_bench(), lang_keys[LK_SUBMENU_OPTION_TOOLS_BENCHMARK], 0);
+            return TRISTATE_TRUE;
         }
     }
 }
 
-static enum tristate ui_file_selector_file(ui_popup_list_config_t *lst, const char __far *filename) {
+static enum tristate ui_file_selector_file(ui_popup_list_config_t *lst, const char __far *filename, uint8_t type) {
     while (true) {
         uint8_t options[4];
         int i = 0;
         memset(lst, 0, sizeof(ui_popup_list_config_t));
-        if (fileops_is_rom(filename)) {
+        if (type == FILE_TYPE_ROM) {
             options[i] = 1;
             lst->option[i++] = lang_keys[LK_SUBMENU_OPTION_FILE_ERASE_SAVE];
         }
@@ -167,7 +173,7 @@ static enum tristate ui_file_selector_file(ui_popup_list_config_t *lst, const ch
     }
 }
 
-bool ui_file_selector_options(const char __far *filename, uint8_t attrib) {
+bool ui_file_selector_options(const char __far *filename, uint8_t attrib, uint8_t type) {
     ui_popup_list_config_t lst;
 
     while (true) {
@@ -188,10 +194,10 @@ bool ui_file_selector_options(const char __far *filename, uint8_t attrib) {
             result = TRISTATE_FALSE;
             break;
         case 0:
-            result = ui_file_selector_file(&lst, filename);
+            result = ui_file_selector_file(&lst, filename, type);
             break;
         case 1:
-            result = ui_file_selector_tools(&lst, filename);
+            result = ui_file_selector_tools(&lst, filename, type);
             break;
         case 2:
             ui_settings(&settings_root);
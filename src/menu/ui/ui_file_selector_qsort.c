@@ -18,8 +18,65 @@
 #include <stddef.h>
 #include <string.h>
 #include <ws.h>
+#include "settings.h"
 #include "ui_file_selector.h"
 
+#define SORT_KEY_NAME_LENGTH 5
+
+bool ui_file_selector_sort_key_is_exact(uint8_t mode) {
+    return mode != SETTING_FILE_SORT_NAME_ASC && mode != SETTING_FILE_SORT_NAME_DESC;
+}
+
+void ui_file_selector_sort_key_init(file_selector_sort_key_t __far *key, const FILINFO *fno, uint16_t entry, uint16_t position, uint8_t mode) {
+    uint8_t k[6];
+    memset(k, 0, sizeof(k));
+
+    // Directories are always listed first.
+    k[0] = (fno->fattrib & AM_DIR) ? 0 : 1;
+
+    switch (mode) {
+    case SETTING_FILE_SORT_NAME_ASC:
+    case SETTING_FILE_SORT_NAME_DESC:
+        for (uint8_t i = 0; i < SORT_KEY_NAME_LENGTH; i++) {
+            uint8_t c = fno->fname[i];
+            if (!c) break;
+            // Match strcasecmp() case folding.
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            k[i + 1] = c;
+        }
+        break;
+    case SETTING_FILE_SORT_DATE_ASC:
+    case SETTING_FILE_SORT_DATE_DESC:
+        k[1] = fno->fdate >> 8;
+        k[2] = fno->fdate;
+        k[3] = fno->ftime >> 8;
+        k[4] = fno->ftime;
+        break;
+    case SETTING_FILE_SORT_SIZE_ASC:
+    case SETTING_FILE_SORT_SIZE_DESC:
+        k[1] = fno->fsize >> 24;
+        k[2] = fno->fsize >> 16;
+        k[3] = fno->fsize >> 8;
+        k[4] = fno->fsize;
+        break;
+    default:
+        // Keep the filesystem order.
+        k[1] = position >> 8;
+        k[2] = position;
+        break;
+    }
+
+    if (mode == SETTING_FILE_SORT_NAME_DESC || mode == SETTING_FILE_SORT_DATE_DESC || mode == SETTING_FILE_SORT_SIZE_DESC) {
+        for (uint8_t i = 1; i < sizeof(k); i++)
+            k[i] ^= 0xFF;
+    }
+
+    key->key[0] = (k[0] << 8) | k[1];
+    key->key[1] = (k[2] << 8) | k[3];
+    key->key[2] = (k[4] << 8) | k[5];
+    key->entry = entry;
+}
+
 // https://github.com/DevSolar/pdclib/blob/master/functions/stdlib/qsort.c
 
 /* This implementation is taken from Paul Edward's PDPCLIB.
@@ -38,43 +95,66 @@
 
 /* Macros for handling the QSort stack */
 #ifdef __IA16_CALLCVT_NO_ASSUME_SS_DATA
-#define PREPARE_STACK uint16_t __far* stack[STACKSIZE]; uint16_t __far* __seg_ss* stackptr = stack
+#define PREPARE_STACK file_selector_sort_key_t __far* stack[STACKSIZE]; file_selector_sort_key_t __far* __seg_ss* stackptr = stack
 #else
-#define PREPARE_STACK uint16_t __far* stack[STACKSIZE]; uint16_t __far* * stackptr = stack
+#define PREPARE_STACK file_selector_sort_key_t __far* stack[STACKSIZE]; file_selector_sort_key_t __far* * stackptr = stack
 #endif
 #define PUSH( base, limit ) stackptr[0] = base; stackptr[1] = limit; stackptr += 2
 #define POP( base, limit ) stackptr -= 2; base = stackptr[0]; limit = stackptr[1]
 /* TODO: Stack usage is log2( nmemb ) (minus what T shaves off the worst case).
          Worst-case nmemb is platform dependent.
 */
-#define STACKSIZE 12
+#define STACKSIZE 24
 
-static int qsort_compare(int (*compar)(const file_selector_entry_t __far*, const file_selector_entry_t __far*, void *), void *userdata, uint16_t i, uint16_t j) {
+static int qsort_compare_entries(int (*compar)(const file_selector_entry_t __far*, const file_selector_entry_t __far*, void *), void *userdata, uint16_t i, uint16_t j) {
     int result;
     if (ui_file_selector_fno_direct_same_bank(i, j)) {
         result = compar(ui_file_selector_open_fno_direct(i), ui_file_selector_open_fno_direct_nobank(j), userdata);
-        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
     } else {
-        file_selector_entry_t fno_i;
-        memcpy(&fno_i, ui_file_selector_open_fno_direct(i), sizeof(file_selector_entry_t));
-        result = compar(&fno_i, ui_file_selector_open_fno_direct(j), userdata);
+        uint8_t fno_i_buffer[sizeof(file_selector_entry_t) + FF_LFN_BUF + 1];
+        file_selector_entry_t *fno_i = (file_selector_entry_t*) fno_i_buffer;
+        file_selector_entry_t __far *fno_i_src = ui_file_selector_open_fno_direct(i);
+        memcpy(fno_i, fno_i_src, FILE_SELECTOR_ENTRY_SIZE(fno_i_src));
+        result = compar(fno_i, ui_file_selector_open_fno_direct(j), userdata);
     }
     outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
     return result;
 }
 
+static int qsort_compare(int (*compar)(const file_selector_entry_t __far*, const file_selector_entry_t __far*, void *), void *userdata, const file_selector_sort_key_t __far *a, const file_selector_sort_key_t __far *b) {
+    // Compare precomputed keys first; this does not require a bank switch.
+    if (a->key[0] != b->key[0])
+        return a->key[0] < b->key[0] ? -1 : 1;
+    if (a->key[1] != b->key[1])
+        return a->key[1] < b->key[1] ? -1 : 1;
+    if (a->key[2] != b->key[2])
+        return a->key[2] < b->key[2] ? -1 : 1;
+
+    // Fall back to comparing the full records on ties.
+    uint16_t i = a->entry;
+    uint16_t j = b->entry;
+    if (compar != NULL) {
+        int result = qsort_compare_entries(compar, userdata, i, j);
+        if (result)
+            return result;
+    }
+
+    // Records are allocated in directory order; this keeps the sort stable.
+    return i == j ? 0 : (i < j ? -1 : 1);
+}
+
 __attribute__((always_inline))
-static inline void memswp(uint16_t __far* i, uint16_t __far* j) {
-    uint16_t a = *i;
+static inline void memswp(file_selector_sort_key_t __far* i, file_selector_sort_key_t __far* j) {
+    file_selector_sort_key_t a = *i;
     *i = *j;
     *j = a;
 }
 
 void ui_file_selector_qsort(size_t nmemb, int (*compar)(const file_selector_entry_t __far*, const file_selector_entry_t __far*, void *), void *userdata) {
-    uint16_t __far* i;
-    uint16_t __far* j;
-    uint16_t __far* base_          = FILE_SELECTOR_INDEXES;
-    uint16_t __far* limit          = base_ + nmemb;
+    file_selector_sort_key_t __far* i;
+    file_selector_sort_key_t __far* j;
+    file_selector_sort_key_t __far* base_          = FILE_SELECTOR_SORT_KEYS;
+    file_selector_sort_key_t __far* limit          = base_ + nmemb;
     PREPARE_STACK;
     outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
 
@@ -92,17 +172,17 @@ void ui_file_selector_qsort(size_t nmemb, int (*compar)(const file_selector_entr
             */
             memswp( ( ( ( ( size_t )( limit - base_ ) ) ) / 2 ) + base_, base_ );
 
-            if ( qsort_compare(compar, userdata,  *i, *j ) > 0 )
+            if ( qsort_compare(compar, userdata,  i, j ) > 0 )
             {
                 memswp( i, j );
             }
 
-            if ( qsort_compare(compar, userdata,  *base_, *j ) > 0 )
+            if ( qsort_compare(compar, userdata,  base_, j ) > 0 )
             {
                 memswp( base_, j );
             }
 
-            if ( qsort_compare(compar, userdata,  *i, *base_ ) > 0 )
+            if ( qsort_compare(compar, userdata,  i, base_ ) > 0 )
             {
                 memswp( i, base_ );
             }
@@ -114,13 +194,13 @@ void ui_file_selector_qsort(size_t nmemb, int (*compar)(const file_selector_entr
                 {
                     /* move i right until *i >= pivot */
                     i += 1;
-                } while ( qsort_compare(compar, userdata,  *i, *base_ ) < 0 );
+                } while ( qsort_compare(compar, userdata,  i, base_ ) < 0 );
 
                 do
                 {
                     /* move j left until *j <= pivot */
                     j -= 1;
-                } while ( qsort_compare(compar, userdata,  *j, *base_ ) > 0 );
+                } while ( qsort_compare(compar, userdata,  j, base_ ) > 0 );
 
                 if ( i > j )
                 {
@@ -153,7 +233,7 @@ void ui_file_selector_qsort(size_t nmemb, int (*compar)(const file_selector_entr
         {
             for ( j = base_, i = j + 1; i < limit; j = i, i += 1 )
             {
-                for ( ; qsort_compare(compar, userdata,  *j, *(j + 1) ) > 0; j -= 1 )
+                for ( ; qsort_compare(compar, userdata,  j, j + 1 ) > 0; j -= 1 )
                 {
                     memswp( j, j + 1 );
 
@@ -174,4 +254,7 @@ void ui_file_selector_qsort(size_t nmemb, int (*compar)(const file_selector_entr
             }
         }
     }
+
+    for (i = FILE_SELECTOR_SORT_KEYS, j = FILE_SELECTOR_SORT_KEYS + nmemb; i < j; i++)
+        FILE_SELECTOR_INDEXES[i - FILE_SELECTOR_SORT_KEYS] = i->entry;
 }
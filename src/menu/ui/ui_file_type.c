@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <wonderful.h>
+#include "strings.h"
+#include "ui_file_type.h"
+
+typedef struct {
+    const char __far *ext;
+    uint8_t type;
+} file_type_extension_t;
+
+static const file_type_extension_t __far file_type_extensions[] = {
+    { s_file_ext_ws, FILE_TYPE_ROM },
+    { s_file_ext_wsc, FILE_TYPE_ROM },
+    { s_file_ext_pc2, FILE_TYPE_ROM },
+    { s_file_ext_fx, FILE_TYPE_ATHENA_PROGRAM },
+    { s_file_ext_bin, FILE_TYPE_ATHENA_BINARY },
+    { s_file_ext_fr, FILE_TYPE_ATHENA_RESOURCE },
+    { s_file_ext_il, FILE_TYPE_ATHENA_LIBRARY },
+    { s_file_ext_zip, FILE_TYPE_ZIP },
+    { s_file_ext_vgm, FILE_TYPE_VGM },
+    { s_file_ext_vgz, FILE_TYPE_VGM },
+    { s_file_ext_wav, FILE_TYPE_WAV },
+    { s_file_ext_bmp, FILE_TYPE_BMP },
+    { s_file_ext_bfb, FILE_TYPE_BFB },
+    { s_file_ext_com, FILE_TYPE_COM },
+    { s_file_ext_rom, FILE_TYPE_UXN },
+    { s_file_ext_sram, FILE_TYPE_SAVE },
+    { s_file_ext_eeprom, FILE_TYPE_SAVE },
+    { s_file_ext_rtc, FILE_TYPE_SAVE },
+    { s_file_ext_flash, FILE_TYPE_SAVE_FLASH }
+};
+
+const file_type_info_t __far file_type_info[FILE_TYPE_COUNT] = {
+    [FILE_TYPE_UNKNOWN]         = { 1, 0 },
+    [FILE_TYPE_DIRECTORY]       = { 0, 0 },
+    [FILE_TYPE_ROM]             = { 2, FILE_TYPE_FLAG_ROM_CONTENTS },
+    [FILE_TYPE_ATHENA_PROGRAM]  = { 9, 0 },
+    [FILE_TYPE_ATHENA_BINARY]   = { 1, 0 },
+    [FILE_TYPE_ATHENA_RESOURCE] = { 7, 0 },
+    [FILE_TYPE_ATHENA_LIBRARY]  = { 7, 0 },
+    [FILE_TYPE_ZIP]             = { 8, 0 },
+    [FILE_TYPE_VGM]             = { 4, 0 },
+    [FILE_TYPE_WAV]             = { 4, 0 },
+    [FILE_TYPE_BMP]             = { 3, 0 },
+    [FILE_TYPE_BFB]             = { 5, 0 },
+    [FILE_TYPE_COM]             = { 6, 0 },
+    [FILE_TYPE_UXN]             = { 1, 0 },
+    [FILE_TYPE_SAVE]            = { 1, FILE_TYPE_FLAG_SAVE },
+    [FILE_TYPE_SAVE_FLASH]      = { 1, FILE_TYPE_FLAG_SAVE | FILE_TYPE_FLAG_ROM_CONTENTS }
+};
+
+uint8_t file_type_from_extension(const char __far *ext) {
+    if (ext == NULL)
+        return FILE_TYPE_UNKNOWN;
+
+    for (uint8_t i = 0; i < sizeof(file_type_extensions) / sizeof(file_type_extension_t); i++) {
+        if (!strcasecmp(ext, file_type_extensions[i].ext))
+            return file_type_extensions[i].type;
+    }
+
+    return FILE_TYPE_UNKNOWN;
+}
+
+uint8_t file_type_from_filename(const char __far *filename) {
+    return file_type_from_extension(strrchr(filename, '.'));
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UI_FILE_TYPE_H__
+#define UI_FILE_TYPE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wonderful.h>
+
+// File types, as assigned by the extension registry in ui_file_type.c.
+// To add support for a new file type, add it here, then list its
+// extensions and icon in ui_file_type.c.
+#define FILE_TYPE_UNKNOWN          0
+#define FILE_TYPE_DIRECTORY        1
+#define FILE_TYPE_ROM              2
+#define FILE_TYPE_ATHENA_PROGRAM   3
+#define FILE_TYPE_ATHENA_BINARY    4
+#define FILE_TYPE_ATHENA_RESOURCE  5
+#define FILE_TYPE_ATHENA_LIBRARY   6
+#define FILE_TYPE_ZIP              7
+#define FILE_TYPE_VGM              8
+#define FILE_TYPE_WAV              9
+#define FILE_TYPE_BMP              10
+#define FILE_TYPE_BFB              11
+#define FILE_TYPE_COM              12
+#define FILE_TYPE_UXN              13
+#define FILE_TYPE_SAVE             14
+#define FILE_TYPE_SAVE_FLASH       15
+#define FILE_TYPE_COUNT            16
+
+// The file is save data belonging to a cartridge image.
+#define FILE_TYPE_FLAG_SAVE         0x01
+// The file contains a cartridge image.
+#define FILE_TYPE_FLAG_ROM_CONTENTS 0x02
+
+typedef struct {
+    uint8_t icon;
+    uint8_t flags;
+} file_type_info_t;
+
+extern const file_type_info_t __far file_type_info[FILE_TYPE_COUNT];
+
+/**
+ * @brief Classify a file by its extension.
+ *
+ * @param ext The extension, including the leading dot, or NULL.
+ * @return The file type, or FILE_TYPE_UNKNOWN if not recognized.
+ */
+uint8_t file_type_from_extension(const char __far *ext);
+
+/**
+ * @brief Classify a file by its name.
+ *
+ * @param filename The file name.
+ * @return The file type, or FILE_TYPE_UNKNOWN if not recognized.
+ */
+uint8_t file_type_from_filename(const char __far *filename);
+
+static inline uint8_t file_type_get_icon(uint8_t type) {
+    return file_type_info[type].icon;
+}
+
+static inline bool file_type_has_flag(uint8_t type, uint8_t flag) {
+    return (file_type_info[type].flags & flag) != 0;
+}
+
+#endif /* UI_FILE_TYPE_H__ */
@@ -23,6 +23,7 @@
 #include "lang.h"
 #include "lang_gen.h"
 #include "ui/ui.h"
+#include "ui_file_type.h"
 #include "ui_fileops.h"
 #include "strings.h"
 #include "util/file.h"
@@ -34,13 +35,11 @@ bool fileops_has_extension(const char __far *filename, const char __far *ext) {
 }
 
 bool fileops_is_rom(const char __far *filename) {
-    const char __far *filename_ext = strrchr(filename, '.');
-    return filename_ext != NULL && (!strcasecmp(filename_ext, s_file_ext_ws) || !strcasecmp(filename_ext, s_file_ext_wsc) || !strcasecmp(filename_ext, s_file_ext_pc2));
+    return file_type_from_filename(filename) == FILE_TYPE_ROM;
 }
 
 bool fileops_has_rom_contents(const char __far *filename) {
-    const char __far *filename_ext = strrchr(filename, '.');
-    return filename_ext != NULL && (!strcasecmp(filename_ext, s_file_ext_ws) || !strcasecmp(filename_ext, s_file_ext_wsc) || !strcasecmp(filename_ext, s_file_ext_pc2) || !strcasecmp(filename_ext, s_file_ext_flash));
+    return file_type_has_flag(file_type_from_filename(filename), FILE_TYPE_FLAG_ROM_CONTENTS);
 }
 
 static int16_t __fileops_delete_path(char *path, bool hide_other_values) {
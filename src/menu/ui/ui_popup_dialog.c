@@ -54,16 +54,20 @@ void ui_popup_dialog_clear(ui_popup_dialog_config_t *config) {
 void ui_popup_dialog_clear_progress(ui_popup_dialog_config_t *config) {
     if (config->progress_max) {
         config->progress_step = 0;
+        config->progress_drawn = 0;
         uint16_t p_width = config->width - 16;
         bitmap_rect_fill(&ui_bitmap, config->x + 8, config->progress_y, p_width, 1,
             BITMAP_COLOR_4BPP(2));
     }
 }
 
+static void ui_popup_dialog_invert_button(ui_popup_dialog_config_t *config, uint16_t button_height, uint8_t i) {
+    bitmap_rect_fill(&ui_bitmap, config->button_x[i] + 1, config->buttons_y + 1,
+        config->button_w[i] - 2, button_height - 2, BITMAP_COLOR(1, 1, BITMAP_COLOR_MODE_XOR));
+}
+
 // -1 = full redraw
 static inline void ui_popup_dialog_draw_buttons(ui_popup_dialog_config_t *config, int16_t selected) {
-    uint16_t button_x[UI_POPUP_DIALOG_MAX_BUTTON_COUNT];
-    uint16_t button_w[UI_POPUP_DIALOG_MAX_BUTTON_COUNT];
     uint16_t button_width = 0;
 
     bitmapfont_set_active_font(font16_bitmap);
@@ -72,35 +76,51 @@ static inline void ui_popup_dialog_draw_buttons(ui_popup_dialog_config_t *config
     for (int i = 0; i < UI_POPUP_DIALOG_MAX_BUTTON_COUNT; i++) {
         if (!config->buttons[i]) break;
         if (i > 0) button_width += INNER_GAP;
-        button_x[i] = button_width;
-        button_w[i] = (BUTTON_X_BORDER * 2) + bitmapfont_get_string_width(lang_keys[config->buttons[i]], screen_width);
-        button_width += button_w[i];
+        config->button_x[i] = button_width;
+        config->button_w[i] = (BUTTON_X_BORDER * 2) + bitmapfont_get_string_width(lang_keys[config->buttons[i]], screen_width);
+        button_width += config->button_w[i];
     }
 
     uint16_t xofs = UI_CENTERED_IN_BOX(config->x, config->width, button_width);
+    for (int i = 0; i < UI_POPUP_DIALOG_MAX_BUTTON_COUNT; i++) {
+        if (!config->buttons[i]) break;
+        config->button_x[i] += xofs;
+    }
+
     if (selected == -1) {
         for (int i = 0; i < UI_POPUP_DIALOG_MAX_BUTTON_COUNT; i++) {
             if (!config->buttons[i]) break;
-            bitmap_rect_draw(&ui_bitmap, xofs + button_x[i], config->buttons_y,
-                button_w[i], button_height, BITMAP_COLOR_2BPP(3), true);
+            bitmap_rect_draw(&ui_bitmap, config->button_x[i], config->buttons_y,
+                config->button_w[i], button_height, BITMAP_COLOR_2BPP(3), true);
         }
     }
 
-    // TODO: partial refreshes
     for (int i = 0; i < UI_POPUP_DIALOG_MAX_BUTTON_COUNT; i++) {
         if (!config->buttons[i]) break;
-        bitmap_rect_fill(&ui_bitmap, xofs + button_x[i] + 1, config->buttons_y + 1,
-            button_w[i] - 2, button_height - 2, BITMAP_COLOR_2BPP(2));
-        bitmapfont_draw_string(&ui_bitmap, xofs + button_x[i] + BUTTON_X_BORDER, config->buttons_y + BUTTON_Y_BORDER + BUTTON_Y_TEXT_OFFSET,
+        bitmap_rect_fill(&ui_bitmap, config->button_x[i] + 1, config->buttons_y + 1,
+            config->button_w[i] - 2, button_height - 2, BITMAP_COLOR_2BPP(2));
+        bitmapfont_draw_string(&ui_bitmap, config->button_x[i] + BUTTON_X_BORDER, config->buttons_y + BUTTON_Y_BORDER + BUTTON_Y_TEXT_OFFSET,
             lang_keys[config->buttons[i]], screen_width);
         if (selected == i) {
-            bitmap_rect_fill(&ui_bitmap, xofs + button_x[i] + 1, config->buttons_y + 1,
-                button_w[i] - 2, button_height - 2, BITMAP_COLOR(1, 1, BITMAP_COLOR_MODE_XOR));
+            ui_popup_dialog_invert_button(config, button_height, i);
         }
     }
 }
 
+// Move the highlight between two buttons drawn by ui_popup_dialog_draw_buttons().
+static void ui_popup_dialog_select_button(ui_popup_dialog_config_t *config, int16_t prev_selected, int16_t selected) {
+    bitmapfont_set_active_font(font16_bitmap);
+    uint16_t button_height = bitmapfont_get_font_height() - 1 + (BUTTON_Y_BORDER * 2);
+
+    if (prev_selected >= 0)
+        ui_popup_dialog_invert_button(config, button_height, prev_selected);
+    if (selected >= 0)
+        ui_popup_dialog_invert_button(config, button_height, selected);
+}
+
 void ui_popup_dialog_draw(ui_popup_dialog_config_t *config) {
+    bitmapfont_layout_t title_layout;
+    bitmapfont_layout_t desc_layout;
     uint16_t title_box_width;
     uint16_t title_box_height;
     uint16_t desc_box_width;
@@ -121,9 +141,13 @@ void ui_popup_dialog_draw(ui_popup_dialog_config_t *config) {
     desc_box_height = 0;
     uint16_t last_gap = 0;
 
+    bitmapfont_layout_reset();
+
     if (config->title) {
         bitmapfont_set_active_font(font16_bitmap);
-        bitmapfont_get_string_box(config->title, &title_box_width, &title_box_height, 0);
+        bitmapfont_layout_string_box(&title_layout, config->title, title_box_width, 0);
+        title_box_width = title_layout.width;
+        title_box_height = title_layout.height;
         APPEND_WITH_GAP(inner_height, title_box_height);
         inner_width = MAX(inner_width, title_box_width);
         inner_height -= 2;
@@ -133,7 +157,9 @@ void ui_popup_dialog_draw(ui_popup_dialog_config_t *config) {
     }
     if (config->description) {
         bitmapfont_set_active_font(settings_language_prefer_large_fonts() ? font16_bitmap : font8_bitmap);
-        bitmapfont_get_string_box(config->description, &desc_box_width, &desc_box_height, 1);
+        bitmapfont_layout_string_box(&desc_layout, config->description, desc_box_width, 1);
+        desc_box_width = desc_layout.width;
+        desc_box_height = desc_layout.height;
         APPEND_WITH_GAP(inner_height, desc_box_height);
         inner_width = MAX(inner_width, desc_box_width);
         inner_height += DESCRIPTION_GAP_EXTRA;
@@ -179,19 +205,19 @@ void ui_popup_dialog_draw(ui_popup_dialog_config_t *config) {
 
     if (config->title) {
         bitmapfont_set_active_font(font16_bitmap);
-        bitmapfont_draw_string_box(&ui_bitmap,
+        bitmapfont_draw_layout(&ui_bitmap,
             UI_CENTERED_IN_BOX(config->x, config->width, title_box_width),
             inner_y + inner_height,
-            config->title, title_box_width, 0, BITMAPFONT_BOX_CENTERED);
+            &title_layout, BITMAPFONT_BOX_CENTERED);
         APPEND_INCLUDING_GAP(inner_height, title_box_height);
         inner_height -= 2;
     }
     if (config->description) {
         bitmapfont_set_active_font(settings_language_prefer_large_fonts() ? font16_bitmap : font8_bitmap);
-        bitmapfont_draw_string_box(&ui_bitmap,
+        bitmapfont_draw_layout(&ui_bitmap,
             UI_CENTERED_IN_BOX(config->x, config->width, desc_box_width),
             inner_y + inner_height,
-            config->description, desc_box_width, 1, 0);
+            &desc_layout, 0);
         APPEND_INCLUDING_GAP(inner_height, desc_box_height);
         inner_height += DESCRIPTION_GAP_EXTRA;
     }
@@ -206,6 +232,7 @@ void ui_popup_dialog_draw(ui_popup_dialog_config_t *config) {
         APPEND_INCLUDING_GAP(inner_height, bitmapfont_get_font_height() - 1 + (BUTTON_Y_BORDER * 2));
     }
 
+    config->progress_drawn = 0;
     ui_popup_dialog_draw_update(config);
 }
 
@@ -213,8 +240,12 @@ void ui_popup_dialog_draw_update(ui_popup_dialog_config_t *config) {
     if (config->progress_max && config->progress_step) {
         uint16_t p_width = config->width - 16;
         uint16_t p = config->progress_step * (uint32_t)p_width / config->progress_max;
-        bitmap_rect_fill(&ui_bitmap, config->x + 8, config->progress_y, p, 1,
-            BITMAP_COLOR_2BPP(MAINPAL_COLOR_BLACK));
+        // Only draw the part of the bar which has not been drawn yet.
+        if (p > config->progress_drawn) {
+            bitmap_rect_fill(&ui_bitmap, config->x + 8 + config->progress_drawn, config->progress_y, p - config->progress_drawn, 1,
+                BITMAP_COLOR_2BPP(MAINPAL_COLOR_BLACK));
+            config->progress_drawn = p;
+        }
     }
 }
 
@@ -246,13 +277,13 @@ int16_t ui_popup_dialog_action(ui_popup_dialog_config_t *config, uint8_t selecte
                 }
             }
             if (prev_selected_button != selected_button) {
-                ui_popup_dialog_draw_buttons(config, selected_button);
+                ui_popup_dialog_select_button(config, prev_selected_button, selected_button);
             }
             if (keys_pressed & WS_KEY_A) {
                 return selected_button;
             }
             if (keys_pressed & WS_KEY_B) {
-                ui_popup_dialog_draw_buttons(config, -1);
+                ui_popup_dialog_select_button(config, selected_button, -1);
                 return UI_POPUP_ACTION_BACK;
             }
         }
@@ -35,7 +35,10 @@ typedef struct ui_popup_dialog_config {
 
     // Auto-filled
     uint8_t progress_y;
+    uint8_t progress_drawn;
     uint8_t buttons_y;
+    uint8_t button_x[UI_POPUP_DIALOG_MAX_BUTTON_COUNT];
+    uint8_t button_w[UI_POPUP_DIALOG_MAX_BUTTON_COUNT];
 } ui_popup_dialog_config_t;
 
 void ui_popup_dialog_reset(ui_popup_dialog_config_t *config);
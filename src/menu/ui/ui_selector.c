@@ -55,26 +55,45 @@ void ui_selector_clear_selection(ui_selector_config_t *config) {
         ui_selector_set_active_font(config);
         UI_SELECTOR_ROW_CONFIG();
 
-        if (config->offset < config->count) {
-            uint16_t prev_sel = (config->offset % row_count);
+        if (config->offset < config->count && config->offset >= config->top && config->offset < config->top + row_count) {
+            uint16_t prev_sel = config->offset - config->top;
             bitmap_rect_fill(&ui_bitmap, 0, prev_sel * row_height + SELECTOR_Y_OFFSET, screen_width, row_height, BITMAP_COLOR_4BPP(0));
             config->draw(config, config->offset, prev_sel * row_height + SELECTOR_Y_OFFSET + row_offset, 0);
         }
     }
 }
 
+static void ui_selector_draw_rows(ui_selector_config_t *config, uint16_t first, uint16_t count, uint16_t row_height, uint16_t row_offset) {
+    uint16_t y = first * row_height + SELECTOR_Y_OFFSET;
+    bitmap_rect_fill(&ui_bitmap, 0, y, screen_width, row_height * count, BITMAP_COLOR_4BPP(ui_has_wallpaper() ? 0 : 2));
+    for (uint16_t i = 0; i < count; i++, y += row_height) {
+        uint16_t offset = config->top + first + i;
+        if (offset >= config->count) break;
+
+        config->draw(config, offset, y + row_offset, 0);
+    }
+}
+
 #define UI_SELECTOR_OFFSET_TO_BOUNDS() \
     if (config->count > 0 && config->offset >= config->count) \
         config->offset = config->count - 1
 
 #define SCROLL_TICKS_MIN 96
-#define SCROLL_TICKS_PACE_SHIFT 5
-#define SCROLL_TICKS_PACE_MASK ((1 << (SCROLL_TICKS_PACE_SHIFT)) - 1)
+
+// Redraw an entry scrolled by config->scroll() in its regular form.
+static void ui_selector_scroll_stop(ui_selector_config_t *config, uint16_t offset, uint16_t y, uint16_t row_height, uint16_t row_offset) {
+    ui_marquee_stop();
+    ui_selector_set_active_font(config);
+    bitmap_rect_fill(&ui_bitmap, 0, y, screen_width, row_height, BITMAP_COLOR_2BPP(ui_has_wallpaper() ? 0 : 2));
+    config->draw(config, offset, y + row_offset, 0);
+}
 
 uint16_t ui_selector(ui_selector_config_t *config) {
     char sbuf[33];
     bool full_redraw = true;
     uint16_t prev_offset = 0xFFFF;
+    uint16_t prev_top = 0xFFFF;
+    uint16_t prev_page = 0xFFFF;
     uint16_t scroll_ticks = 0;
 
     UI_SELECTOR_ROW_CONFIG();
@@ -96,43 +115,52 @@ uint16_t ui_selector(ui_selector_config_t *config) {
         }
     }
 
+    UI_SELECTOR_OFFSET_TO_BOUNDS();
+    if (config->offset < config->top || config->offset >= config->top + row_count)
+        config->top = config->offset - (config->offset % row_count);
+
     while (true) {
         if (prev_offset != config->offset) {
-            if (settings.file_flags & SETTING_THEME_SCROLL_LONG_NAMES) {
-                if (scroll_ticks > SCROLL_TICKS_MIN) {
-                    ui_selector_set_active_font(config);
-                    int y_offset = (prev_offset % row_count) * row_height + SELECTOR_Y_OFFSET;
-                    bitmap_rect_fill(&ui_bitmap, 0, y_offset + row_offset, screen_width, row_height, BITMAP_COLOR_2BPP(ui_has_wallpaper() ? 0 : 2));
-                    config->draw(config, prev_offset, y_offset + row_offset, 0);
-                }
-                scroll_ticks = 0;
+            if (scroll_ticks > SCROLL_TICKS_MIN) {
+                ui_selector_scroll_stop(config, prev_offset, (prev_offset - prev_top) * row_height + SELECTOR_Y_OFFSET, row_height, row_offset);
             }
+            scroll_ticks = 0;
 
-            bool draw_filenames = prev_offset == 0xFFFF || ((prev_offset / row_count) != (config->offset / row_count));
-            bool draw_highlights = prev_offset == 0xFFFF || ((prev_offset % row_count) != (config->offset % row_count));
-            if (draw_filenames) {
+            // Scroll the list by moving the rows already drawn, only drawing
+            // the newly exposed ones; larger jumps redraw the whole list.
+            bool draw_filenames = false;
+            if (prev_top != config->top) {
                 ui_selector_set_active_font(config);
-                bitmap_rect_fill(&ui_bitmap, 0, SELECTOR_Y_OFFSET, screen_width, row_height * row_count, BITMAP_COLOR_4BPP(ui_has_wallpaper() ? 0 : 2));
-                for (int i = 0; i < row_count; i++) {
-                    uint16_t offset = ((config->offset / row_count) * row_count) + i;
-                    if (offset >= config->count) break;
-
-                    config->draw(config, offset, i * row_height + SELECTOR_Y_OFFSET + row_offset, 0);
+                uint16_t shift = config->top > prev_top ? config->top - prev_top : prev_top - config->top;
+                if (full_redraw || shift >= row_count) {
+                    ui_selector_draw_rows(config, 0, row_count, row_height, row_offset);
+                    draw_filenames = true;
+                } else if (config->top > prev_top) {
+                    bitmap_scroll_rows(&ui_bitmap, SELECTOR_Y_OFFSET + shift * row_height, SELECTOR_Y_OFFSET, (row_count - shift) * row_height);
+                    ui_selector_draw_rows(config, row_count - shift, shift, row_height, row_offset);
+                } else {
+                    bitmap_scroll_rows(&ui_bitmap, SELECTOR_Y_OFFSET, SELECTOR_Y_OFFSET + shift * row_height, (row_count - shift) * row_height);
+                    ui_selector_draw_rows(config, 0, shift, row_height, row_offset);
                 }
+            }
 
-                snprintf(sbuf, sizeof(sbuf), lang_keys[LK_UI_FILE_SELECTOR_PAGE_FORMAT], (config->offset / row_count) + 1, ((config->count + row_count - 1) / row_count));
+            uint16_t page = config->offset / row_count;
+            if (prev_page != page) {
+                ui_selector_set_active_font(config);
+                snprintf(sbuf, sizeof(sbuf), lang_keys[LK_UI_FILE_SELECTOR_PAGE_FORMAT], page + 1, ((config->count + row_count - 1) / row_count));
                 ui_draw_statusbar_lr(sbuf, config->info_str);
-                draw_highlights |= ui_has_wallpaper();
+                prev_page = page;
             }
-            if (draw_highlights) {
-                uint16_t prev_sel = (prev_offset % row_count);
-                uint16_t sel = (config->offset % row_count);
+
+            uint16_t prev_sel = prev_offset - prev_top;
+            uint16_t sel = config->offset - config->top;
+            if (full_redraw || prev_sel != sel || ui_has_wallpaper()) {
                 if (full_redraw) {
                     for (int iy = 0; iy < row_count; iy++) {
                         ui_screen_modify_tiles(bitmap_screen2, ~WS_SCREEN_ATTR_PALETTE_MASK,
                             iy == sel ? WS_SCREEN_ATTR_PALETTE(1) : 0, 0, iy*(row_height>>3) + 1, screen_width>>3, row_height>>3);
                     }
-                } else {
+                } else if (prev_sel != sel) {
                     uint16_t prev_sel_tile = prev_sel;
                     uint16_t sel_tile = sel;
                     if (row_height > 8) {
@@ -146,8 +174,11 @@ uint16_t ui_selector(ui_selector_config_t *config) {
 
                 if (ui_has_wallpaper()) {
                     ui_selector_set_active_font(config);
-                    // Redraw previous and current selected filename
-                    if (!draw_filenames && prev_offset < config->count) {
+                    // Redraw previous and current selected filename; the
+                    // previous one may have moved with the scrolled rows
+                    if (!draw_filenames && prev_offset < config->count
+                        && prev_offset >= config->top && prev_offset < config->top + row_count) {
+                        prev_sel = prev_offset - config->top;
                         bitmap_rect_fill(&ui_bitmap, 0, prev_sel * row_height + SELECTOR_Y_OFFSET, screen_width, row_height, BITMAP_COLOR_4BPP(0));
                         config->draw(config, prev_offset, prev_sel * row_height + SELECTOR_Y_OFFSET + row_offset, 0);
                     }
@@ -159,18 +190,21 @@ uint16_t ui_selector(ui_selector_config_t *config) {
             }
 
             prev_offset = config->offset;
+            prev_top = config->top;
             full_redraw = false;
         }
 
-        if (idle_until_vblank() || cart_status_apply_orientation_change())
+        if (idle_until_vblank() || cart_status_apply_orientation_change()) {
+            ui_marquee_stop();
             return UI_SELECTOR_RELOAD_REQUESTED;
+        }
 
-        if (settings.file_flags & SETTING_THEME_SCROLL_LONG_NAMES) {
+        if ((settings.file_flags & SETTING_THEME_SCROLL_LONG_NAMES) && config->scroll != NULL) {
             scroll_ticks++;
-            if (scroll_ticks > SCROLL_TICKS_MIN && !(scroll_ticks & SCROLL_TICKS_PACE_MASK)) {
+            if (scroll_ticks > SCROLL_TICKS_MIN) {
                 ui_selector_set_active_font(config);
-                int y_offset = (config->offset % row_count) * row_height + SELECTOR_Y_OFFSET;
-                config->draw(config, config->offset, y_offset + row_offset, (scroll_ticks - SCROLL_TICKS_MIN) >> SCROLL_TICKS_PACE_SHIFT);
+                int y_offset = (config->offset - config->top) * row_height + SELECTOR_Y_OFFSET;
+                config->scroll(config, config->offset, y_offset + row_offset, scroll_ticks - SCROLL_TICKS_MIN);
             }
         }
 
@@ -178,27 +212,25 @@ uint16_t ui_selector(ui_selector_config_t *config) {
         uint16_t keys_pressed = input_pressed;
 
         // Page/entry movement
+        bool page_moved = false;
         if (keys_pressed & WS_KEY_X1) {
             do {
-                if (config->offset == 0 || ((config->offset - 1) % row_count) == (row_count - 1))
-                    config->offset = config->offset + (row_count - 1);
+                if (config->offset == 0)
+                    config->offset = config->count - 1;
                 else
                     config->offset = config->offset - 1;
-                UI_SELECTOR_OFFSET_TO_BOUNDS();
             } while (config->can_select != NULL && !config->can_select(config, config->offset));
         }
         if (keys_pressed & WS_KEY_X3) {
             do {
-                if ((config->offset + 1) == config->count)
-                    config->offset = config->offset - (config->offset % row_count);
-                else if (((config->offset + 1) % row_count) == 0)
-                    config->offset = config->offset - (row_count - 1);
+                if ((config->offset + 1) >= config->count)
+                    config->offset = 0;
                 else
                     config->offset = config->offset + 1;
-                UI_SELECTOR_OFFSET_TO_BOUNDS();
             } while (config->can_select != NULL && !config->can_select(config, config->offset));
         }
         if (keys_pressed & WS_KEY_X2) {
+            page_moved = true;
             do {
                 if ((config->offset - (config->offset % row_count) + row_count) < config->count)
                     config->offset += row_count;
@@ -206,6 +238,7 @@ uint16_t ui_selector(ui_selector_config_t *config) {
             } while (config->can_select != NULL && !config->can_select(config, config->offset));
         }
         if (keys_pressed & WS_KEY_X4) {
+            page_moved = true;
             do {
                 if (config->offset >= row_count)
                     config->offset -= row_count;
@@ -214,8 +247,20 @@ uint16_t ui_selector(ui_selector_config_t *config) {
         }
         UI_SELECTOR_OFFSET_TO_BOUNDS();
 
+        // Keep the selected entry visible, scrolling by entries or by pages
+        if (page_moved)
+            config->top = config->offset - (config->offset % row_count);
+        else if (config->offset < config->top)
+            config->top = config->offset;
+        else if (config->offset >= config->top + row_count)
+            config->top = config->offset - (row_count - 1);
+
         // User actions
-        if (keys_pressed & config->key_mask)
+        if (keys_pressed & config->key_mask) {
+            if (scroll_ticks > SCROLL_TICKS_MIN) {
+                ui_selector_scroll_stop(config, prev_offset, (prev_offset - prev_top) * row_height + SELECTOR_Y_OFFSET, row_height, row_offset);
+            }
             return keys_pressed & config->key_mask;
+        }
     }
 }
@@ -25,6 +25,7 @@
 
 typedef struct ui_selector_config {
     uint16_t offset; ///< Currently selected entry. Controlled by ui_selector().
+    uint16_t top; ///< First visible entry. Controlled by ui_selector().
     uint16_t count; ///< Maximum number of entries.
     const char __far *info_str; ///< Auxilliary information text.
     uint16_t key_mask; ///< Keys which exit the ui_selector() main loop.
@@ -32,6 +33,8 @@ typedef struct ui_selector_config {
     void *userdata; ///< Data to pass to selector functions.
 
     void (*draw)(struct ui_selector_config *config, uint16_t idx, uint16_t y, uint16_t scroll_tick);
+    /// Called every frame for the selected entry, once it has been selected for a while. Optional.
+    void (*scroll)(struct ui_selector_config *config, uint16_t idx, uint16_t y, uint16_t scroll_tick);
     bool (*can_select)(struct ui_selector_config *config, uint16_t idx);
 } ui_selector_config_t;
 
@@ -0,0 +1,354 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <nile/mcu/protocol.h>
+#include <stdio.h>
+#include <string.h>
+#include <wonderful.h>
+#include <ws.h>
+#include <nile.h>
+#include <nilefs.h>
+#include "bench.h"
+#include "cart/mcu.h"
+#include "config.h"
+#include "main.h"
+#include "settings.h"
+#include "strings.h"
+#include "util/file.h"
+
+#define BENCH_MAX_RESULTS 16
+// Number of MCU commands issued per round trip measurement.
+#define BENCH_MCU_ROUND_TRIPS 64
+// Size of the MCU's EEPROM buffer, in words, and the largest single read.
+#define BENCH_EEPROM_WORDS 1024
+#define BENCH_EEPROM_WORDS_PER_CMD 64
+#define BENCH_CDC_TICKS 75
+#define BENCH_SECTOR_SIZE 512
+
+// The HBlank timer counts 159 lines per frame at 75.47 Hz, about 12000
+// lines per second; past this many frames it would overflow.
+#define BENCH_HBLANK_MAX_TICKS 400
+#define BENCH_US_PER_TICK 13250
+
+DEFINE_STRING_LOCAL(s_bench_tf_read, "TF read");
+DEFINE_STRING_LOCAL(s_bench_tf_write, "TF write");
+DEFINE_STRING_LOCAL(s_bench_tf_random_read, "TF random read");
+DEFINE_STRING_LOCAL(s_bench_tf_random_write, "TF random write");
+DEFINE_STRING_LOCAL(s_bench_mcu_round_trip, "MCU round trip");
+DEFINE_STRING_LOCAL(s_bench_eeprom_read, "EEPROM read");
+DEFINE_STRING_LOCAL(s_bench_cdc_write, "CDC write");
+
+static const char __far * const __far bench_test_names[] = {
+    s_bench_tf_read,
+    s_bench_tf_write,
+    s_bench_tf_random_read,
+    s_bench_tf_random_write,
+    s_bench_mcu_round_trip,
+    s_bench_eeprom_read,
+    s_bench_cdc_write
+};
+
+DEFINE_STRING_LOCAL(s_bench_clock_fast, "fast");
+DEFINE_STRING_LOCAL(s_bench_clock_cart, "cart");
+
+static const char __far * const __far bench_clock_names[] = {
+    s_bench_clock_fast,
+    s_bench_clock_cart
+};
+
+static const uint16_t __far bench_clocks[] = {
+    NILE_SPI_CLOCK_FAST,
+    NILE_SPI_CLOCK_CART
+};
+
+DEFINE_STRING_LOCAL(s_bench_speed_384khz, "384 kHz");
+DEFINE_STRING_LOCAL(s_bench_speed_6mhz, "6 MHz");
+DEFINE_STRING_LOCAL(s_bench_speed_24mhz, "24 MHz");
+
+static const char __far * const __far bench_speed_names[] = {
+    s_bench_speed_384khz,
+    s_bench_speed_6mhz,
+    s_bench_speed_24mhz
+};
+
+DEFINE_STRING_LOCAL(s_bench_result_rate, "%s (%s): %ld KB/s");
+DEFINE_STRING_LOCAL(s_bench_result_latency, "%s (%s): %ld us");
+DEFINE_STRING_LOCAL(s_bench_result_none, "%s (%s): -");
+DEFINE_STRING_LOCAL(s_bench_log_header, "# swanshell " VERSION "\n");
+DEFINE_STRING_LOCAL(s_bench_log_entry, "%s\t%s\t%u\t%lu\t%lu\n");
+
+typedef struct {
+    bench_result_t results[BENCH_MAX_RESULTS];
+    uint8_t count;
+    bench_result_callback_t cb;
+    void *userdata;
+} bench_state_t;
+
+static uint16_t bench_start_ticks;
+
+static void bench_timer_start(void) {
+    ws_timer_hblank_start_once(65535);
+    bench_start_ticks = vbl_ticks;
+}
+
+static uint32_t bench_timer_end(void) {
+    uint16_t lines = ws_timer_hblank_get_counter() ^ 0xFFFF;
+    uint16_t ticks = vbl_ticks - bench_start_ticks;
+    ws_timer_hblank_disable();
+
+    if (ticks >= BENCH_HBLANK_MAX_TICKS)
+        return (uint32_t) ticks * BENCH_US_PER_TICK;
+    // 12000 lines per second => 250/3 us per line; avoid reporting zero.
+    return lines ? ((uint32_t) lines * 250) / 3 : 1;
+}
+
+static void bench_add(bench_state_t *state, uint8_t test, uint8_t param, uint16_t count, uint32_t bytes, uint32_t time_us) {
+    if (state->count >= BENCH_MAX_RESULTS)
+        return;
+    bench_result_t *result = state->results + state->count++;
+    result->test = test;
+    result->param = param;
+    result->count = count;
+    result->bytes = bytes;
+    result->time_us = time_us;
+    if (state->cb)
+        state->cb(result, state->userdata);
+}
+
+static inline uint16_t bench_random_sector(uint16_t *seed) {
+    *seed = *seed * 25173 + 13849;
+    return ((uint32_t) *seed * (CONFIG_BENCH_FILE_SIZE / BENCH_SECTOR_SIZE)) >> 16;
+}
+
+// Random accesses read or write single sectors at the same pseudo-random
+// sector-aligned offsets for every clock setting.
+static int16_t bench_tf_random(FIL *fp, bool write, uint16_t clock, uint32_t *time_us) {
+    uint16_t seed = 1;
+    int16_t result = FR_OK;
+
+    bench_timer_start();
+    for (uint16_t i = 0; i < CONFIG_BENCH_RANDOM_SECTORS; i++) {
+        nile_spi_set_control(clock | NILE_SPI_DEV_TF);
+        result = f_lseek(fp, (uint32_t) bench_random_sector(&seed) * BENCH_SECTOR_SIZE);
+        if (result != FR_OK)
+            break;
+        if (write)
+            result = f_write_rom_banked(fp, 0, BENCH_SECTOR_SIZE, NULL, NULL, false);
+        else
+            result = f_read_rom_banked(fp, 0, BENCH_SECTOR_SIZE, NULL, NULL);
+        if (result != FR_OK)
+            break;
+    }
+    if (write && result == FR_OK)
+        result = f_sync(fp);
+    *time_us = bench_timer_end();
+
+    return result;
+}
+
+__attribute__((noinline))
+static int16_t bench_tf(bench_state_t *state) {
+    FIL fp;
+    uint32_t time_us;
+
+    int16_t result = f_open_far(&fp, s_path_bench_tmp, FA_CREATE_ALWAYS | FA_READ | FA_WRITE);
+    if (result != FR_OK)
+        return result;
+
+    // Allocate the file's clusters up front, so that the timed write
+    // passes all overwrite it in place.
+    result = f_write_rom_banked(&fp, 0, CONFIG_BENCH_FILE_SIZE, NULL, NULL, false);
+    if (result == FR_OK)
+        result = f_sync(&fp);
+
+    for (uint8_t i = 0; i < sizeof(bench_clocks) / sizeof(uint16_t) && result == FR_OK; i++) {
+        uint16_t clock = bench_clocks[i];
+
+        nile_spi_set_control(clock | NILE_SPI_DEV_TF);
+        result = f_rewind(&fp);
+        if (result != FR_OK)
+            break;
+        bench_timer_start();
+        result = f_write_rom_banked(&fp, 0, CONFIG_BENCH_FILE_SIZE, NULL, NULL, false);
+        if (result == FR_OK)
+            result = f_sync(&fp);
+        time_us = bench_timer_end();
+        if (result != FR_OK)
+            break;
+        bench_add(state, BENCH_TEST_TF_WRITE, i, 1, CONFIG_BENCH_FILE_SIZE, time_us);
+
+        nile_spi_set_control(clock | NILE_SPI_DEV_TF);
+        result = f_rewind(&fp);
+        if (result != FR_OK)
+            break;
+        bench_timer_start();
+        result = f_read_rom_banked(&fp, 0, CONFIG_BENCH_FILE_SIZE, NULL, NULL);
+        time_us = bench_timer_end();
+        if (result != FR_OK)
+            break;
+        bench_add(state, BENCH_TEST_TF_READ, i, 1, CONFIG_BENCH_FILE_SIZE, time_us);
+
+        result = bench_tf_random(&fp, true, clock, &time_us);
+        if (result != FR_OK)
+            break;
+        bench_add(state, BENCH_TEST_TF_RANDOM_WRITE, i, CONFIG_BENCH_RANDOM_SECTORS,
+            (uint32_t) CONFIG_BENCH_RANDOM_SECTORS * BENCH_SECTOR_SIZE, time_us);
+
+        result = bench_tf_random(&fp, false, clock, &time_us);
+        if (result != FR_OK)
+            break;
+        bench_add(state, BENCH_TEST_TF_RANDOM_READ, i, CONFIG_BENCH_RANDOM_SECTORS,
+            (uint32_t) CONFIG_BENCH_RANDOM_SECTORS * BENCH_SECTOR_SIZE, time_us);
+    }
+
+    nile_spi_set_control(NILE_SPI_CLOCK_FAST | NILE_SPI_DEV_NONE);
+    int16_t result2 = f_close(&fp);
+    if (result == FR_OK)
+        result = result2;
+    f_unlink_far(s_path_bench_tmp);
+    return result;
+}
+
+__attribute__((noinline))
+static void bench_mcu(bench_state_t *state) {
+    nile_mcu_native_version_t version;
+    uint16_t buffer[BENCH_EEPROM_WORDS_PER_CMD];
+    uint32_t time_us;
+
+    for (uint8_t speed = SETTING_MCU_SPI_SPEED_384KHZ; speed <= SETTING_MCU_SPI_SPEED_24MHZ; speed++) {
+        // The 6 MHz cartridge clock is only available in color mode.
+        if (speed == SETTING_MCU_SPI_SPEED_6MHZ && !ws_system_is_color_active())
+            continue;
+
+        mcu_native_start();
+        mcu_native_enter_speed(speed);
+        bool ok = true;
+        bench_timer_start();
+        for (uint16_t i = 0; i < BENCH_MCU_ROUND_TRIPS && ok; i++)
+            ok = nile_mcu_native_mcu_get_version_sync(&version, sizeof(version)) >= 4;
+        time_us = bench_timer_end();
+        mcu_native_exit_speed();
+        mcu_native_finish();
+
+        bench_add(state, BENCH_TEST_MCU_ROUND_TRIP, speed, BENCH_MCU_ROUND_TRIPS, 0, ok ? time_us : 0);
+    }
+
+    // EEPROM reads only touch the MCU's buffer, leaving save data intact.
+    mcu_native_start();
+    mcu_native_enter_speed(settings.mcu_spi_speed);
+    bool ok = true;
+    bench_timer_start();
+    for (uint16_t i = 0; i < BENCH_EEPROM_WORDS && ok; i += BENCH_EEPROM_WORDS_PER_CMD)
+        ok = nile_mcu_native_eeprom_read_sync(buffer, i, BENCH_EEPROM_WORDS_PER_CMD) >= (BENCH_EEPROM_WORDS_PER_CMD * 2);
+    time_us = bench_timer_end();
+    mcu_native_exit_speed();
+    mcu_native_finish();
+
+    bench_add(state, BENCH_TEST_EEPROM_READ, settings.mcu_spi_speed,
+        BENCH_EEPROM_WORDS / BENCH_EEPROM_WORDS_PER_CMD, BENCH_EEPROM_WORDS * 2, ok ? time_us : 0);
+}
+
+// Writes lines of spaces for about one second; only bytes accepted by the
+// MCU are counted, so a host which does not read the data slows it down.
+__attribute__((noinline))
+static void bench_cdc(bench_state_t *state) {
+    char buffer[128];
+    uint32_t bytes = 0;
+
+    memset(buffer, ' ', sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\r';
+
+    mcu_native_start();
+    mcu_native_enter_speed(settings.mcu_spi_speed);
+    uint16_t target_ticks = vbl_ticks + BENCH_CDC_TICKS;
+    bench_timer_start();
+    while (((int16_t) (vbl_ticks - target_ticks)) < 0) {
+        int16_t bytes_written = nile_mcu_native_cdc_write_sync(buffer, sizeof(buffer));
+        if (bytes_written < 0)
+            break;
+        bytes += bytes_written;
+    }
+    uint32_t time_us = bench_timer_end();
+    mcu_native_exit_speed();
+    mcu_native_finish();
+
+    bench_add(state, BENCH_TEST_CDC_WRITE, settings.mcu_spi_speed, 1, bytes, bytes ? time_us : 0);
+}
+
+static const char __far *bench_param_name(const bench_result_t *result) {
+    if (result->test <= BENCH_TEST_TF_RANDOM_WRITE)
+        return bench_clock_names[result->param];
+    else
+        return bench_speed_names[result->param];
+}
+
+__attribute__((noinline))
+static int16_t bench_log(bench_state_t *state) {
+    FIL fp;
+
+    int16_t result = f_open_far(&fp, s_path_bench_log, FA_OPEN_APPEND | FA_WRITE);
+    if (result != FR_OK)
+        return result;
+
+    result = f_printf(&fp, s_bench_log_header) < 0 ? FR_INT_ERR : FR_OK;
+    for (uint8_t i = 0; i < state->count && result == FR_OK; i++) {
+        const bench_result_t *r = state->results + i;
+        result = f_printf(&fp, s_bench_log_entry, bench_test_names[r->test], bench_param_name(r),
+            r->count, r->bytes, r->time_us) < 0 ? FR_INT_ERR : FR_OK;
+    }
+
+    int16_t result2 = f_close(&fp);
+    if (result == FR_OK)
+        result = result2;
+    return result;
+}
+
+int16_t bench_run(uint8_t flags, bench_result_callback_t cb, void *userdata) {
+    bench_state_t state;
+    state.count = 0;
+    state.cb = cb;
+    state.userdata = userdata;
+
+    int16_t result = bench_tf(&state);
+    if (mcu_is_native_mode()) {
+        bench_mcu(&state);
+        if (flags & BENCH_FLAG_CDC)
+            bench_cdc(&state);
+    }
+
+    // Log whatever completed, even if the storage card tests failed.
+    if (state.count) {
+        int16_t result2 = bench_log(&state);
+        if (result == FR_OK)
+            result = result2;
+    }
+    return result;
+}
+
+void bench_format_result(char *buf, const bench_result_t *result) {
+    const char __far *name = bench_test_names[result->test];
+    const char __far *param = bench_param_name(result);
+
+    if (!result->time_us) {
+        sprintf(buf, s_bench_result_none, name, param);
+    } else if (!result->bytes) {
+        sprintf(buf, s_bench_result_latency, name, param, result->time_us / result->count);
+    } else {
+        // KB/s = bytes * 1000000 / 1024 / time_us
+        sprintf(buf, s_bench_result_rate, name, param, (result->bytes * 125 / 128) * 1000 / result->time_us);
+    }
+}
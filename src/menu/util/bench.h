@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UTIL_BENCH_H_
+#define UTIL_BENCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wonderful.h>
+
+typedef enum {
+    BENCH_TEST_TF_READ,
+    BENCH_TEST_TF_WRITE,
+    BENCH_TEST_TF_RANDOM_READ,
+    BENCH_TEST_TF_RANDOM_WRITE,
+    BENCH_TEST_MCU_ROUND_TRIP,
+    BENCH_TEST_EEPROM_READ,
+    BENCH_TEST_CDC_WRITE,
+    BENCH_TEST_COUNT
+} bench_test_t;
+
+typedef struct {
+    uint8_t test;
+    // NILE_SPI_CLOCK_* index for storage card tests, SETTING_MCU_SPI_SPEED_* otherwise.
+    uint8_t param;
+    uint16_t count;
+    uint32_t bytes;
+    // Zero if the test could not be run.
+    uint32_t time_us;
+} bench_result_t;
+
+// Also measure USB CDC write throughput; requires a connected host.
+#define BENCH_FLAG_CDC 0x01
+
+typedef void (*bench_result_callback_t)(const bench_result_t *result, void *userdata);
+
+/**
+ * @brief Run all benchmarks, then append the results to the log file.
+ *
+ * @param cb Called after each completed test.
+ */
+int16_t bench_run(uint8_t flags, bench_result_callback_t cb, void *userdata);
+
+/**
+ * @brief Format a result as a single line of text.
+ *
+ * @param buf Buffer of at least 48 bytes.
+ */
+void bench_format_result(char *buf, const bench_result_t *result);
+
+#endif /* UTIL_BENCH_H_ */
@@ -19,6 +19,7 @@
 #include <string.h>
 #include <ws.h>
 #include <ws/memory.h>
+#include "bootstub.h"
 #include "file.h"
 #include "errors.h"
 
@@ -85,9 +86,8 @@ FRESULT f_unlink_far(const char __far* path) {
     return f_unlink(local_path);
 }
 
-int16_t f_read_sram_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) {
+static int16_t f_read_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) {
     uint16_t prev_bank = inportw(WS_CART_EXTBANK_RAM_PORT);
-
     unsigned int lbr;
     uint32_t br = 0;
     uint32_t bytes_total = btr;
@@ -118,6 +118,23 @@ int16_t f_read_sram_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progres
     return FR_OK;
 }
 
+int16_t f_read_sram_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) {
+    // The caller may have mapped PSRAM into the SRAM window.
+    if (inportb(WS_CART_BANK_FLASH_PORT) & WS_CART_BANK_FLASH_ENABLE)
+        bootstub_resident_invalidate(bank, bank + ((btr + 0xFFFF) >> 16));
+    return f_read_banked(fp, bank, btr, cb, userdata);
+}
+
+int16_t f_read_rom_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) {
+    int16_t result;
+
+    bootstub_resident_invalidate(bank, bank + ((btr + 0xFFFF) >> 16));
+    ws_bank_with_flash(WS_CART_BANK_FLASH_ENABLE, {
+        result = f_read_banked(fp, bank, btr, cb, userdata);
+    });
+    return result;
+}
+
 int16_t f_write_rom_banked(FIL* fp, uint16_t bank, uint32_t btw, fbanked_progress_callback_t cb, void *userdata, bool verify) {
     uint16_t prev_bank = inportw(WS_CART_EXTBANK_ROM0_PORT);
     unsigned int lbw;
@@ -214,3 +231,84 @@ int16_t f_write_sram_banked(FIL* fp, uint16_t bank, uint32_t btw, fbanked_progre
     outportw(WS_CART_EXTBANK_RAM_PORT, prev_bank);
     return FR_OK;
 }
+
+// Compare a block of banked memory with the file contents at the current position.
+static int16_t f_compare_banked_block(FIL* fp, uint16_t bank_port, uint16_t bank, const uint8_t __far *src, uint16_t len, uint8_t *buffer, uint16_t buffer_size) {
+    unsigned int lbr;
+
+    for (uint16_t i = 0; i < len; i += buffer_size) {
+        uint16_t part = len - i > buffer_size ? buffer_size : len - i;
+        int16_t result = f_read(fp, buffer, part, &lbr);
+        if (result != FR_OK)
+            return result;
+        outportw(bank_port, bank);
+        if (lbr != part || _fmemcmp(buffer, src + i, part))
+            return ERR_SAVE_VERIFY_FAILED;
+    }
+
+    return FR_OK;
+}
+
+int16_t f_write_banked_blocks(FIL* fp, uint16_t bank, uint32_t btw, bool rom, fbanked_progress_callback_t cb, void *userdata, bool verify) {
+    uint16_t bank_port = rom ? WS_CART_EXTBANK_ROM0_PORT : WS_CART_EXTBANK_RAM_PORT;
+    uint16_t segment = rom ? WS_ROM0_SEGMENT : WS_SRAM_SEGMENT;
+    uint16_t prev_bank = inportw(bank_port);
+    unsigned int lbw;
+    int16_t result = FR_OK;
+    INIT_SECTOR_BUFFER;
+
+    for (uint32_t pos = 0; pos < btw; pos += F_BLOCK_SIZE) {
+        uint16_t block_len = btw - pos > F_BLOCK_SIZE ? F_BLOCK_SIZE : btw - pos;
+        uint16_t block_bank = bank + (pos >> 16);
+        const uint8_t __far *src = MK_FP(segment, (uint16_t) pos);
+
+        if (cb) cb(userdata, pos + block_len, btw);
+
+        result = f_lseek(fp, pos);
+        if (result != FR_OK)
+            goto f_write_banked_blocks_end;
+
+        // Skip blocks which already match the file.
+        if (pos + block_len <= f_size(fp)) {
+            result = f_compare_banked_block(fp, bank_port, block_bank, src, block_len, buffer, buffer_size);
+            if (result == FR_OK)
+                continue;
+            if (result != ERR_SAVE_VERIFY_FAILED)
+                goto f_write_banked_blocks_end;
+
+            result = f_lseek(fp, pos);
+            if (result != FR_OK)
+                goto f_write_banked_blocks_end;
+        }
+
+        if (rom) {
+            outportw(bank_port, block_bank);
+            result = f_write(fp, src, block_len, &lbw);
+            if (result != FR_OK)
+                goto f_write_banked_blocks_end;
+        } else {
+            // Reading directly from SRAM would conflict with the SPI buffer.
+            for (uint16_t i = 0; i < block_len; i += buffer_size) {
+                uint16_t len = block_len - i > buffer_size ? buffer_size : block_len - i;
+                outportw(bank_port, block_bank);
+                _fmemcpy(buffer, src + i, len);
+                result = f_write(fp, buffer, len, &lbw);
+                if (result != FR_OK)
+                    goto f_write_banked_blocks_end;
+            }
+        }
+
+        if (verify) {
+            result = f_lseek(fp, pos);
+            if (result != FR_OK)
+                goto f_write_banked_blocks_end;
+            result = f_compare_banked_block(fp, bank_port, block_bank, src, block_len, buffer, buffer_size);
+            if (result != FR_OK)
+                goto f_write_banked_blocks_end;
+        }
+    }
+
+f_write_banked_blocks_end:
+    outportw(bank_port, prev_bank);
+    return result;
+}
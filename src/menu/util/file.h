@@ -44,13 +44,22 @@ FRESULT f_unlink_far(const char __far* path);
 typedef void (*fbanked_progress_callback_t)(void *userdata, uint32_t step, uint32_t max);
 
 int16_t f_read_sram_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata);
-static inline int16_t f_read_rom_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) {
-    ws_bank_with_flash(WS_CART_BANK_FLASH_ENABLE, {
-        return f_read_sram_banked(fp, bank, btr, cb, userdata);
-    });
-}
+int16_t f_read_rom_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata);
 
 int16_t f_write_rom_banked(FIL* fp, uint16_t bank, uint32_t btw, fbanked_progress_callback_t cb, void *userdata, bool verify);
 int16_t f_write_sram_banked(FIL* fp, uint16_t bank, uint32_t btw, fbanked_progress_callback_t cb, void *userdata, bool verify);
 
+#define F_BLOCK_SHIFT 12
+#define F_BLOCK_SIZE (1 << F_BLOCK_SHIFT)
+
+/**
+ * @brief Write banked memory to a file, skipping blocks which have not changed.
+ *
+ * Each F_BLOCK_SIZE block is first compared with the file's existing
+ * contents; only blocks which differ are written (and verified).
+ *
+ * @param rom Read from the ROM0 window instead of the SRAM window.
+ */
+int16_t f_write_banked_blocks(FIL* fp, uint16_t bank, uint32_t btw, bool rom, fbanked_progress_callback_t cb, void *userdata, bool verify);
+
 #endif /* UTIL_FILE_H_ */
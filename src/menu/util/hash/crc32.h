@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UTIL_HASH_CRC32_H_
+#define UTIL_HASH_CRC32_H_
+
+#include <stdint.h>
+#include <wonderful.h>
+
+// Initial value of a CRC-32 (ISO-HDLC, as used by zlib and ZIP).
+#define CRC32_INIT 0xFFFFFFFFUL
+
+/**
+ * @brief Add len bytes to a running CRC-32.
+ *
+ * Start from CRC32_INIT; the final CRC is the running value XORed with
+ * 0xFFFFFFFF, or crc32_final().
+ */
+uint32_t crc32_update(uint32_t crc, uint16_t len, const void __far *ptr);
+
+static inline uint32_t crc32_final(uint32_t crc) {
+    return ~crc;
+}
+
+#endif /* UTIL_HASH_CRC32_H_ */
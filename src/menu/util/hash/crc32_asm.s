@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <wonderful.h>
+
+    .arch   i186
+    .code16
+    .intel_syntax noprefix
+
+    .section .fartext.s.crc32, "ax"
+
+    // Reflected polynomial 0xEDB88320, one entry per byte value, stored as
+    // four 256-byte planes: byte 0 of every entry, then byte 1, and so on.
+crc32_table:
+#include "crc32_table.inc"
+
+    // crc = table[(crc & 0xFF) ^ byte] ^ (crc >> 8), with the four bytes of
+    // crc held in c0 (lowest) to c3. The result is left in c1, c2, c3, c0,
+    // so consecutive steps rotate the roles of the registers.
+    // bh = 0, ds = cs, si = table + 256, di = table + 512, es:bp = data
+    .macro STEP c0, c1, c2, c3, ofs
+    mov bl, es:[bp + \ofs]
+    xor bl, \c0
+    xor \c1, [bx + crc32_table]
+    xor \c2, [bx + si]
+    xor \c3, [bx + di]
+    mov \c0, [bx + crc32_table + 768]
+    .endm
+
+    // uint32_t crc32_update(uint32_t crc, uint16_t len, const void __far *ptr)
+    // dx:ax = crc, cx = len, stack = ptr
+    .global crc32_update
+crc32_update:
+    push si
+    push di
+    push ds
+    push es
+    push bp
+    mov bp, sp
+
+    les bp, [bp + IA16_CALL_STACK_OFFSET(10)]
+    push cs
+    pop ds
+    mov si, offset crc32_table + 256
+    mov di, offset crc32_table + 512
+    xor bx, bx
+
+    // Single bytes, until the rest is a multiple of 4.
+    push cx
+    and cx, 3
+    jcxz 2f
+1:
+    STEP al, ah, dl, dh, 0
+    inc bp
+    mov bl, al
+    mov al, ah
+    mov ah, dl
+    mov dl, dh
+    mov dh, bl
+    loop 1b
+
+2:
+    pop cx
+    shr cx, 2
+    jcxz 4f
+3:
+    STEP al, ah, dl, dh, 0
+    STEP ah, dl, dh, al, 1
+    STEP dl, dh, al, ah, 2
+    STEP dh, al, ah, dl, 3
+    add bp, 4
+    loop 3b
+
+4:
+    pop bp
+    pop es
+    pop ds
+    pop di
+    pop si
+    IA16_RET 0x4
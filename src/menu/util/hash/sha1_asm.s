@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <wonderful.h>
+
+    .arch   i186
+    .code16
+    .intel_syntax noprefix
+
+    // Stack frame, relative to BP: working variables a-e, followed by the
+    // 16-entry message schedule. 32-bit values are stored low word first.
+    .equ VA, -84
+    .equ VB, -80
+    .equ VC, -76
+    .equ VD, -72
+    .equ VE, -68
+    .equ W0, -64
+    .equ STATE_PTR, -86
+
+    // dx:ax = W[i & 15] = rol(W[i-3] ^ W[i-8] ^ W[i-14] ^ W[i-16], 1)
+    .macro EXPAND i
+    mov ax, [bp + W0 + 4*((\i + 13) & 15)]
+    mov dx, [bp + W0 + 4*((\i + 13) & 15) + 2]
+    xor ax, [bp + W0 + 4*((\i + 8) & 15)]
+    xor dx, [bp + W0 + 4*((\i + 8) & 15) + 2]
+    xor ax, [bp + W0 + 4*((\i + 2) & 15)]
+    xor dx, [bp + W0 + 4*((\i + 2) & 15) + 2]
+    xor ax, [bp + W0 + 4*(\i & 15)]
+    xor dx, [bp + W0 + 4*(\i & 15) + 2]
+    shl ax, 1
+    rcl dx, 1
+    adc ax, 0
+    mov [bp + W0 + 4*(\i & 15)], ax
+    mov [bp + W0 + 4*(\i & 15) + 2], dx
+    .endm
+
+    // z += f(w, x, y) + W[i] + k + rol(v, 5); w = rol(w, 30)
+    // f: 0 = choose, 1 = parity, 2 = majority
+    .macro ROUND f, v, w, x, y, z, i, klo, khi
+    .if \i < 16
+    mov ax, [bp + W0 + 4*\i]
+    mov dx, [bp + W0 + 4*\i + 2]
+    .else
+    EXPAND \i
+    .endif
+    add ax, \klo
+    adc dx, \khi
+
+    .if \f == 0
+    mov bx, [bp + \x]
+    xor bx, [bp + \y]
+    and bx, [bp + \w]
+    xor bx, [bp + \y]
+    mov cx, [bp + \x + 2]
+    xor cx, [bp + \y + 2]
+    and cx, [bp + \w + 2]
+    xor cx, [bp + \y + 2]
+    .elseif \f == 1
+    mov bx, [bp + \w]
+    xor bx, [bp + \x]
+    xor bx, [bp + \y]
+    mov cx, [bp + \w + 2]
+    xor cx, [bp + \x + 2]
+    xor cx, [bp + \y + 2]
+    .else
+    mov bx, [bp + \w]
+    mov si, bx
+    or bx, [bp + \x]
+    and bx, [bp + \y]
+    and si, [bp + \x]
+    or bx, si
+    mov cx, [bp + \w + 2]
+    mov si, cx
+    or cx, [bp + \x + 2]
+    and cx, [bp + \y + 2]
+    and si, [bp + \x + 2]
+    or cx, si
+    .endif
+    add ax, bx
+    adc dx, cx
+
+    mov bx, [bp + \v]
+    mov cx, [bp + \v + 2]
+    mov si, bx
+    mov di, cx
+    shl bx, 5
+    shr di, 11
+    or bx, di
+    shl cx, 5
+    shr si, 11
+    or cx, si
+    add ax, bx
+    adc dx, cx
+
+    add [bp + \z], ax
+    adc [bp + \z + 2], dx
+
+    mov ax, [bp + \w]
+    mov dx, [bp + \w + 2]
+    mov bx, ax
+    mov cx, dx
+    shr ax, 2
+    shl cx, 14
+    or ax, cx
+    shr dx, 2
+    shl bx, 14
+    or dx, bx
+    mov [bp + \w], ax
+    mov [bp + \w + 2], dx
+    .endm
+
+    // Five rounds, after which the working variables are back in place.
+    .macro ROUND5 f, i, klo, khi
+    ROUND \f, VA, VB, VC, VD, VE, (\i), \klo, \khi
+    ROUND \f, VE, VA, VB, VC, VD, (\i + 1), \klo, \khi
+    ROUND \f, VD, VE, VA, VB, VC, (\i + 2), \klo, \khi
+    ROUND \f, VC, VD, VE, VA, VB, (\i + 3), \klo, \khi
+    ROUND \f, VB, VC, VD, VE, VA, (\i + 4), \klo, \khi
+    .endm
+
+    // void SHA1_Transform(const uint8_t __far *buffer, uint32_t *state)
+    // Hash a single 64-byte block into state.
+    .section .fartext.s.sha1, "ax"
+    .global SHA1_Transform
+SHA1_Transform:
+    push si
+    push di
+    push bp
+    push ds
+    mov bp, sp
+    sub sp, 84
+    push cx
+
+    push ss
+    pop es
+    cld
+
+    // a-e = state
+    mov si, cx
+    lea di, [bp + VA]
+    mov cx, 10
+    rep movsw
+
+    // W[0-15] = big-endian words of the block; DI now points to W0.
+    mov si, ax
+    mov ds, dx
+    mov cx, 16
+1:
+    lodsw
+    xchg al, ah
+    mov dx, ax
+    lodsw
+    xchg al, ah
+    stosw
+    mov ax, dx
+    stosw
+    loop 1b
+    mov ds, [bp]
+
+    ROUND5 0, 0, 0x7999, 0x5A82
+    ROUND5 0, 5, 0x7999, 0x5A82
+    ROUND5 0, 10, 0x7999, 0x5A82
+    ROUND5 0, 15, 0x7999, 0x5A82
+    ROUND5 1, 20, 0xEBA1, 0x6ED9
+    ROUND5 1, 25, 0xEBA1, 0x6ED9
+    ROUND5 1, 30, 0xEBA1, 0x6ED9
+    ROUND5 1, 35, 0xEBA1, 0x6ED9
+    ROUND5 2, 40, 0xBCDC, 0x8F1B
+    ROUND5 2, 45, 0xBCDC, 0x8F1B
+    ROUND5 2, 50, 0xBCDC, 0x8F1B
+    ROUND5 2, 55, 0xBCDC, 0x8F1B
+    ROUND5 1, 60, 0xC1D6, 0xCA62
+    ROUND5 1, 65, 0xC1D6, 0xCA62
+    ROUND5 1, 70, 0xC1D6, 0xCA62
+    ROUND5 1, 75, 0xC1D6, 0xCA62
+
+    // state += a-e
+    mov di, [bp + STATE_PTR]
+    .irp n, 0, 1, 2, 3, 4
+    mov ax, [bp + VA + 4*\n]
+    mov dx, [bp + VA + 4*\n + 2]
+    add [di + 4*\n], ax
+    adc [di + 4*\n + 2], dx
+    .endr
+
+    mov sp, bp
+    pop ds
+    pop bp
+    pop di
+    pop si
+    IA16_RET
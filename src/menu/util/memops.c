@@ -18,14 +18,14 @@
 #include <string.h>
 #include <ws.h>
 #include "../errors.h"
+#include "bootstub.h"
 #include "memops.h"
 #include "puff/puff.h"
 
-int16_t memops_unpack_psram_data_if_gzip(uint16_t *bank, uint16_t dest_bank) {
-    uint16_t src_bank = *bank;
+int16_t memops_find_psram_gzip_data(uint16_t bank, uint16_t *offset) {
     uint8_t __far* header = MK_FP(WS_ROM0_SEGMENT, 0x0000);
 
-    ws_bank_with_rom0(src_bank, {
+    ws_bank_with_rom0(bank, {
         if (((uint16_t __far*) header)[0] != 0x8B1F) {
             // not a gzip file
             return ERR_MCU_BIN_CORRUPT;
@@ -41,26 +41,41 @@ int16_t memops_unpack_psram_data_if_gzip(uint16_t *bank, uint16_t dest_bank) {
             return ERR_MCU_BIN_CORRUPT;
         }
 
-        uint16_t offset = 10;
+        uint16_t ofs = 10;
         if (header[3] & 0x04) {
             // Skip FEXTRA
-            offset += *((uint16_t __far*) (header + offset)) + 2;
+            ofs += *((uint16_t __far*) (header + ofs)) + 2;
         }
         if (header[3] & 0x08) {
             // Skip FNAME
-            offset += strlen((const char __far*) header + offset) + 1;
+            ofs += strlen((const char __far*) header + ofs) + 1;
         }
         if (header[3] & 0x10) {
             // Skip FCOMMENT
-            offset += strlen((const char __far*) header + offset) + 1;
+            ofs += strlen((const char __far*) header + ofs) + 1;
         }
         if (header[3] & 0x02) {
             // Skip FHCRC
-            offset += 2;
+            ofs += 2;
         }
 
-        *bank = dest_bank;
-        int16_t result = FR_OK;
+        *offset = ofs;
+        return FR_OK;
+    });
+}
+
+int16_t memops_unpack_psram_data_if_gzip(uint16_t *bank, uint16_t dest_bank) {
+    uint16_t src_bank = *bank;
+    uint16_t offset;
+
+    int16_t result = memops_find_psram_gzip_data(src_bank, &offset);
+    if (result != FR_OK) {
+        return result;
+    }
+
+    *bank = dest_bank;
+    bootstub_resident_invalidate(dest_bank, 0x80);
+    ws_bank_with_rom0(src_bank, {
         ws_bank_with_flash(WS_CART_BANK_FLASH_ENABLE, {
             ws_bank_with_ram(dest_bank, {
                 if (puff(
@@ -73,6 +88,6 @@ int16_t memops_unpack_psram_data_if_gzip(uint16_t *bank, uint16_t dest_bank) {
                 }
             });
         });
-        return result;
     });
+    return result;
 }
@@ -23,6 +23,15 @@
 #include <wonderful.h>
 #include "config.h"
 
+/**
+ * @brief Locate the DEFLATE stream of GZIP data in PSRAM.
+ *
+ * @param bank Bank containing the start of the GZIP data.
+ * @param offset Offset of the DEFLATE stream from the start of the bank.
+ * @return int16_t 0 if successful; error code if the data is not in a supported GZIP format.
+ */
+int16_t memops_find_psram_gzip_data(uint16_t bank, uint16_t *offset);
+
 /**
  * @brief Unpack data in PSRAM, if GZIP format.
  * 
@@ -3,6 +3,8 @@
  * Copyright (C) 2002-2013 Mark Adler
  * Modifications for Wonderful (C) 2025 Adrian "asie" Siekierka:
  * - support RAM/ROM0/ROM1 banks as > 64KB sources
+ * - support streaming output to a ring of PSRAM banks
+ * - decode Huffman codes using lookup tables
  *
  * For conditions of distribution and use, see copyright notice in puff.h
  *
@@ -103,6 +105,17 @@
 #define MAXCODES (MAXLCODES+MAXDCODES)  /* maximum codes lengths to read */
 #define FIXLCODES 288           /* number of fixed literal/length codes */
 
+/*
+ * Bits looked up at once when decoding literal/length and distance codes.
+ * Longer codes are decoded one bit at a time.
+ */
+#define FASTLBITS 9
+#define FASTDBITS 7
+#define FASTCBITS 7             /* code length codes are at most seven bits */
+
+/* symbols decoded between ring poll() calls */
+#define RING_POLL_SYMBOLS 256
+
 /*
  * Huffman code decoding tables.  count[1..MAXBITS] is the number of symbols of
  * each length, which for a canonical code are stepped through in order.
@@ -113,6 +126,8 @@
 struct huffman {
     short *count;       /* number of symbols of each length */
     short *symbol;      /* canonically ordered symbols */
+    const unsigned short __far *fast;   /* lookup table, see construct_fast() */
+    short fastbits;     /* number of bits indexing fast[] */
 };
 
 /* input and output state */
@@ -121,12 +136,14 @@ struct state {
     unsigned char __far* out;         /* output buffer */
     unsigned long outlen;       /* available space at out */
     unsigned long outcnt;       /* bytes written to out so far */
+    puff_ring_t *ring;          /* output ring, if streaming */
+    unsigned pollcnt;           /* symbols left until next poll() */
 
     /* input state */
     const unsigned char __far* in;    /* input buffer */
     unsigned long inlen;        /* available input at in */
     unsigned long incnt;        /* bytes read so far */
-    int bitbuf;                 /* bit buffer */
+    unsigned bitbuf;            /* bit buffer */
     int bitcnt;                 /* number of bits in bit buffer */
 
     /* input limit error return state for bits() and decode() */
@@ -138,6 +155,9 @@ struct state {
     short distcnt[MAXBITS+1], distsym[MAXDCODES];
     struct huffman lencode, distcode;
 #endif
+#if CACHE_TABLES == 0
+    unsigned short lenfast[1 << FASTLBITS], distfast[1 << FASTDBITS];
+#endif
 };
 
 #if CACHE_TABLES == 2
@@ -160,11 +180,66 @@ local void advance_bank(unsigned int segment, unsigned count)
     }
 }
 
+local void ring_poll(struct state *s)
+{
+    s->ring->pos = (unsigned) s->outcnt;
+    if (!s->ring->poll(s->ring))
+        longjmp(s->env, PUFF_RING_ABORTED);
+}
+
+local void ring_set_bank(struct state *s, int delta)
+{
+    puff_ring_t *ring = s->ring;
+    outportw(WS_CART_EXTBANK_RAM_PORT, ring->bank_first + ((uint8_t) (ring->bank + delta) & ring->bank_mask));
+}
+
+local void ring_enter_bank(struct state *s)
+{
+    /* wait for the consumer to leave the bank about to be overwritten */
+    while ((int8_t) (s->ring->bank - s->ring->read_bank) > s->ring->bank_mask)
+        ring_poll(s);
+    ring_set_bank(s, 0);
+}
+
+local void advance_out_bank(struct state *s)
+{
+    if (s->ring != NULL)
+    {
+        s->outcnt = 0;
+        s->ring->bank++;
+        ring_enter_bank(s);
+    }
+    else
+    {
+        advance_bank(FP_SEG(s->out), s->outcnt >> 16);
+        s->outlen -= s->outcnt & ~0xFFFFUL;
+        s->outcnt &= 0xFFFF;
+    }
+}
+
+local void enter_previous_out_bank(struct state *s)
+{
+    if (s->ring != NULL)
+        ring_set_bank(s, -1);
+    else
+        advance_bank(FP_SEG(s->out), -1);
+}
+
+local void leave_previous_out_bank(struct state *s)
+{
+    if (s->ring != NULL)
+        ring_set_bank(s, 0);
+    else
+        advance_bank(FP_SEG(s->out), 1);
+}
+
 local unsigned char get_byte(struct state *s)
 {
     if (s->incnt >= 0x10000)
     {
+        /* keep inlen relative to the current bank, like incnt */
         advance_bank(FP_SEG(s->in), s->incnt >> 16);
+        s->inlen -= s->incnt & ~0xFFFFUL;
         s->incnt &= 0xFFFF;
     }
     return s->in[s->incnt++];
@@ -173,10 +248,7 @@ local unsigned char get_byte(struct state *s)
 local void put_byte(struct state *s, unsigned char v)
 {
     if (s->outcnt >= 0x10000)
-    {
-        advance_bank(FP_SEG(s->out), s->outcnt >> 16);
-        s->outcnt &= 0xFFFF;
-    }
+        advance_out_bank(s);
     s->out[s->outcnt++] = v;
 }
 
@@ -199,24 +271,17 @@ local void copy_previous_bytes(struct state *s, unsigned dist, int len)
     if (s->outcnt >= dist && (s->outcnt + len) < 0x10000)
     {
         if (dist >= 2)
-        {
             memcpy(s->out + s->outcnt, s->out + (s->outcnt - dist), len);
-            s->outcnt += len;
-        } else while (len--)
-        {
-            s->out[s->outcnt] = s->out[s->outcnt - dist];
-            s->outcnt++;
-        }
+        else
+            memset(s->out + s->outcnt, s->out[s->outcnt - 1], len);
+        s->outcnt += len;
         return;
     }
 
     while (len--)
     {
         if (s->outcnt >= 0x10000)
-        {
-            advance_bank(FP_SEG(s->out), s->outcnt >> 16);
-            s->outcnt &= 0xFFFF;
-        }
+            advance_out_bank(s);
 
         if (s->outcnt >= dist)
         {
@@ -228,9 +293,9 @@ local void copy_previous_bytes(struct state *s, unsigned dist, int len)
                 // shouldn't need distances over 65536?
                 while(1);
             }
-            advance_bank(FP_SEG(s->out), -1);
-            unsigned char v = s->out[(unsigned) (s->outcnt - dist)];
-            advance_bank(FP_SEG(s->out), 1);
+            enter_previous_out_bank(s);
+            unsigned char v = s->out[(uint16_t) (s->outcnt - dist)];
+            leave_previous_out_bank(s);
             s->out[s->outcnt] = v;
         }
         s->outcnt++;
@@ -238,8 +303,8 @@ local void copy_previous_bytes(struct state *s, unsigned dist, int len)
 }
 
 /*
- * Return need bits from the input stream.  This always leaves less than
- * eight bits in the buffer.  bits() works properly for need == 0.
+ * Return need bits from the input stream.  This leaves at most sixteen bits
+ * in the buffer.  bits() works properly for need == 0.
  *
  * Format notes:
  *
@@ -261,8 +326,8 @@ local int bits(struct state *s, int need)
         s->bitcnt += 8;
     }
 
-    /* drop need bits and update buffer, always zero to seven bits left */
-    s->bitbuf = (int)(val >> need);
+    /* drop need bits and update buffer */
+    s->bitbuf = (unsigned)(val >> need);
     s->bitcnt -= need;
 
     /* return need bits, zeroing the bits above that */
@@ -290,17 +355,15 @@ local int stored(struct state *s)
 {
     unsigned len;       /* length of stored block */
 
-    /* discard leftover bits from current byte (assumes s->bitcnt < 8) */
-    s->bitbuf = 0;
-    s->bitcnt = 0;
+    /* discard leftover bits from current byte */
+    bits(s, s->bitcnt & 7);
 
-    /* get length and check against its one's complement */
-    if (s->incnt + 4 > s->inlen)
-        return 2;                               /* not enough input */
-    len = get_byte(s);
-    len |= get_byte(s) << 8;
-    if (get_byte(s) != (~len & 0xff) ||
-        get_byte(s) != ((~len >> 8) & 0xff))
+    /*
+     * get length and check against its one's complement; the bit buffer may
+     * hold whole bytes read ahead by decode(), and is empty afterwards
+     */
+    len = bits(s, 16);
+    if (bits(s, 16) != (~len & 0xffff))
         return -2;                              /* didn't match complement! */
 
     /* copy len bytes from in to out */
@@ -343,8 +406,7 @@ local int stored(struct state *s)
  * - Incomplete codes are handled by this decoder, since they are permitted
  *   in the deflate format.  See the format notes for fixed() and dynamic().
  */
-#ifdef SLOW
-local int decode(struct state *s, const struct huffman *h)
+local int decode_slow(struct state *s, const struct huffman *h)
 {
     int len;            /* current number of bits in code */
     int code;           /* len bits being decoded */
@@ -367,55 +429,31 @@ local int decode(struct state *s, const struct huffman *h)
 }
 
 /*
- * A faster version of decode() for real applications of this code.   It's not
- * as readable, but it makes puff() twice as fast.  And it only makes the code
- * a few percent larger.
+ * A table-driven version of decode().  Codes of up to h->fastbits bits are
+ * decoded with a single lookup; only longer codes, and invalid codes, are
+ * passed on to decode_slow().
  */
-#else /* !SLOW */
 local int decode(struct state *s, const struct huffman *h)
 {
-    int len;            /* current number of bits in code */
-    int code;           /* len bits being decoded */
-    int first;          /* first code of length len */
-    int count;          /* number of codes of length len */
-    int index;          /* index of first code of length len in symbol table */
-    int bitbuf;         /* bits from stream */
-    int left;           /* bits left in next or left to process */
-    short *next;        /* next number of codes */
+    unsigned entry;     /* lookup table entry */
+    int len;            /* length of the code found */
 
-    bitbuf = s->bitbuf;
-    left = s->bitcnt;
-    code = first = index = 0;
-    len = 1;
-    next = h->count + 1;
-    while (1) {
-        while (left--) {
-            code |= bitbuf & 1;
-            bitbuf >>= 1;
-            count = *next++;
-            if (code - count < first) { /* if length len, return symbol */
-                s->bitbuf = bitbuf;
-                s->bitcnt = (s->bitcnt - len) & 7;
-                return h->symbol[index + (code - first)];
-            }
-            index += count;             /* else update for next length */
-            first += count;
-            first <<= 1;
-            code <<= 1;
-            len++;
-        }
-        left = (MAXBITS+1) - len;
-        if (left == 0)
-            break;
-        if (s->incnt == s->inlen)
-            longjmp(s->env, 1);         /* out of input */
-        bitbuf = get_byte(s);
-        if (left > 8)
-            left = 8;
+    /* fill the bit buffer, as far as a whole byte still fits */
+    while (s->bitcnt <= 8 && s->incnt != s->inlen) {
+        s->bitbuf |= (unsigned)get_byte(s) << s->bitcnt;
+        s->bitcnt += 8;
     }
-    return -10;                         /* ran out of codes */
+
+    entry = h->fast[s->bitbuf & ((1 << h->fastbits) - 1)];
+    len = entry >> 12;
+    if (len == 0)
+        return decode_slow(s, h);
+    if (len > s->bitcnt)
+        longjmp(s->env, 1);             /* out of input */
+    s->bitbuf >>= len;
+    s->bitcnt -= len;
+    return entry & 0x1ff;
 }
-#endif /* SLOW */
 
 /*
  * Given the list of code lengths length[0..n-1] representing a canonical
@@ -490,6 +528,49 @@ local int construct(struct huffman *h, const short *length, int n)
     return left;
 }
 
+/*
+ * Fill in the lookup table fast[] for h, indexed by the next h->fastbits bits
+ * of the stream.  Each entry holds the code length in its top four bits and
+ * the symbol in its low nine bits; codes longer than h->fastbits, and unused
+ * codes of incomplete sets, have zero entries.
+ *
+ * Format notes:
+ *
+ * - As codes are stored starting from their most significant bit, a code
+ *   of length len is found at the table indexes whose low len bits are the
+ *   code reversed.
+ */
+local void construct_fast(struct huffman *h, unsigned short *fast, int fastbits)
+{
+    int len;            /* current code length */
+    int count;          /* codes of length len left to add */
+    int index;          /* index of current symbol in h->symbol[] */
+    int code;           /* current code */
+    int i;              /* bit index */
+    unsigned rev;       /* current code, reversed */
+    unsigned size;      /* number of entries in fast[] */
+    unsigned short entry;
+
+    size = 1 << fastbits;
+    memset(fast, 0, size * sizeof(unsigned short));
+    h->fast = fast;
+    h->fastbits = fastbits;
+
+    code = index = 0;
+    for (len = 1; len <= fastbits; len++) {
+        for (count = h->count[len]; count > 0; count--) {
+            rev = 0;
+            for (i = 0; i < len; i++)
+                rev |= ((code >> i) & 1) << (len - 1 - i);
+            entry = (len << 12) | h->symbol[index++];
+            for (; rev < size; rev += 1 << len)
+                fast[rev] = entry;
+            code++;
+        }
+        code <<= 1;
+    }
+}
+
 /*
  * Decode literal/length and distance codes until an end-of-block code.
  *
@@ -570,6 +651,10 @@ local int codes(struct state *s,
 
     /* decode literals and length/distance pairs */
     do {
+        if (s->ring != NULL && --s->pollcnt == 0) {
+            s->pollcnt = RING_POLL_SYMBOLS;
+            ring_poll(s);
+        }
         symbol = decode(s, lencode);
         if (symbol < 0)
             return symbol;              /* invalid symbol */
@@ -653,6 +738,11 @@ local int fixed(struct state *s)
         memcpy(s->distcnt, fixed_distcnt, sizeof(fixed_distcnt));
         memcpy(s->distsym, fixed_distsym, sizeof(fixed_distsym));
 
+        s->lencode.fast = fixed_lenfast;
+        s->lencode.fastbits = FASTLBITS;
+        s->distcode.fast = fixed_distfast;
+        s->distcode.fastbits = FASTDBITS;
+
         s->initialized = true;
     }
 
@@ -662,6 +752,7 @@ local int fixed(struct state *s)
     static bool initialized = false;
     static short lencnt[MAXBITS+1], lensym[FIXLCODES];
     static short distcnt[MAXBITS+1], distsym[MAXDCODES];
+    static unsigned short lenfast[1 << FASTLBITS], distfast[1 << FASTDBITS];
     static struct huffman lencode, distcode;
 
     /* build fixed huffman tables if first call (may not be thread safe) */
@@ -685,11 +776,13 @@ local int fixed(struct state *s)
         for (; symbol < FIXLCODES; symbol++)
             lengths[symbol] = 8;
         construct(&lencode, lengths, FIXLCODES);
+        construct_fast(&lencode, lenfast, FASTLBITS);
 
         /* distance table */
         for (symbol = 0; symbol < MAXDCODES; symbol++)
             lengths[symbol] = 5;
         construct(&distcode, lengths, MAXDCODES);
+        construct_fast(&distcode, distfast, FASTDBITS);
 
         /* do this just once */
         initialized = true;
@@ -719,11 +812,13 @@ local int fixed(struct state *s)
         for (; symbol < FIXLCODES; symbol++)
             lengths[symbol] = 8;
         construct(&s->lencode, lengths, FIXLCODES);
+        construct_fast(&s->lencode, s->lenfast, FASTLBITS);
 
         /* distance table */
         for (symbol = 0; symbol < MAXDCODES; symbol++)
             lengths[symbol] = 5;
         construct(&s->distcode, lengths, MAXDCODES);
+        construct_fast(&s->distcode, s->distfast, FASTDBITS);
 
         /* do this just once */
         s->initialized = true;
@@ -833,6 +928,8 @@ local int dynamic(struct state *s)
     short lencnt[MAXBITS+1], lensym[MAXLCODES];         /* lencode memory */
     short distcnt[MAXBITS+1], distsym[MAXDCODES];       /* distcode memory */
     struct huffman lencode, distcode;   /* length and distance codes */
+    /* lookup tables; static, as they would not fit on the stack */
+    static unsigned short lenfast[1 << FASTLBITS], distfast[1 << FASTDBITS];
 
     /* construct lencode and distcode */
     lencode.count = lencnt;
@@ -857,6 +954,7 @@ local int dynamic(struct state *s)
     err = construct(&lencode, lengths, 19);
     if (err != 0)               /* require complete code set here */
         return -4;
+    construct_fast(&lencode, lenfast, FASTCBITS);
 
     /* read length/literal and distance code length tables */
     index = 0;
@@ -896,11 +994,13 @@ local int dynamic(struct state *s)
     err = construct(&lencode, lengths, nlen);
     if (err && (err < 0 || nlen != lencode.count[0] + lencode.count[1]))
         return -7;      /* incomplete code ok only for single length 1 code */
+    construct_fast(&lencode, lenfast, FASTLBITS);
 
     /* build huffman table for distance codes */
     err = construct(&distcode, lengths + nlen, ndist);
     if (err && (err < 0 || ndist != distcode.count[0] + distcode.count[1]))
         return -8;      /* incomplete code ok only for single length 1 code */
+    construct_fast(&distcode, distfast, FASTDBITS);
 
     /* decode data until end-of-block code */
     return codes(s, &lencode, &distcode);
@@ -950,19 +1050,81 @@ local int dynamic(struct state *s)
  *   block (if it was a fixed or dynamic block) are undefined and have no
  *   expected values to check.
  */
+local int blocks(struct state *s)
+{
+    int last, type;             /* block information */
+    int err;                    /* return value */
+
+    /* return if bits() or decode() tries to read past available input */
+    switch (setjmp(s->env)) {
+    case 0:
+        /* process blocks until last block or error */
+        do {
+            last = bits(s, 1);          /* one if last block */
+            type = bits(s, 2);          /* block type 0..3 */
+            err = type == 0 ?
+                    stored(s) :
+                    (type == 1 ?
+                        fixed(s) :
+                        (type == 2 ?
+                            dynamic(s) :
+                            -1));       /* type == 3, invalid */
+            if (err != 0)
+                break;                  /* return with error */
+            if (s->ring != NULL)
+                ring_poll(s);
+        } while (!last);
+        break;
+    case PUFF_RING_ABORTED:             /* if poll() requested an abort */
+        err = PUFF_RING_ABORTED;
+        break;
+    default:                            /* if came back here via longjmp() */
+        err = 2;                        /* then skip do-loop, return error */
+        break;
+    }
+
+    return err;
+}
+
 int puff(unsigned char __far *dest,           /* pointer to destination pointer */
          unsigned long destlen,               /* amount of output space */
          const unsigned char __far* source,   /* pointer to source data pointer */
          unsigned long sourcelen)             /* amount of input available */
 {
     struct state s;             /* input/output state */
-    int last, type;             /* block information */
-    int err;                    /* return value */
 
     /* initialize output state */
     s.out = MK_FP(FP_SEG(dest), 0x0000);
     s.outlen = destlen + FP_OFF(dest);           /* ignored if dest is NULL */
     s.outcnt = FP_OFF(dest);
+    s.ring = NULL;
+
+    /* initialize input state */
+    s.in = MK_FP(FP_SEG(source), 0x0000);
+    s.inlen = sourcelen + FP_OFF(source);
+    s.incnt = FP_OFF(source);
+    s.bitbuf = 0;
+    s.bitcnt = 0;
+#if CACHE_TABLES != 1
+    s.initialized = false;
+#endif
+
+    return blocks(&s);
+}
+
+int puff_ring(puff_ring_t *ring,
+              const unsigned char __far* source,
+              unsigned long sourcelen)
+{
+    struct state s;             /* input/output state */
+    int err;                    /* return value */
+
+    /* initialize output state */
+    s.out = MK_FP(0x1000, 0x0000);
+    s.outlen = 0xFFFFFFFF;
+    s.outcnt = 0;
+    s.ring = ring;
+    s.pollcnt = RING_POLL_SYMBOLS;
 
     /* initialize input state */
     s.in = MK_FP(FP_SEG(source), 0x0000);
@@ -970,25 +1132,27 @@ int puff(unsigned char __far *dest,           /* pointer to destination pointer
     s.incnt = FP_OFF(source);
     s.bitbuf = 0;
     s.bitcnt = 0;
+#if CACHE_TABLES != 1
+    s.initialized = false;
+#endif
 
-    /* return if bits() or decode() tries to read past available input */
-    if (setjmp(s.env) != 0)             /* if came back here via longjmp() */
-        err = 2;                        /* then skip do-loop, return error */
-    else {
-        /* process blocks until last block or error */
-        do {
-            last = bits(&s, 1);         /* one if last block */
-            type = bits(&s, 2);         /* block type 0..3 */
-            err = type == 0 ?
-                    stored(&s) :
-                    (type == 1 ?
-                        fixed(&s) :
-                        (type == 2 ?
-                            dynamic(&s) :
-                            -1));       /* type == 3, invalid */
-            if (err != 0)
-                break;                  /* return with error */
-        } while (!last);
+    ring->pos = 0;
+    switch (setjmp(s.env)) {
+    case 0:
+        ring_enter_bank(&s);
+        err = blocks(&s);
+        break;
+    default:
+        err = PUFF_RING_ABORTED;
+        break;
+    }
+
+    /* publish the exact end of the output */
+    if (s.outcnt >= 0x10000) {
+        ring->bank++;
+        ring->pos = 0;
+    } else {
+        ring->pos = s.outcnt;
     }
 
     return err;
@@ -21,10 +21,42 @@
   Mark Adler    madler@alumni.caltech.edu
  */
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <wonderful.h>
 
+/*
+ * Streaming output to a ring of PSRAM banks, written through the SRAM window.
+ * Banks are numbered logically; logical bank n is stored in physical bank
+ * bank_first + (n & bank_mask). The ring must be at least four banks long and
+ * no longer than 64 banks.
+ *
+ * poll() is called regularly while inflating, after pos has been updated, and
+ * repeatedly while the ring is full. It should update read_bank to the
+ * logical bank the consumer is reading from, and return false to abort.
+ */
+typedef struct puff_ring {
+    uint16_t bank_first;        /* first physical bank of the ring */
+    uint8_t bank_mask;          /* ring length in banks, minus one */
+    uint8_t bank;               /* logical bank being written */
+    uint16_t pos;               /* bytes of bank known to be written */
+    uint8_t read_bank;          /* logical bank being read by the consumer */
+    bool (*poll)(struct puff_ring *ring);
+} puff_ring_t;
+
+#define PUFF_RING_ABORTED 3
+
 int puff(unsigned char __far* dest,           /* pointer to destination pointer */
          unsigned long destlen,               /* amount of output space */
          const unsigned char __far* source,   /* pointer to source data pointer */
          unsigned long sourcelen);            /* amount of input available */
+
+/*
+ * Inflate into a ring of PSRAM banks, starting at the beginning of ring->bank.
+ * On success, ring->bank and ring->pos point to the end of the output.
+ * Returns PUFF_RING_ABORTED if poll() requested it.
+ */
+int puff_ring(puff_ring_t *ring,
+              const unsigned char __far* source,
+              unsigned long sourcelen);
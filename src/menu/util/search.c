@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "search.h"
+
+#define SEARCH_FOLD(s, c) (((s)->fold && (c) >= 'A' && (c) <= 'Z') ? ((c) | 0x20) : (c))
+
+bool search_init(search_t *s) {
+    if (!s->len) return false;
+
+    for (uint8_t i = 0; i < s->len; i++)
+        s->pattern[i] = SEARCH_FOLD(s, s->pattern[i]);
+
+    memset(s->skip, s->len, sizeof(s->skip));
+    for (uint8_t i = 0; i < s->len - 1; i++) {
+        s->skip[s->pattern[i]] = s->len - 1 - i;
+        if (s->fold && s->pattern[i] >= 'a' && s->pattern[i] <= 'z')
+            s->skip[s->pattern[i] & ~0x20] = s->len - 1 - i;
+    }
+    return true;
+}
+
+bool search_block(const search_t *s, const uint8_t __far *data, uint16_t first, uint16_t last, uint16_t *result) {
+    uint8_t m1 = s->len - 1;
+    if (last < m1 || first > (last - m1)) return false;
+    uint16_t end = last - m1;
+    uint16_t p = first;
+
+    while (true) {
+        uint8_t c = data[p + m1];
+        if (SEARCH_FOLD(s, c) == s->pattern[m1]) {
+            uint8_t i = m1;
+            while (i > 0) {
+                uint8_t d = data[p + i - 1];
+                if (SEARCH_FOLD(s, d) != s->pattern[i - 1]) break;
+                i--;
+            }
+            if (i == 0) {
+                *result = p;
+                return true;
+            }
+        }
+        uint8_t skip = s->skip[c];
+        if ((end - p) < skip) return false;
+        p += skip;
+    }
+}
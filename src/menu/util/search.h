@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UTIL_SEARCH_H_
+#define UTIL_SEARCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wonderful.h>
+
+// Maximum length of a search pattern, in bytes.
+#define SEARCH_PATTERN_MAX 63
+
+typedef struct {
+    uint8_t len;
+    // Fold ASCII letters to lower case.
+    bool fold;
+    uint8_t pattern[SEARCH_PATTERN_MAX];
+    // Horspool shift for each byte value.
+    uint8_t skip[256];
+} search_t;
+
+/**
+ * @brief Prepare a search for the pattern in s->pattern.
+ *
+ * The caller fills in len, fold and pattern; the pattern is folded in place.
+ *
+ * @return false if the pattern is empty.
+ */
+bool search_init(search_t *s);
+
+/**
+ * @brief Horspool search for the pattern starting at offsets first..last - len + 1 of data.
+ *
+ * @param last Offset of the last byte of data to search.
+ * @param result Offset of the first match, if any.
+ * @return true if a match was found.
+ */
+bool search_block(const search_t *s, const uint8_t __far *data, uint16_t first, uint16_t last, uint16_t *result);
+
+#endif /* UTIL_SEARCH_H_ */
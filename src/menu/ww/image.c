@@ -103,19 +103,19 @@ static void ww_bios_os_selector_draw(struct ui_selector_config *config, uint16_t
         file_selector_entry_t __far *fno = ui_file_selector_open_fno((uint16_t) offset);
 
         // Special handling: FreyaBIOS/FreyaOS file
-        if (isdigit(fno->fno.fname[5]) && isdigit(fno->fno.fname[6]) && isdigit(fno->fno.fname[7])) {
-            char __far* filename_ext = strrchr(fno->fno.fname, '.');
+        if (isdigit(fno->fname[5]) && isdigit(fno->fname[6]) && isdigit(fno->fname[7])) {
+            char __far* filename_ext = strrchr(fno->fname, '.');
 
             if (filename_ext != NULL) *filename_ext = 0;
-            if (!memcmp(s_freya, fno->fno.fname, 5)) {
-                sprintf(name, s_freyaos_tpl, fno->fno.fname[5], fno->fno.fname[6], fno->fno.fname + 7);
-            } else if (!memcmp(s_bios, fno->fno.fname, 4) && fno->fno.fname[4] == 'f') {
-                sprintf(name, s_freyabios_tpl, fno->fno.fname[5], fno->fno.fname[6], fno->fno.fname + 7);
+            if (!memcmp(s_freya, fno->fname, 5)) {
+                sprintf(name, s_freyaos_tpl, fno->fname[5], fno->fname[6], fno->fname + 7);
+            } else if (!memcmp(s_bios, fno->fname, 4) && fno->fname[4] == 'f') {
+                sprintf(name, s_freyabios_tpl, fno->fname[5], fno->fname[6], fno->fname + 7);
             }
             if (filename_ext != NULL) *filename_ext = '.';
         }
 
-        if (!name[0]) strcpy(name, fno->fno.fname);
+        if (!name[0]) strcpy(name, fno->fname);
     } else {
         // TODO: Implement version information
         sprintf(name, s_athenabios_tpl, lang_keys[offset == WW_UI_SELECT_BIOSATHC ? LK_ATHENABIOS_SUFFIX_COMPATIBLE : LK_ATHENABIOS_SUFFIX_NATIVE]);
@@ -173,11 +173,11 @@ reload_menu:
 
             if (offset >= 0) {
                 file_selector_entry_t __far *fno = ui_file_selector_open_fno(offset);
-                if (strlen(fno->fno.fname) >= buflen - strlen(path) - 1)
+                if (strlen(fno->fname) >= buflen - strlen(path) - 1)
                     return false;
                 strcpy(buffer, s_path_fbin);
                 strcat(buffer, s_path_sep);
-                strcat(buffer, fno->fno.fname);
+                strcat(buffer, fno->fname);
             } else if (offset == WW_UI_SELECT_BIOSATHC) {
                 strcpy(buffer, s_path_athenabios_compatible);
             } else if (offset == WW_UI_SELECT_BIOSATHN) {
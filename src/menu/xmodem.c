@@ -20,6 +20,7 @@
 #include <ws.h>
 #include <nile.h>
 #include <nilefs.h>
+#include "bootstub.h"
 #include "errors.h"
 #include "main.h"
 #include "cart/mcu.h"
@@ -29,11 +30,17 @@
 #include "xmodem.h"
 
 #define SOH 1
+#define STX 2
 #define EOT 4
 #define ACK 6
 #define NAK 21
 #define CAN 24
+#define CRC 'C'
 #define TIMEOUT_TICKS (75 * 10)
+// Number of CRC-16 mode requests sent before falling back to checksums.
+#define CRC_REQUEST_RETRIES 3
+// Blocks are received and verified in chunks of this size.
+#define CHUNK_SIZE 128
 
 static bool mcu_native_cdc_read_block_sync(void __wf_cram* buffer, uint16_t buflen, uint16_t timeout_ticks) {
     volatile uint16_t target_ticks = vbl_ticks + timeout_ticks;
@@ -88,13 +95,16 @@ static bool mcu_native_cdc_write_block_sync(const void __wf_cram* buffer, uint16
         { result = ERR_DATA_TRANSFER_TIMEOUT; goto finish; }
 
 extern uint8_t xmodem_checksum(uint8_t *data);
+extern uint16_t xmodem_crc16(uint16_t crc, const uint8_t *data, uint16_t len);
 
 int xmodem_send(xmodem_send_callback_t cb, void *userdata) {
-    uint8_t data[132];
+    uint8_t data[133];
     uint8_t xmodem_idx = 0;
     int result = 0;
     bool new_data_requested = true;
+    bool crc_mode = false;
     uint8_t data_available = 0;
+    uint8_t block_len = 132;
 
     mcu_native_start();
     mcu_native_enter_speed(settings.mcu_spi_speed);
@@ -108,6 +118,19 @@ int xmodem_send(xmodem_send_callback_t cb, void *userdata) {
         if (bytes_read < 1)
             continue;
 
+        // The receiver requests CRC-16 mode by sending 'C' in place of
+        // the initial NAK. It repeats the request until it has received
+        // the first block, so until then it is a NAK of that block.
+        if (data[0] == CRC && xmodem_idx <= 1) {
+            if (!crc_mode && data_available == 2) {
+                // Block 1 was built with a checksum; build it again.
+                data_available = 1;
+            }
+            crc_mode = true;
+            block_len = 133;
+            data[0] = NAK;
+        }
+
         if (data[0] == NAK || data[0] == ACK) {
             if (data[0] == ACK) {
                 if (!new_data_requested && !data_available) break;
@@ -127,15 +150,21 @@ int xmodem_send(xmodem_send_callback_t cb, void *userdata) {
                 data[1] = xmodem_idx;
                 data[2] = xmodem_idx ^ 0xFF;
                 nile_mcu_native_cdc_write_async_start(data, 131);
-                data[131] = xmodem_checksum(data + 3);
+                if (crc_mode) {
+                    uint16_t crc = xmodem_crc16(0, data + 3, 128);
+                    data[131] = crc >> 8;
+                    data[132] = crc;
+                } else {
+                    data[131] = xmodem_checksum(data + 3);
+                }
                 if (nile_mcu_native_cdc_write_async_finish() <= 0) {
                     SEND_DATA(131);
                 }
-                SEND_DATA_OFS(131, 1);
+                SEND_DATA_OFS(131, block_len - 131);
                 data_available = 2;
             } else {
                 data[0] = SOH;
-                SEND_DATA(132);
+                SEND_DATA(block_len);
             }
         } else if (data[0] == CAN) {
             result = ERR_DATA_TRANSFER_CANCEL; goto finish;
@@ -149,79 +178,161 @@ finish:
     return result;
 }
 
-int xmodem_recv_to_psram(uint16_t bank, uint32_t *size) {
-    uint8_t data[132];
+static void xmodem_store_chunk(const uint8_t *chunk, uint16_t bank, uint16_t offset) {
+    outportw(WS_CART_EXTBANK_RAM_PORT, bank);
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
+
+    memcpy(MK_FP(0x1000, offset), chunk, CHUNK_SIZE);
+}
+
+// Write the staged data between from and to, which wraps around within a single bank.
+static int16_t xmodem_write_to_file(FIL *fp, uint16_t bank, uint32_t from, uint32_t to) {
+    int16_t result = FR_OK;
+    unsigned int bw;
+    uint16_t rom0_bank = ws_bank_rom0_save(bank);
+
+    while (from < to) {
+        uint16_t offset = from;
+        uint16_t len = to - from;
+        if (offset && len > (uint16_t) -offset)
+            len = -offset;
+        result = f_write(fp, MK_FP(WS_ROM0_SEGMENT, offset), len, &bw);
+        if (result != FR_OK)
+            break;
+        if (bw != len) {
+            result = FR_DENIED;
+            break;
+        }
+        from += len;
+    }
+
+    ws_bank_rom0_restore(rom0_bank);
+    return result;
+}
+
+// If fp is not NULL, data is staged in the given bank, which is used as a ring
+// buffer, and written to the file one block behind the transfer.
+// If length is not zero, the data is truncated to it instead of guessing the
+// size from the ROM footer.
+static int xmodem_recv(uint16_t bank, FIL *fp, uint32_t length, uint32_t *size) {
+    // header, one chunk of block data, CRC-16 or checksum
+    uint8_t data[3 + CHUNK_SIZE + 2];
+    uint8_t *chunk = data + 3;
     uint8_t eot_step = 0;
     uint8_t xmodem_idx = 0x01;
+    uint8_t crc_requests = CRC_REQUEST_RETRIES;
+    bool crc_mode = true;
 
-    uint16_t offset = 0;
+    uint32_t received = 0;
+    uint32_t written = 0;
+    uint16_t bank_count = asset_heap_get_free_first_banks();
     int result = 0;
     bool received_soh = false;
+    bool received_any = false;
+
+    bootstub_resident_invalidate(bank, fp ? bank + 1 : bank_count);
 
     mcu_native_start();
     nile_mcu_native_cdc_clear_sync();
     mcu_native_enter_speed(settings.mcu_spi_speed);
 
     uint16_t timeout_ticks = 0;
-    data[0] = NAK; SEND_DATA(1);
+    data[0] = CRC; SEND_DATA(1);
     *size = 0;
 
     while (true) {
-        int bytes_read = mcu_native_cdc_read_sync(data,132, timeout_ticks ? 75 * 4 : 75);
+        int bytes_read = mcu_native_cdc_read_sync(data, sizeof(data), timeout_ticks ? 75 * 4 : 75);
         if (bytes_read < 1) {
             timeout_ticks++;
             if (timeout_ticks > 10) {
                 result = ERR_DATA_TRANSFER_TIMEOUT; goto finish;
             }
             if (!received_soh) {
-                data[0] = NAK; SEND_DATA(1);
+                // senders which don't support CRC-16 mode wait for a NAK instead
+                if (!received_any && crc_mode && !(--crc_requests))
+                    crc_mode = false;
+                data[0] = (crc_mode && !received_any) ? CRC : NAK; SEND_DATA(1);
             }
             continue;
         }
 
         for (int i = 0; i < bytes_read; i++) {
-            if (data[i] == SOH) {
+            if (data[i] == SOH || data[i] == STX) {
                 timeout_ticks = 0;
                 received_soh = true;
+                received_any = true;
 
-                // SOH: receive block
+                // SOH/STX: receive block
                 if (i > 0) {
                     // slow path in case SOH was not the first byte; this should never happen
                     memmove(data, data + i, bytes_read - i);
                     bytes_read -= i;
                 }
 
-                if (bytes_read < 132) {
-                    if (!mcu_native_cdc_read_block_sync(data + bytes_read, 132 - bytes_read, TIMEOUT_TICKS)) {
-                        result = ERR_DATA_TRANSFER_TIMEOUT; goto finish;
+                // Verify the block chunk by chunk as it arrives, storing all but
+                // the last chunk in PSRAM past the end of the accepted data.
+                uint16_t remaining = data[0] == STX ? 1024 : 128;
+                uint8_t trailer_len = crc_mode ? 2 : 1;
+                uint32_t block_end = received;
+                uint16_t crc = 0;
+                uint8_t checksum = 0;
+
+                while (true) {
+                    int needed = 3 + CHUNK_SIZE + (remaining == CHUNK_SIZE ? trailer_len : 0);
+                    if (bytes_read < needed) {
+                        if (!mcu_native_cdc_read_block_sync(data + bytes_read, needed - bytes_read, TIMEOUT_TICKS)) {
+                            result = ERR_DATA_TRANSFER_TIMEOUT; goto finish;
+                        }
+                        bytes_read = needed;
                     }
+
+                    if (crc_mode)
+                        crc = xmodem_crc16(crc, chunk, CHUNK_SIZE);
+                    else
+                        checksum += xmodem_checksum(chunk);
+
+                    if (!fp && bank + (block_end >> 16) >= bank_count) {
+                        data[0] = CAN; SEND_DATA(1);
+                        result = ERR_FILE_TOO_LARGE; goto finish;
+                    }
+
+                    remaining -= CHUNK_SIZE;
+                    if (!remaining) break;
+
+                    xmodem_store_chunk(chunk, fp ? bank : bank + (block_end >> 16), block_end);
+                    block_end += CHUNK_SIZE;
+                    bytes_read -= CHUNK_SIZE;
+                    memmove(chunk, chunk + CHUNK_SIZE, bytes_read - 3);
                 }
 
                 if ((data[1] ^ data[2]) == 0xFF) {
                     if (data[1] == xmodem_idx) {
-                        if (data[131] == xmodem_checksum(data + 3)) {
+                        if (crc_mode
+                            ? (crc == ((chunk[CHUNK_SIZE] << 8) | chunk[CHUNK_SIZE + 1]))
+                            : (checksum == chunk[CHUNK_SIZE])) {
                             // respond with ACK
                             data[0] = ACK; nile_mcu_native_cdc_write_async_start(data, 1);
 
-                            // read next 128 bytes into PSRAM
-                            outportw(WS_CART_EXTBANK_RAM_PORT, bank);
-                            outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
-
-                            memcpy(MK_FP(0x1000, offset), data + 3, 128);
+                            // store the final chunk in PSRAM
+                            xmodem_store_chunk(chunk, fp ? bank : bank + (block_end >> 16), block_end);
 
                             if (nile_mcu_native_cdc_write_async_finish() != 1) {
                                 SEND_DATA(1);
                             }
 
-                            offset += 128;
-                            if (!offset) {
-                                bank++;
-                                if (bank >= asset_heap_get_free_first_banks()) {
+                            // while the sender transmits the next block, write the
+                            // previous one; the last block is kept for trimming
+                            if (fp) {
+                                uint32_t write_end = (length && received > length) ? length : received;
+                                result = xmodem_write_to_file(fp, bank, written, write_end);
+                                if (result != FR_OK) {
                                     data[0] = CAN; SEND_DATA(1);
-                                    result = ERR_FILE_TOO_LARGE; goto finish;
+                                    goto finish;
                                 }
+                                written = write_end;
                             }
 
+                            received = block_end + CHUNK_SIZE;
                             xmodem_idx++;
                             break;
                         }
@@ -252,24 +363,41 @@ int xmodem_recv_to_psram(uint16_t bank, uint32_t *size) {
 
 finish:
     if (!result) {
-        *size = ((uint32_t)bank << 16) + offset;
+        *size = received;
+
+        if (length) {
+            if (*size > length)
+                *size = length;
+        } else if (received) {
+            uint16_t last_bank = bank;
+            uint16_t offset = received;
+            uint16_t rom0_bank, rom1_bank;
+            if (fp) {
+                rom0_bank = ws_bank_rom0_save(last_bank);
+            } else {
+                last_bank += received >> 16;
+                rom0_bank = ws_bank_rom0_save(last_bank - 1);
+            }
+            rom1_bank = ws_bank_rom1_save(last_bank);
 
-        uint16_t rom0_bank = ws_bank_rom0_save(bank - 1);
-        uint16_t rom1_bank = ws_bank_rom1_save(bank);
+            // access the final 144 bytes of the ROM
+            const uint8_t __far *last_bytes = MK_FP(WS_ROM1_SEGMENT + (offset >> 4) - (256 >> 4), 112);
 
-        // access the final 144 bytes of the ROM
-        const uint8_t __far *last_bytes = MK_FP(WS_ROM1_SEGMENT + (offset >> 4) - (256 >> 4), 112);
+            // the ROM might not have been aligned to 128 bytes
+            // try to adjust for this by locating byte 0xEA and maintenance
+            int hdr_offset = 128;
+            while (hdr_offset >= 0 && (last_bytes[hdr_offset] != 0xEA || (last_bytes[hdr_offset + 5] & 0xF))) hdr_offset--;
+            if (hdr_offset >= 0) {
+                *size -= (128 - hdr_offset);
+            }
 
-        // the ROM might not have been aligned to 128 bytes
-        // try to adjust for this by locating byte 0xEA and maintenance
-        int hdr_offset = 128;
-        while (hdr_offset >= 0 && (last_bytes[hdr_offset] != 0xEA || (last_bytes[hdr_offset + 5] & 0xF))) hdr_offset--;
-        if (hdr_offset >= 0) {
-            *size -= (128 - hdr_offset);
+            ws_bank_rom0_restore(rom0_bank);
+            ws_bank_rom1_restore(rom1_bank);
         }
 
-        ws_bank_rom0_restore(rom0_bank);
-        ws_bank_rom1_restore(rom1_bank);
+        if (fp) {
+            result = xmodem_write_to_file(fp, bank, written, *size);
+        }
     }
 
     outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
@@ -279,3 +407,11 @@ finish:
 
     return result;
 }
+
+int xmodem_recv_to_psram(uint16_t bank, uint32_t *size) {
+    return xmodem_recv(bank, NULL, 0, size);
+}
+
+int xmodem_recv_to_file(FIL *fp, uint16_t bank, uint32_t length, uint32_t *size) {
+    return xmodem_recv(bank, fp, length, size);
+}
@@ -21,10 +21,12 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <wonderful.h>
+#include <nilefs.h>
 
 typedef bool (*xmodem_send_callback_t)(uint8_t *data, void *userdata);
 
 int xmodem_send(xmodem_send_callback_t cb, void *userdata);
 int xmodem_recv_to_psram(uint16_t bank, uint32_t *size);
+int xmodem_recv_to_file(FIL *fp, uint16_t bank, uint32_t length, uint32_t *size);
 
 #endif /* XMODEM_H_ */
@@ -45,3 +45,36 @@ xmodem_checksum:
 
     pop si
     IA16_RET
+
+    // uint16_t xmodem_crc16(uint16_t crc, const uint8_t *data, uint16_t len)
+    // CRC-16/XMODEM (polynomial 0x1021), computed bytewise without a table.
+    .global xmodem_crc16
+xmodem_crc16:
+    push si
+
+    mov si, dx
+    jcxz 2f
+
+1:
+    // crc = swap(crc) ^ byte
+    xchg al, ah
+    xor al, [si]
+    inc si
+    // crc ^= (crc & 0xFF) >> 4
+    mov bl, al
+    shr bl, 4
+    xor al, bl
+    // crc ^= crc << 12
+    mov bl, al
+    shl bl, 4
+    xor ah, bl
+    // crc ^= (crc & 0xFF) << 5
+    xor bh, bh
+    mov bl, al
+    shl bx, 5
+    xor ax, bx
+    loop 1b
+
+2:
+    pop si
+    IA16_RET
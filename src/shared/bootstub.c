@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <wonderful.h>
+#include <ws.h>
+#include <nile.h>
+#include "bootstub.h"
+
+uint32_t bootstub_resident_checksum(uint16_t bank, uint16_t bank_end) {
+    uint16_t sum1 = 0;
+    uint16_t sum2 = 0;
+
+    for (; bank < bank_end; bank++) {
+        outportw(WS_CART_EXTBANK_RAM_PORT, bank);
+        const volatile uint16_t __far *ptr = MK_FP(0x1000, 0x0000);
+        for (uint8_t i = 0; i < (0x10000 >> 9); i++, ptr += 512 / sizeof(uint16_t)) {
+            sum1 += *ptr;
+            sum2 += sum1;
+        }
+    }
+
+    return ((uint32_t) sum2 << 16) | sum1;
+}
+
+void bootstub_resident_invalidate(uint16_t bank, uint16_t bank_end) {
+    volatile bootstub_resident_image_t __far *image = BOOTSTUB_RESIDENT_IMAGE;
+    uint8_t prev_cart_flash = inportb(WS_CART_BANK_FLASH_PORT);
+    uint16_t prev_sram_bank = inportw(WS_CART_EXTBANK_RAM_PORT);
+
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    outportw(WS_CART_EXTBANK_RAM_PORT, NILE_SEG_RAM_IPC);
+    if (image->magic == BOOTSTUB_RESIDENT_MAGIC && bank < image->bank_end && bank_end > image->bank_first)
+        image->magic = 0;
+
+    outportw(WS_CART_EXTBANK_RAM_PORT, prev_sram_bank);
+    outportb(WS_CART_BANK_FLASH_PORT, prev_cart_flash);
+}
@@ -20,11 +20,16 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <wonderful.h>
 
 #define BOOTSTUB_PROG_PATCH_FREYA_SOFT_RESET 0x01
 #define BOOTSTUB_PROG_PATCH_IPC_RESERVED     0x02
 #define BOOTSTUB_CLUSTER_AT_PSRAM 0xFFFFFFF8
 
+#define BOOTSTUB_RESIDENT_NONE   0x00
+#define BOOTSTUB_RESIDENT_RECORD 0x01 ///< Record a fingerprint of the image after loading it
+#define BOOTSTUB_RESIDENT_VALID  0x02 ///< The image is already present in PSRAM
+
 #define ROM_TYPE_UNKNOWN 0x00
 #define ROM_TYPE_WS      0x01
 #define ROM_TYPE_PCV2    0x02
@@ -33,8 +38,15 @@
 typedef struct {
     uint32_t cluster; ///< Initial FAT cluster
     uint32_t size; ///< File size, in bytes
+    uint32_t mtime; ///< Modification date and time, in FAT format
 } bootstub_file_entry_t;
 
+// Contiguous run of sectors belonging to the program file.
+typedef struct {
+    uint32_t sector; ///< First sector
+    uint32_t length; ///< Length, in sectors
+} bootstub_extent_t;
+
 typedef struct {
     // FAT information
     uint8_t fs_type;
@@ -45,6 +57,7 @@ typedef struct {
 
     // Program information
     bootstub_file_entry_t prog;
+    uint16_t prog_extent_count; ///< Number of entries in bootstub_extents; 0 if the FAT is to be used
     void __far* start_pointer; ///< Start pointer
     uint16_t rom_banks; ///< Requested ROM banks
     uint8_t prog_sram_mask;
@@ -54,8 +67,60 @@ typedef struct {
     uint8_t prog_flags2; ///< IO_SYSTEM_CTRL2 flags
     uint8_t prog_patches;
     uint8_t prog_rom_type;
+    uint8_t prog_resident;
 } bootstub_data_t;
 
 #define bootstub_data ((volatile bootstub_data_t*) 0x0060)
 
+// The extent map is stored in tile memory not used by the bootstub.
+// It is written by the menu after the UI has been hidden.
+#define BOOTSTUB_EXTENTS_MAX 256
+#define bootstub_extents ((volatile bootstub_extent_t*) 0x2000)
+
+#define BOOTSTUB_RESIDENT_MAGIC 0x4D495352 /* RSIM */
+
+// Fingerprint of the program image last loaded into PSRAM.
+typedef struct {
+    uint32_t magic; ///< Written last by the bootstub, once the image is loaded
+    uint32_t cluster;
+    uint32_t size;
+    uint32_t mtime;
+    uint16_t rom_banks;
+    uint16_t bank_first; ///< First PSRAM bank occupied by the image
+    uint16_t bank_end; ///< Last PSRAM bank occupied by the image, exclusive
+    uint32_t checksum;
+} bootstub_resident_image_t;
+
+// Stored in the IPC area, right before the save ID.
+#define BOOTSTUB_RESIDENT_IMAGE_OFFSET (512 - sizeof(uint32_t) - sizeof(bootstub_resident_image_t))
+#define BOOTSTUB_RESIDENT_IMAGE ((volatile bootstub_resident_image_t __far*) MK_FP(0x1000, BOOTSTUB_RESIDENT_IMAGE_OFFSET))
+
+// Path of the file opened by a plugin, stored in the IPC area up to the
+// resident image fingerprint; the limit includes the terminating zero.
+#define BOOTSTUB_IPC_PATH_OFFSET 0x00E0
+#define BOOTSTUB_IPC_PATH_MAX (BOOTSTUB_RESIDENT_IMAGE_OFFSET - BOOTSTUB_IPC_PATH_OFFSET)
+
+/**
+ * @brief Calculate a spot check of PSRAM contents, sampling one word per 512 bytes.
+ *
+ * This only catches bulk overwrites of the image; a write can change any
+ * number of unsampled words without changing the result. Code which writes
+ * to PSRAM must call bootstub_resident_invalidate() first.
+ * The caller has to map PSRAM into the SRAM window; the SRAM bank is not restored.
+ *
+ * @param bank First bank to checksum.
+ * @param bank_end Last bank to checksum, exclusive.
+ */
+uint32_t bootstub_resident_checksum(uint16_t bank, uint16_t bank_end);
+
+/**
+ * @brief Forget the resident image if it overlaps the given PSRAM banks.
+ *
+ * Must be called before writing to PSRAM. The cartridge bank registers are restored.
+ *
+ * @param bank First bank about to be written.
+ * @param bank_end Last bank about to be written, exclusive.
+ */
+void bootstub_resident_invalidate(uint16_t bank, uint16_t bank_end);
+
 #endif
@@ -26,8 +26,21 @@
 #define CONFIG_MEMLAYOUT_STACK_BUFFER_SIZE 64
 
 #define CONFIG_FILESELECT_PATH_MEMORY_DEPTH 12
+// Minimum number of entries for a directory listing to be cached on the storage card.
+#define CONFIG_FILESELECT_CACHE_MIN_FILES 128
 
 #define CONFIG_FONT_BITMAP_SHIFT 8
 #define CONFIG_FONT_CHAR_GAP 0
+// Capacity of a text layout run buffer; longer strings are drawn without one.
+#define CONFIG_FONT_LAYOUT_MAX_GLYPHS 128
+#define CONFIG_FONT_LAYOUT_MAX_LINES 12
+
+// Capacity of the text viewer's sparse line index.
+#define CONFIG_TXTVIEW_INDEX_SIZE 64
+
+// Size of the benchmark's scratch file; must be a multiple of 512 bytes.
+#define CONFIG_BENCH_FILE_SIZE 131072
+// Number of sectors accessed by each random read/write benchmark.
+#define CONFIG_BENCH_RANDOM_SECTORS 64
 
 #endif /* CONFIG_H_ */
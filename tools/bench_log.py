@@ -0,0 +1,136 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Parses /NILESWAN/BENCH.LOG, as written by the "bench" command and the
+# benchmark in the user interface. Each run starts with a "# swanshell
+# <version>" line, followed by one tab-separated line per test: name,
+# setting, operation count, bytes transferred and time in microseconds.
+#
+# The log is read from a local copy, or downloaded through the USB shell.
+# With --run, the "bench" command is run first, and the results it printed
+# are checked against the ones it logged. The last run is printed, compared
+# with the one before it.
+#
+# Usage: bench_log.py [--run] <serial port or log file>
+
+import argparse, os, sys
+from shell_client import download, read_response, send_command
+
+LOG_PATH = "/NILESWAN/BENCH.LOG"
+
+class Result:
+	def __init__(self, name, param, count, size, time_us):
+		self.name = name
+		self.param = param
+		self.count = count
+		self.size = size
+		self.time_us = time_us
+
+	def key(self):
+		return (self.name, self.param)
+
+	def value(self):
+		# KB/s for transfers, microseconds per operation otherwise.
+		if not self.time_us:
+			return None
+		if not self.size:
+			return self.time_us // self.count
+		return (self.size * 125 // 128) * 1000 // self.time_us
+
+	def unit(self):
+		return "KB/s" if self.size else "us"
+
+	def format(self):
+		# Matches bench_format_result().
+		value = self.value()
+		if value is None:
+			return "%s (%s): -" % (self.name, self.param)
+		return "%s (%s): %d %s" % (self.name, self.param, value, self.unit())
+
+def parse_log(text):
+	# Returns a list of (version, results) runs.
+	runs = []
+	for number, line in enumerate(text.splitlines(), 1):
+		if not line:
+			continue
+		if line.startswith("# swanshell "):
+			runs.append((line[12:], []))
+			continue
+		fields = line.split("\t")
+		if len(fields) != 5 or not runs:
+			raise ValueError("line %d: malformed entry: %r" % (number, line))
+		try:
+			result = Result(fields[0], fields[1], int(fields[2]), int(fields[3]), int(fields[4]))
+		except ValueError:
+			raise ValueError("line %d: malformed number: %r" % (number, line))
+		if result.time_us and not result.count:
+			raise ValueError("line %d: timed test with no operations" % number)
+		runs[-1][1].append(result)
+	return runs
+
+def print_run(version, results, previous):
+	print("swanshell %s" % version)
+	baseline = {r.key(): r.value() for r in previous} if previous else {}
+	for r in results:
+		line = r.format()
+		old = baseline.get(r.key())
+		if old and r.value() is not None:
+			line += " (%+.1f%%)" % ((r.value() - old) * 100.0 / old)
+		print("  " + line)
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Parse the swanshell benchmark log.")
+	parser.add_argument("--run", action="store_true", help="run the benchmark before downloading the log")
+	parser.add_argument("source", help="serial port, such as /dev/ttyACM0, or a local copy of BENCH.LOG")
+	args = parser.parse_args()
+
+	printed = None
+	if os.path.isfile(args.source):
+		if args.run:
+			sys.exit("--run requires a serial port")
+		with open(args.source, "rb") as fp:
+			data = fp.read()
+	else:
+		import serial
+
+		# The storage card tests take a few seconds each.
+		with serial.Serial(args.source, timeout=60) as port:
+			if args.run:
+				send_command(port, "bench")
+				# The CDC write test prints lines of spaces, ended only by a
+				# carriage return, in front of its result.
+				lines = read_response(port, lambda l: True)
+				printed = [l.split("\r")[-1] for l in lines if l.split("\r")[-1].strip()]
+			data = download(port, LOG_PATH)
+
+	# download() pads the file with zeroes.
+	try:
+		runs = parse_log(data.rstrip(b"\0").decode("utf-8"))
+	except ValueError as e:
+		sys.exit(str(e))
+	if not runs:
+		sys.exit("no benchmark runs in log")
+
+	version, results = runs[-1]
+	print_run(version, results, runs[-2][1] if len(runs) > 1 else None)
+
+	if printed is not None:
+		logged = [r.format() for r in results]
+		if printed != logged:
+			print("FAIL printed results differ from the log:")
+			for line in printed:
+				print("  " + line)
+			sys.exit(1)
+		print("printed results match the log")
@@ -0,0 +1,191 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Models glyph lookups in the menu's 8-pixel font over the translated menu
+# strings in lang/*.po.
+#
+# The font's codepoints are taken from the .bdf files fonts/builder.lua
+# combines for the "default8" font, and each 256-codepoint page is laid out
+# with the builder's rules: dense, ranged (format 1.1) or sorted. For every
+# character drawn, the probes of __bitmapfont_find_char() are counted with
+# both the 1.0 layout, which has no ranged pages, and the 1.1 layout.
+#
+# The glyph cache of src/menu/ui/bitmapfont.c (a printable ASCII table, and
+# a 64-entry cache indexed by the low bits of the codepoint) is modelled
+# over two passes which lay out every string of a language once, in file
+# order. Misses are the lookups which still search the font.
+#
+# Usage: font_lookup_check.py [language ...]
+
+import os, re, sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+BDF_FILES = (
+	"fonts/local/swanshell_7px.bdf",
+	"fonts/misaki/misaki_gothic_2nd.bdf",
+	"fonts/boutique/BoutiqueBitmap7x7_1.7.bdf",
+)
+
+# fonts/builder.lua
+GLYPH_TABLE_PER = 256
+GLYPH_ENTRY_SIZE = 5
+SMALL_GLYPH_ENTRY_SIZE = 4
+GLYPH_ENTRY_STATIC_LIMIT = 0xCC
+
+# src/menu/ui/bitmapfont.c
+GLYPH_CACHE_SIZE = 64
+GLYPH_ASCII_FIRST = 0x20
+GLYPH_ASCII_COUNT = 0x5F
+
+def filter_default(ch):
+	if ch < 0x20 or 0x80 <= ch < 0xA0:
+		return False
+	if 0x2800 <= ch < 0x2900:
+		return False
+	if 0xD800 <= ch < 0xF900:
+		return False
+	return True
+
+def load_codepoints():
+	codepoints = set()
+	for name in BDF_FILES:
+		with open(os.path.join(ROOT, name), encoding="latin-1") as f:
+			for line in f:
+				if line.startswith("ENCODING "):
+					ch = int(line.split()[1])
+					if ch >= 0 and filter_default(ch):
+						codepoints.add(ch)
+	return codepoints
+
+class Page:
+	def __init__(self, page, lows):
+		self.lows = sorted(lows)
+		count = len(self.lows)
+		if page == 0 or count >= GLYPH_ENTRY_STATIC_LIMIT:
+			self.kind = "dense"
+			self.size = 2 + GLYPH_TABLE_PER * SMALL_GLYPH_ENTRY_SIZE
+			return
+		self.kind = "sorted"
+		self.size = 2 + count * GLYPH_ENTRY_SIZE
+		self.old_size = self.size
+		span = self.lows[-1] - self.lows[0] + 1
+		if span < GLYPH_TABLE_PER and span <= count * 2:
+			self.kind = "ranged"
+			self.size = 4 + span * SMALL_GLYPH_ENTRY_SIZE
+
+	def probes(self, low, ranged):
+		if self.kind == "dense" or (self.kind == "ranged" and ranged):
+			return 1
+		base, nmemb, probes = 0, len(self.lows), 0
+		while nmemb:
+			corr = nmemb & 1
+			nmemb >>= 1
+			pivot = base + nmemb
+			probes += 1
+			if self.lows[pivot] < low:
+				base = pivot + 1
+				nmemb -= 1 - corr
+			elif self.lows[pivot] == low:
+				break
+		return probes
+
+def build_pages(codepoints):
+	lows = {}
+	for ch in codepoints:
+		lows.setdefault(ch >> 8, []).append(ch & 0xFF)
+	return {page: Page(page, l) for page, l in lows.items()}
+
+def load_strings(language):
+	strings = []
+	current = None
+	with open(os.path.join(ROOT, "lang", language + ".po"), encoding="utf-8") as f:
+		for line in f:
+			line = line.strip()
+			if line.startswith("msgstr "):
+				current = line[7:]
+			elif line.startswith('"') and current is not None:
+				current = current[:-1] + line[1:]
+			else:
+				if current not in (None, '""'):
+					strings.append(current)
+				current = None
+	if current not in (None, '""'):
+		strings.append(current)
+	unescape = lambda s: re.sub(r'\\(.)', lambda m: "\n" if m.group(1) == "n" else m.group(1), s[1:-1])
+	# skip the header entry
+	return [unescape(s) for s in strings if "Content-Type:" not in s]
+
+class GlyphCache:
+	def __init__(self):
+		self.ascii = set()
+		self.entries = [None] * GLYPH_CACHE_SIZE
+		self.ascii_hits = self.hits = self.misses = 0
+
+	def lookup(self, ch):
+		if ch < GLYPH_ASCII_FIRST + GLYPH_ASCII_COUNT:
+			if ch in self.ascii:
+				self.ascii_hits += 1
+				return
+			self.ascii.add(ch)
+		else:
+			idx = ch & (GLYPH_CACHE_SIZE - 1)
+			if self.entries[idx] == ch:
+				self.hits += 1
+				return
+			if ch <= 0xFFFF:
+				self.entries[idx] = ch
+		self.misses += 1
+
+def check(language, pages):
+	strings = load_strings(language)
+	chars = [ord(c) for s in strings for c in s if ord(c) >= 0x20]
+	probes_old = probes_new = 0
+	for ch in chars:
+		page = pages.get(ch >> 8)
+		if page is not None:
+			probes_old += page.probes(ch & 0xFF, False)
+			probes_new += page.probes(ch & 0xFF, True)
+	non_ascii = sum(1 for ch in chars if ch >= 0x80)
+	print(f"{language}: {len(strings)} strings, {len(chars)} characters, {non_ascii} outside ASCII")
+	print(f"  font search: {probes_old / len(chars):.2f} -> {probes_new / len(chars):.2f} probes per lookup")
+
+	cache = GlyphCache()
+	for n in range(2):
+		cache.ascii_hits = cache.hits = cache.misses = 0
+		for ch in chars:
+			cache.lookup(ch)
+		hit_rate = (cache.ascii_hits + cache.hits) * 100 / len(chars)
+		print(f"  glyph cache, pass {n + 1}: {cache.ascii_hits} ASCII table hits, {cache.hits} cache hits, "
+			f"{cache.misses} font searches ({hit_rate:.1f}% hit rate)")
+
+def main():
+	pages = build_pages(load_codepoints())
+	counts = {}
+	for page in pages.values():
+		counts[page.kind] = counts.get(page.kind, 0) + 1
+	old_size = sum(getattr(p, "old_size", p.size) for p in pages.values())
+	new_size = sum(p.size for p in pages.values())
+	print(f"default8: {sum(len(p.lows) for p in pages.values())} glyphs in {len(pages)} pages: "
+		+ ", ".join(f"{v} {k}" for k, v in sorted(counts.items())))
+	print(f"  entry tables: {old_size} bytes in format 1.0, {new_size} bytes in format 1.1")
+
+	languages = sys.argv[1:] or sorted(f[:-3] for f in os.listdir(os.path.join(ROOT, "lang"))
+		if f.endswith(".po") and not f.startswith("_"))
+	for language in languages:
+		check(language, pages)
+
+if __name__ == "__main__":
+	main()
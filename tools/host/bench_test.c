@@ -0,0 +1,265 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Storage card and MCU benchmark (util/bench.c) on a simulated cartridge.
+// Runs the benchmark twice, in color and in mono mode, against a fake TF
+// card, MCU and USB host with the costs below, the second time with MCU
+// version requests failing. The log it appends to is then parsed by
+// tools/bench_log.py, whose lines must match the results reported through
+// bench_format_result(). The figures come from this model, not a card.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include <nile.h>
+
+// long is 32 bits wide on the device; narrow the %l formats to match the
+// 32-bit arguments.
+static const char *host_format(char *buf, const char *format) {
+    char *dst = buf;
+    for (const char *src = format; *src; src++) {
+        if (src[0] == 'l' && src > format && src[-1] == '%')
+            continue;
+        *(dst++) = *src;
+    }
+    *dst = 0;
+    return buf;
+}
+
+static int host_sprintf(char *str, const char *format, ...) {
+    char buf[64];
+    va_list args;
+    va_start(args, format);
+    int len = vsprintf(str, host_format(buf, format), args);
+    va_end(args);
+    return len;
+}
+
+#define sprintf host_sprintf
+#include "util/bench.c"
+#undef sprintf
+
+#define CPU_HZ 3072000
+#define HBLANK_HZ 12000
+#define VBLANK_NS 13250000
+
+// TF card: fixed latency per transfer or sync, plus the SPI clock.
+#define TF_READ_NS 300000
+#define TF_WRITE_NS 1000000
+#define TF_SYNC_NS 2000000
+#define TF_FAST_HZ 24000000
+#define TF_CART_HZ 384000
+// MCU: fixed latency per command, plus the SPI clock of the chosen speed.
+#define MCU_COMMAND_NS 100000
+#define USB_BYTE_NS 1000
+
+#define LOG_PATH "build/BENCH.LOG"
+
+const char s_path_bench_tmp[] = "/NILESWAN/BENCH.TMP";
+const char s_path_bench_log[] = "/NILESWAN/BENCH.LOG";
+volatile uint16_t vbl_ticks;
+settings_t settings;
+bool mcu_native_mode = true;
+
+static uint64_t now_ns;
+static uint64_t hblank_start_ns;
+static uint16_t hblank_reload;
+static uint32_t spi_hz = TF_FAST_HZ;
+static uint32_t mcu_hz;
+static bool mcu_fail;
+
+static void advance(uint64_t ns) {
+    now_ns += ns;
+    vbl_ticks = now_ns / VBLANK_NS;
+}
+
+static void advance_spi(uint32_t bytes, uint32_t hz) {
+    advance((uint64_t) bytes * 8 * 1000000000 / hz);
+}
+
+void ws_timer_hblank_start_once(uint16_t reload) {
+    hblank_start_ns = now_ns;
+    hblank_reload = reload;
+}
+
+uint16_t ws_timer_hblank_get_counter(void) {
+    uint64_t lines = (now_ns - hblank_start_ns) * HBLANK_HZ / 1000000000;
+    return lines >= hblank_reload ? 0 : hblank_reload - lines;
+}
+
+void ws_timer_hblank_disable(void) {
+}
+
+bool nile_spi_set_control(uint16_t value) {
+    spi_hz = (value & NILE_SPI_CLOCK_FAST) ? TF_FAST_HZ : TF_CART_HZ;
+    return true;
+}
+
+static const uint32_t mcu_speeds_hz[] = { 384000, 6000000, 24000000 };
+
+void mcu_native_enter_speed(uint16_t speed) {
+    mcu_hz = mcu_speeds_hz[speed];
+}
+
+void mcu_native_exit_speed(void) {
+}
+
+static void mcu_command(uint16_t bytes) {
+    advance(MCU_COMMAND_NS);
+    advance_spi(bytes, mcu_hz);
+}
+
+int16_t nile_mcu_native_mcu_get_version_sync(nile_mcu_native_version_t *version, uint16_t buflen) {
+    mcu_command(buflen);
+    if (mcu_fail)
+        return -1;
+    memset(version, 0, buflen);
+    return buflen;
+}
+
+int16_t nile_mcu_native_eeprom_read_sync(void *buffer, uint16_t address, uint16_t words) {
+    mcu_command(words * 2);
+    memset(buffer, 0xFF, words * 2);
+    return words * 2;
+}
+
+int16_t nile_mcu_native_cdc_write_sync(const void *buffer, uint16_t buflen) {
+    mcu_command(buflen);
+    advance((uint64_t) buflen * USB_BYTE_NS);
+    return buflen;
+}
+
+// Files: the scratch file is only timed, the log is kept in memory.
+static char log_text[4096];
+static size_t log_len;
+static int open_files;
+
+FRESULT f_open_far(FIL* fp, const char __far* path, uint8_t mode) {
+    memset(fp, 0, sizeof(FIL));
+    fp->obj.sclust = !strcmp(path, s_path_bench_log);
+    if (fp->obj.sclust && !(mode & FA_OPEN_APPEND))
+        return FR_INVALID_PARAMETER;
+    open_files++;
+    return FR_OK;
+}
+
+FRESULT f_close(FIL *fp) {
+    open_files--;
+    return FR_OK;
+}
+
+FRESULT f_unlink_far(const char __far* path) {
+    return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+FRESULT f_sync(FIL *fp) {
+    advance(TF_SYNC_NS);
+    return FR_OK;
+}
+
+int16_t f_read_rom_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) {
+    advance(TF_READ_NS);
+    advance_spi(btr, spi_hz);
+    fp->fptr += btr;
+    return FR_OK;
+}
+
+int16_t f_write_rom_banked(FIL* fp, uint16_t bank, uint32_t btw, fbanked_progress_callback_t cb, void *userdata, bool verify) {
+    advance(TF_WRITE_NS);
+    advance_spi(btw, spi_hz);
+    fp->fptr += btw;
+    return FR_OK;
+}
+
+int f_printf(FIL *fp, const TCHAR *str, ...) {
+    char buf[64];
+    va_list args;
+    va_start(args, str);
+    int len = vsnprintf(log_text + log_len, sizeof(log_text) - log_len, host_format(buf, str), args);
+    va_end(args);
+    if (!fp->obj.sclust || len < 0 || log_len + len >= sizeof(log_text))
+        return -1;
+    log_len += len;
+    return len;
+}
+
+// Lines reported through the callback, as the user interface prints them.
+static char printed[BENCH_MAX_RESULTS][48];
+static int printed_count;
+
+static void bench_callback(const bench_result_t *result, void *userdata) {
+    bench_format_result(printed[printed_count++], result);
+}
+
+static bool run(bool color, bool fail) {
+    host_set_color_active(color);
+    mcu_fail = fail;
+    settings.mcu_spi_speed = color ? SETTING_MCU_SPI_SPEED_6MHZ : SETTING_MCU_SPI_SPEED_24MHZ;
+    printed_count = 0;
+
+    int16_t result = bench_run(BENCH_FLAG_CDC, bench_callback, NULL);
+    if (result != FR_OK || open_files) {
+        printf("FAIL: %s: result %d, %d files open\n", color ? "color" : "mono", result, open_files);
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    host_init();
+
+    if (!run(true, false) || !run(false, true))
+        return 1;
+
+    FILE *f = fopen(LOG_PATH, "w");
+    fwrite(log_text, 1, log_len, f);
+    fclose(f);
+
+    // The last run, as printed by the parser; drop the change from the
+    // previous run, shown after the results of the storage card tests.
+    FILE *p = popen("python3 ../bench_log.py " LOG_PATH, "r");
+    char line[128];
+    int lines = 0;
+    bool ok = p != NULL;
+    while (p != NULL && fgets(line, sizeof(line), p)) {
+        fputs(line, stdout);
+        line[strcspn(line, "\n")] = 0;
+        char *change = strstr(line, " (+");
+        if (change == NULL)
+            change = strstr(line, " (-");
+        if (change != NULL)
+            *change = 0;
+        if (lines && (lines > printed_count || strcmp(line + 2, printed[lines - 1]))) {
+            printf("FAIL: expected \"%s\"\n", lines > printed_count ? "" : printed[lines - 1]);
+            ok = false;
+        }
+        lines++;
+    }
+    if (p == NULL || pclose(p) || lines != printed_count + 1) {
+        printf("FAIL: bench_log.py printed %d lines for %d results\n", lines - 1, printed_count);
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Directory listing cache signature (ui_file_selector_cache.c) on a FAT16
+// image with a fragmented 1500-file directory. Checks which changes alter
+// the signature, and compares the card reads needed to validate the cache
+// with those of a full directory scan.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "host_fs.h"
+#include "ui/ui_file_selector_cache.c"
+
+settings_t settings;
+uint8_t sector_buffer[CONFIG_MEMLAYOUT_SECTOR_BUFFER_SIZE];
+const char s_path_dircache[] = "/dircache.bin";
+
+FRESULT f_open_far(FIL* fp, const char __far* path, uint8_t mode) { return FR_NO_FILE; }
+FRESULT f_close(FIL *fp) { return FR_OK; }
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) { return FR_DISK_ERR; }
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) { return FR_DISK_ERR; }
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) { return FR_DISK_ERR; }
+int16_t f_read_sram_banked(FIL* fp, uint16_t bank, uint32_t btr, fbanked_progress_callback_t cb, void *userdata) { return FR_DISK_ERR; }
+int16_t f_write_sram_banked(FIL* fp, uint16_t bank, uint32_t btw, fbanked_progress_callback_t cb, void *userdata, bool verify) { return FR_DISK_ERR; }
+
+// C version of util/hash/crc32_asm.s.
+uint32_t crc32_update(uint32_t crc, uint16_t len, const void __far *ptr) {
+    const uint8_t *data = ptr;
+    while (len--) {
+        crc ^= *(data++);
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320UL : 0);
+    }
+    return crc;
+}
+
+#define FILE_COUNT 1500
+#define CLUSTER_SIZE 4
+
+static uint32_t dir_cluster;
+static int failures;
+
+// Directory entry of the given file: one long name entry, then the short name entry.
+static uint8_t *file_entry(uint16_t idx, bool lfn) {
+    uint32_t ofs = (uint32_t) idx * DIR_ENTRY_SIZE * 2 + (lfn ? 0 : DIR_ENTRY_SIZE);
+    uint32_t cluster = dir_cluster;
+    for (; ofs >= CLUSTER_SIZE * 512; ofs -= CLUSTER_SIZE * 512)
+        cluster = host_fs_next(cluster);
+    return host_fs_cluster(cluster) + ofs;
+}
+
+static void build_directory(void) {
+    uint32_t size = (FILE_COUNT + 1) * DIR_ENTRY_SIZE * 2;
+    dir_cluster = host_fs_alloc((size + CLUSTER_SIZE * 512 - 1) / (CLUSTER_SIZE * 512), 1, 3);
+
+    for (uint16_t i = 0; i < FILE_COUNT; i++) {
+        uint8_t *lfn = file_entry(i, true);
+        uint8_t *sfn = file_entry(i, false);
+        char name[12];
+
+        snprintf(name, sizeof(name), "GAME%04uWS ", i);
+        lfn[0] = 0x41;
+        for (int j = 0; j < 5; j++)
+            lfn[1 + j * 2] = "Game "[j];
+        lfn[DIR_ENTRY_ATTR] = DIR_ENTRY_ATTR_LFN;
+        for (int j = 0; j < 6; j++)
+            lfn[14 + j * 2] = name[4 + (j & 3)];
+        memcpy(sfn, name, 11);
+        sfn[DIR_ENTRY_ATTR] = AM_ARC;
+        sfn[DIR_ENTRY_WRITE_TIME] = i;
+        sfn[DIR_ENTRY_WRITE_TIME + 2] = 0x21;
+        sfn[DIR_ENTRY_WRITE_TIME + 3] = 0x5C;
+        sfn[DIR_ENTRY_FILE_SIZE + 2] = i & 0x7F;
+    }
+}
+
+static uint32_t signature(void) {
+    uint32_t value;
+    if (!ui_file_selector_cache_signature(dir_cluster, &value)) {
+        printf("FAIL: signature could not be computed\n");
+        failures++;
+    }
+    return value;
+}
+
+static void expect(const char *name, uint32_t before, bool changed) {
+    uint32_t after = signature();
+    bool ok = (before != after) == changed;
+    printf("%s: %s (%s)\n", ok ? "ok" : "FAIL", name, changed ? "changes" : "keeps");
+    if (!ok)
+        failures++;
+}
+
+int main(int argc, char **argv) {
+    host_init();
+    host_fs_format(32768, CLUSTER_SIZE);
+    build_directory();
+    settings.file_sort = SETTING_FILE_SORT_NAME_ASC;
+
+    uint32_t base = signature();
+
+    host_set_color_active(false);
+    expect("sector window reads", base, false);
+    host_set_color_active(true);
+
+    // Same name, attributes and size: only the modification time differs.
+    uint8_t *sfn = file_entry(700, false);
+    sfn[DIR_ENTRY_WRITE_TIME] ^= 0x20;
+    expect("mtime, name sort", base, false);
+    settings.file_sort = SETTING_FILE_SORT_DATE_DESC;
+    uint32_t date_base = signature();
+    sfn[DIR_ENTRY_WRITE_TIME] ^= 0x20;
+    expect("mtime, date sort", date_base, true);
+    settings.file_sort = SETTING_FILE_SORT_NAME_ASC;
+
+    // +1, -2, +1 on consecutive name words leaves a Fletcher sum unchanged.
+    sfn[0] += 1; sfn[2] -= 2; sfn[4] += 1;
+    expect("balanced name edit", base, true);
+    sfn[0] -= 1; sfn[2] += 2; sfn[4] -= 1;
+    expect("name restored", base, false);
+
+    sfn[0] = DIR_ENTRY_DELETED;
+    expect("deleted file", base, true);
+    sfn[0] = 'G';
+
+    fs.wflag = 1;
+    printf("%s: pending FatFs writes refuse validation\n", ui_file_selector_cache_signature(dir_cluster, &base) ? "FAIL" : "ok");
+    failures += ui_file_selector_cache_signature(dir_cluster, &base);
+    fs.wflag = 0;
+
+    // Validating the cache reads the directory table once, and the FAT
+    // sectors of its chain; the directory scan calls f_readdir() once per
+    // file, plus once at the end.
+    for (int color = 1; color >= 0; color--) {
+        host_set_color_active(color);
+        fs.winsect = (LBA_t) -1;
+        host_disk_reads = host_disk_sectors = 0;
+        uint64_t start = host_time_us();
+        signature();
+        printf("%s: %lu disk_read() calls, %lu sectors, %llu us on the host\n",
+            color ? "color" : "mono", host_disk_reads, host_disk_sectors,
+            (unsigned long long) (host_time_us() - start));
+    }
+    printf("f_readdir() calls: %u for a scan, 0 for a cache hit\n", FILE_COUNT + 1);
+
+    return failures ? 1 : 0;
+}
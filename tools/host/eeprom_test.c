@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// EEPROM save backup and restore (launch_eeprom.c) against a fake MCU and
+// an in-memory save file. Checks that a restore followed by a verified
+// backup round-trips, and counts MCU commands and SPI device switches.
+// The restore counts are compared with the previous restore loop, which
+// wrote one word per cartridge EEPROM bus transaction.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include <nile.h>
+#include "launch/launch_eeprom.c"
+
+uint8_t sector_buffer[CONFIG_MEMLAYOUT_SECTOR_BUFFER_SIZE];
+bool mcu_native_mode = true;
+
+#define EEPROM_MAX_WORDS 1024
+
+static uint8_t mcu_eeprom[EEPROM_MAX_WORDS * 2];
+static uint8_t file_data[EEPROM_MAX_WORDS * 2];
+static uint16_t spi_device;
+
+static struct {
+    unsigned long mcu_commands;
+    unsigned long device_switches;
+    unsigned long file_calls;
+} stats;
+
+bool nile_spi_set_control(uint16_t value) {
+    if ((value & NILE_SPI_DEV_MASK) != spi_device)
+        stats.device_switches++;
+    spi_device = value & NILE_SPI_DEV_MASK;
+    return true;
+}
+
+static bool mcu_command_ok(uint16_t address, uint16_t words) {
+    stats.mcu_commands++;
+    return spi_device == NILE_SPI_DEV_MCU && words <= MAX_WRITE_EEPROM_WORDS
+        && address + words <= EEPROM_MAX_WORDS;
+}
+
+int16_t nile_mcu_native_eeprom_read_sync(void *buffer, uint16_t address, uint16_t words) {
+    if (!mcu_command_ok(address, words))
+        return -1;
+    memcpy(buffer, mcu_eeprom + address * 2, words * 2);
+    return words * 2;
+}
+
+int16_t nile_mcu_native_eeprom_write_sync(const void *buffer, uint16_t address, uint16_t words) {
+    if (!mcu_command_ok(address, words))
+        return -1;
+    memcpy(mcu_eeprom + address * 2, buffer, words * 2);
+    return words * 2;
+}
+
+static FRESULT file_access(FIL *fp, UINT n, UINT *count) {
+    stats.file_calls++;
+    if (spi_device != NILE_SPI_DEV_TF || fp->fptr + n > sizeof(file_data))
+        return FR_DISK_ERR;
+    if (count)
+        *count = n;
+    return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    FRESULT result = file_access(fp, btr, br);
+    if (result == FR_OK) {
+        memcpy(buff, file_data + fp->fptr, btr);
+        fp->fptr += btr;
+    }
+    return result;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    FRESULT result = file_access(fp, btw, bw);
+    if (result == FR_OK) {
+        memcpy(file_data + fp->fptr, buff, btw);
+        fp->fptr += btw;
+    }
+    return result;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+static int run(uint16_t words, bool color) {
+    static const char *const mode_names[] = {"mono", "color"};
+    uint8_t scratch[MAX_WRITE_EEPROM_WORDS * 4];
+    uint8_t expected[EEPROM_MAX_WORDS * 2];
+    FIL fp = {0};
+    int16_t result;
+
+    host_set_color_active(color);
+    for (uint16_t i = 0; i < words * 2; i++)
+        expected[i] = file_data[i] = (uint8_t) (i * 7 + words);
+    memset(mcu_eeprom, 0xFF, sizeof(mcu_eeprom));
+
+    // Previous restore loop: one SPI switch pair per stack buffer block,
+    // one cartridge EEPROM bus write per word.
+    uint16_t old_block_words = color ? sizeof(sector_buffer) / 2 : CONFIG_MEMLAYOUT_STACK_BUFFER_SIZE / 2;
+    unsigned long old_blocks = (words + old_block_words - 1) / old_block_words;
+
+    memset(&stats, 0, sizeof(stats));
+    spi_device = NILE_SPI_DEV_MCU;
+    result = launch_read_eeprom(&fp, words);
+    if (result != FR_OK || memcmp(mcu_eeprom, expected, words * 2)) {
+        printf("FAIL: %u-word restore (%s), result %d\n", words, mode_names[color], result);
+        return 1;
+    }
+    printf("%4u words, %-5s: restore %3lu bus writes, %2lu SPI switches -> %2lu MCU commands, %2lu SPI switches\n",
+        words, mode_names[color], (unsigned long) words, old_blocks * 2,
+        stats.mcu_commands, stats.device_switches);
+
+    memset(file_data, 0, sizeof(file_data));
+    memset(&stats, 0, sizeof(stats));
+    fp.fptr = 0;
+    result = launch_write_eeprom(&fp, scratch, words, true);
+    if (result != FR_OK || memcmp(file_data, expected, words * 2)) {
+        printf("FAIL: %u-word backup (%s), result %d\n", words, mode_names[color], result);
+        return 1;
+    }
+    printf("%4u words, %-5s: verified backup %2lu MCU commands, %2lu SPI switches, %2lu file calls\n",
+        words, mode_names[color], stats.mcu_commands, stats.device_switches, stats.file_calls);
+
+    return 0;
+}
+
+int main(void) {
+    static const uint16_t sizes[] = {64, 512, 1024};
+    int failed = 0;
+
+    host_init();
+    for (int color = 0; color < 2; color++)
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++)
+            failed |= run(sizes[i], color);
+    return failed;
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Program file load through the bootstub's cluster_read(), with the FAT
+// walker and with the extent map built by fs_get_extents() in the menu.
+// A 4 MB file is loaded into PSRAM the way the bootstub does, from a
+// contiguous and from fragmented FAT16 volumes, counting disk_read() calls
+// and FAT sector reads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ws.h>
+#include "host.h"
+#include "host_fs.h"
+#include "fs.h"
+#include "bootstub.h"
+
+// The bootstub data and extent map live at fixed addresses in IRAM.
+#undef bootstub_data
+#undef bootstub_extents
+#define bootstub_data ((volatile bootstub_data_t*) (host_memory + 0x0060))
+#define bootstub_extents ((volatile bootstub_extent_t*) (host_memory + 0x2000))
+
+#include "../../src/bootstub/cluster_read.c"
+
+#define FILE_SIZE (4UL * 1024 * 1024)
+#define CLUSTER_SIZE 4
+#define START_BANK 0x80
+
+static int failures;
+
+static void fill_file(uint32_t cluster) {
+    uint32_t ofs = 0;
+    while (ofs < FILE_SIZE) {
+        uint8_t *data = host_fs_cluster(cluster);
+        for (uint16_t i = 0; i < CLUSTER_SIZE * 512; i += 4, ofs += 4) {
+            data[i] = ofs; data[i + 1] = ofs >> 8; data[i + 2] = ofs >> 16; data[i + 3] = 0xA5;
+        }
+        cluster = host_fs_next(cluster);
+    }
+}
+
+static bool check_psram(void) {
+    const uint8_t *data = host_psram + ((uint32_t) START_BANK << 16);
+    for (uint32_t ofs = 0; ofs < FILE_SIZE; ofs += 4) {
+        if (data[ofs] != (uint8_t) ofs || data[ofs + 1] != (uint8_t) (ofs >> 8)
+            || data[ofs + 2] != (uint8_t) (ofs >> 16) || data[ofs + 3] != 0xA5)
+            return false;
+    }
+    return true;
+}
+
+// Load the file into PSRAM in 32 KB halves, as the bootstub's main() does.
+static bool load(void) {
+    memset(host_psram + ((uint32_t) START_BANK << 16), 0, FILE_SIZE);
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
+    cluster_open(bootstub_data->prog.cluster);
+    for (uint16_t bank = START_BANK; bank < START_BANK + (FILE_SIZE >> 16); bank++) {
+        outportw(WS_CART_EXTBANK_RAM_PORT, bank);
+        if (cluster_read(MK_FP(0x1000, 0x0000), 0x8000) != FR_OK)
+            return false;
+        if (cluster_read(MK_FP(0x1000, 0x8000), 0x8000) != FR_OK)
+            return false;
+    }
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    return check_psram();
+}
+
+static void run(const char *name, uint16_t run, uint16_t gap) {
+    host_fs_format(65535, CLUSTER_SIZE);
+    uint32_t cluster = host_fs_alloc(FILE_SIZE / (CLUSTER_SIZE * 512), run, gap);
+    fill_file(cluster);
+
+    bootstub_data->fs_type = fs.fs_type;
+    bootstub_data->cluster_table_base = fs.fatbase;
+    bootstub_data->data_base = fs.database;
+    bootstub_data->cluster_size = fs.csize;
+    bootstub_data->fat_entry_count = fs.n_fatent;
+    bootstub_data->prog.cluster = cluster;
+    bootstub_data->prog.size = FILE_SIZE;
+
+    if (gap)
+        printf("%s (%u-cluster runs, %u-cluster gaps):\n", name, run, gap);
+    else
+        printf("%s:\n", name);
+    for (int use_extents = 0; use_extents < 2; use_extents++) {
+        unsigned long map_fat_sectors = 0;
+        bootstub_data->prog_extent_count = 0;
+        if (use_extents) {
+            host_disk_fat_sectors = 0;
+            fs.winsect = (LBA_t) -1;
+            bootstub_data->prog_extent_count = fs_get_extents(cluster, FILE_SIZE, bootstub_extents, BOOTSTUB_EXTENTS_MAX);
+            map_fat_sectors = host_disk_fat_sectors;
+            if (!bootstub_data->prog_extent_count) {
+                printf("  extents: more than %u, the FAT walker is used\n", BOOTSTUB_EXTENTS_MAX);
+                continue;
+            }
+        }
+
+        drive_window_sector = -1;
+        host_disk_reads = host_disk_sectors = host_disk_fat_sectors = 0;
+        bool ok = load();
+        printf("  %s: %5lu disk_read() calls, %5lu FAT sector reads", use_extents ? "extents" : "FAT    ",
+            host_disk_reads, host_disk_fat_sectors);
+        if (use_extents)
+            printf(" (%u extents, %lu FAT sectors read by the menu)", bootstub_data->prog_extent_count, map_fat_sectors);
+        printf("%s\n", ok ? "" : " - FAIL: data differs");
+        failures += !ok;
+    }
+}
+
+int main(int argc, char **argv) {
+    host_init();
+    run("contiguous", 0xFFFF, 0);
+    run("fragmented", 8, 1);
+    run("fragmented", 8, 24);
+    run("fragmented", 3, 2);
+    run("fragmented", 1, 1);
+    return failures ? 1 : 0;
+}
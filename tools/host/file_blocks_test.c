@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Save write-back (f_write_banked_blocks() in util/file.c) on synthetic
+// SRAM and PSRAM images, with an in-memory save file. Each image differs
+// from the file in a given number of blocks; the test checks that the
+// file matches the image afterwards, and counts the bytes written to and
+// read from the card. These are compared with a full rewrite through
+// f_write_sram_banked() and f_write_rom_banked().
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "util/file.c"
+
+uint8_t sector_buffer[CONFIG_MEMLAYOUT_SECTOR_BUFFER_SIZE];
+
+#define FILE_MAX_SIZE (1024UL * 1024)
+
+static uint8_t file_data[FILE_MAX_SIZE];
+
+static struct {
+    unsigned long bytes_written;
+    unsigned long bytes_read;
+    unsigned long calls;
+} stats;
+
+void bootstub_resident_invalidate(uint16_t bank, uint16_t bank_end) {
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    if (fp->fptr + btr > fp->obj.objsize)
+        btr = fp->obj.objsize - fp->fptr;
+    memcpy(buff, file_data + fp->fptr, btr);
+    fp->fptr += btr;
+    stats.bytes_read += btr;
+    stats.calls++;
+    *br = btr;
+    return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    if (fp->fptr + btw > FILE_MAX_SIZE)
+        return FR_DENIED;
+    memcpy(file_data + fp->fptr, buff, btw);
+    fp->fptr += btw;
+    if (fp->fptr > fp->obj.objsize)
+        fp->obj.objsize = fp->fptr;
+    stats.bytes_written += btw;
+    stats.calls++;
+    *bw = btw;
+    return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    fp->fptr = ofs;
+    return FR_OK;
+}
+
+// util/file.c helpers which are not exercised here.
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode) { return FR_NO_FILE; }
+FRESULT f_stat(const TCHAR *path, FILINFO *fno) { return FR_NO_FILE; }
+FRESULT f_unlink(const TCHAR *path) { return FR_NO_FILE; }
+FRESULT f_opendir(DIR *dp, const TCHAR *path) { return FR_NO_PATH; }
+FRESULT f_closedir(DIR *dp) { return FR_OK; }
+FRESULT f_readdir(DIR *dp, FILINFO *fno) { return FR_NO_PATH; }
+
+static uint32_t rand_state;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 8) & 0xFFFFFF;
+}
+
+// Fill the save memory and the file with the same data, then change one
+// byte in "dirty" distinct blocks of the memory.
+static uint8_t *prepare(FIL *fp, bool rom, uint32_t size, uint16_t dirty) {
+    uint8_t *memory = rom ? host_psram : host_sram;
+    uint16_t blocks = size >> F_BLOCK_SHIFT;
+
+    rand_state = size + dirty;
+    for (uint32_t i = 0; i < size; i++)
+        memory[i] = next_rand();
+    memcpy(file_data, memory, size);
+    memset(fp, 0, sizeof(FIL));
+    fp->obj.objsize = size;
+
+    for (uint16_t i = 0; i < dirty; i++) {
+        uint16_t block = (i * (uint32_t) blocks) / dirty;
+        memory[((uint32_t) block << F_BLOCK_SHIFT) + next_rand() % F_BLOCK_SIZE] ^= 0x55;
+    }
+    return memory;
+}
+
+static int run(bool rom, bool color, uint32_t size, uint16_t dirty) {
+    FIL fp;
+    uint8_t *memory;
+    int16_t result;
+    unsigned long full_written, full_read;
+
+    host_set_color_active(color);
+
+    memory = prepare(&fp, rom, size, dirty);
+    memset(&stats, 0, sizeof(stats));
+    outportb(WS_CART_BANK_FLASH_PORT, rom ? WS_CART_BANK_FLASH_ENABLE : WS_CART_BANK_FLASH_DISABLE);
+    result = rom ? f_write_rom_banked(&fp, 0, size, NULL, NULL, true)
+        : f_write_sram_banked(&fp, 0, size, NULL, NULL, true);
+    if (result != FR_OK || memcmp(file_data, memory, size)) {
+        printf("FAIL: full rewrite, result %d\n", result);
+        return 1;
+    }
+    full_written = stats.bytes_written;
+    full_read = stats.bytes_read;
+
+    memory = prepare(&fp, rom, size, dirty);
+    memset(&stats, 0, sizeof(stats));
+    result = f_write_banked_blocks(&fp, 0, size, rom, NULL, NULL, true);
+    if (result != FR_OK || memcmp(file_data, memory, size)) {
+        printf("FAIL: block write-back, result %d\n", result);
+        return 1;
+    }
+
+    printf("%-5s %4lu KB, %-5s, %3u/%3lu dirty: written %7lu -> %7lu bytes, read %7lu -> %7lu bytes, %5lu file calls\n",
+        rom ? "PSRAM" : "SRAM", (unsigned long) (size >> 10), color ? "color" : "mono",
+        dirty, (unsigned long) (size >> F_BLOCK_SHIFT), full_written, stats.bytes_written,
+        full_read, stats.bytes_read, stats.calls);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+
+    host_init();
+    for (int color = 1; color >= 0; color--) {
+        failed |= run(false, color, 32768, 0);
+        failed |= run(false, color, 32768, 1);
+        failed |= run(false, color, 131072, 0);
+        failed |= run(false, color, 131072, 2);
+        failed |= run(false, color, 131072, 32);
+    }
+    failed |= run(true, true, 524288, 0);
+    failed |= run(true, true, 524288, 4);
+    failed |= run(true, true, 524288, 128);
+
+    // A file shorter than the image is extended.
+    FIL fp;
+    uint8_t *memory = prepare(&fp, false, 65536, 0);
+    fp.obj.objsize = 10000;
+    memset(file_data + 10000, 0, 65536 - 10000);
+    host_set_color_active(true);
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    if (f_write_banked_blocks(&fp, 0, 65536, false, NULL, NULL, true) != FR_OK
+        || fp.obj.objsize != 65536 || memcmp(file_data, memory, 65536)) {
+        printf("FAIL: short file was not extended\n");
+        failed = 1;
+    }
+
+    return failed;
+}
@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include <ws.h>
+#include "host.h"
+
+#define WINDOW_SIZE 0x10000
+#define MEMORY_SIZE 0x100000
+
+uint8_t *host_memory;
+uint8_t *host_sram;
+uint8_t *host_psram;
+unsigned long host_bank_switches;
+uint8_t host_io_ports[0x100];
+unsigned long host_io_writes[0x100];
+
+static int backing_fd;
+static uint16_t bank_ram, bank_rom0, bank_rom1;
+static uint8_t flash_control;
+static bool color_active = true;
+static uint16_t gdma_source_l, gdma_dest, gdma_length;
+static uint8_t gdma_source_h;
+
+static void map_window(uint16_t segment, uint64_t offset, int prot) {
+    if (mmap(host_memory + ((uint32_t) segment << 4), WINDOW_SIZE, prot,
+        MAP_SHARED | MAP_FIXED, backing_fd, offset) == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+}
+
+static void map_windows(void) {
+    // ROM banks address PSRAM; with flash control enabled, so do SRAM banks.
+    if (flash_control & WS_CART_BANK_FLASH_ENABLE)
+        map_window(WS_SRAM_SEGMENT, HOST_SRAM_SIZE + ((uint64_t) (bank_ram & 0xFF) << 16), PROT_READ | PROT_WRITE);
+    else
+        map_window(WS_SRAM_SEGMENT, (uint64_t) (bank_ram & 7) << 16, PROT_READ | PROT_WRITE);
+    map_window(WS_ROM0_SEGMENT, HOST_SRAM_SIZE + ((uint64_t) (bank_rom0 & 0xFF) << 16), PROT_READ);
+    map_window(WS_ROM1_SEGMENT, HOST_SRAM_SIZE + ((uint64_t) (bank_rom1 & 0xFF) << 16), PROT_READ);
+}
+
+void host_init(void) {
+    backing_fd = memfd_create("cartridge", 0);
+    if (backing_fd < 0 || ftruncate(backing_fd, HOST_SRAM_SIZE + HOST_PSRAM_SIZE) < 0) {
+        perror("memfd_create");
+        exit(1);
+    }
+
+    // Align the address space to 1 MB, so that FP_OFF() is the low 16 bits.
+    uint8_t *area = mmap(NULL, MEMORY_SIZE * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    host_memory = (uint8_t*) (((uintptr_t) area + MEMORY_SIZE - 1) & ~(uintptr_t) (MEMORY_SIZE - 1));
+    if (mmap(host_memory, WINDOW_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+
+    host_sram = mmap(NULL, HOST_SRAM_SIZE + HOST_PSRAM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, backing_fd, 0);
+    if (host_sram == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    host_psram = host_sram + HOST_SRAM_SIZE;
+    map_windows();
+}
+
+uint64_t host_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint16_t inportw(uint16_t port) {
+    switch (port) {
+    case WS_CART_EXTBANK_RAM_PORT: return bank_ram;
+    case WS_CART_EXTBANK_ROM0_PORT: return bank_rom0;
+    case WS_CART_EXTBANK_ROM1_PORT: return bank_rom1;
+    }
+    return host_io_ports[port & 0xFF] | (host_io_ports[(port + 1) & 0xFF] << 8);
+}
+
+uint8_t inportb(uint16_t port) {
+    if (port == WS_CART_BANK_FLASH_PORT)
+        return flash_control;
+    return inportw(port);
+}
+
+static void set_bank(uint16_t *bank, uint16_t value) {
+    if (*bank != value) {
+        *bank = value;
+        host_bank_switches++;
+        map_windows();
+    }
+}
+
+// Word copy from a 20-bit source address to IRAM.
+static void gdma_start(uint8_t ctrl) {
+    uint32_t source = ((uint32_t) gdma_source_h << 16) | gdma_source_l;
+    int step = (ctrl & WS_GDMA_CTRL_DEC) ? -2 : 2;
+
+    for (; gdma_length >= 2; gdma_length -= 2) {
+        memcpy(host_memory + gdma_dest, host_memory + (source & 0xFFFFF), 2);
+        source += step;
+        gdma_dest += step;
+    }
+    gdma_source_l = source;
+    gdma_source_h = (source >> 16) & 0xF;
+}
+
+void outportw(uint16_t port, uint16_t value) {
+    switch (port) {
+    case WS_CART_EXTBANK_RAM_PORT: set_bank(&bank_ram, value); break;
+    case WS_CART_EXTBANK_ROM0_PORT: set_bank(&bank_rom0, value); break;
+    case WS_CART_EXTBANK_ROM1_PORT: set_bank(&bank_rom1, value); break;
+    case WS_GDMA_SOURCE_L_PORT: gdma_source_l = value; break;
+    case WS_GDMA_SOURCE_H_PORT: gdma_source_h = value & 0xF; break;
+    case WS_GDMA_DEST_PORT: gdma_dest = value; break;
+    case WS_GDMA_LENGTH_PORT: gdma_length = value; break;
+    case WS_GDMA_CTRL_PORT: if (value & WS_GDMA_CTRL_START) gdma_start(value); break;
+    default:
+        host_io_ports[port & 0xFF] = value;
+        host_io_ports[(port + 1) & 0xFF] = value >> 8;
+        host_io_writes[port & 0xFF]++;
+        break;
+    }
+}
+
+void outportb(uint16_t port, uint8_t value) {
+    if (port == WS_CART_BANK_FLASH_PORT) {
+        if (flash_control != value) {
+            flash_control = value;
+            map_windows();
+        }
+    } else if (port >= WS_CART_EXTBANK_RAM_PORT || (port >= WS_GDMA_SOURCE_L_PORT && port <= WS_GDMA_CTRL_PORT)) {
+        // Bank and general DMA registers
+        outportw(port, value);
+    } else {
+        host_io_ports[port & 0xFF] = value;
+        host_io_writes[port & 0xFF]++;
+    }
+}
+
+uint16_t ws_bank_ram_save(uint16_t bank) {
+    uint16_t old = bank_ram;
+    set_bank(&bank_ram, bank);
+    return old;
+}
+
+uint16_t ws_bank_rom0_save(uint16_t bank) {
+    uint16_t old = bank_rom0;
+    set_bank(&bank_rom0, bank);
+    return old;
+}
+
+uint16_t ws_bank_rom1_save(uint16_t bank) {
+    uint16_t old = bank_rom1;
+    set_bank(&bank_rom1, bank);
+    return old;
+}
+
+bool ws_system_is_color_active(void) {
+    return color_active;
+}
+
+uint8_t ws_system_get_model(void) {
+    return color_active ? WS_MODEL_COLOR : WS_MODEL_MONO;
+}
+
+void host_set_color_active(bool value) {
+    color_active = value;
+}
@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host build of menu modules, for the test and benchmark programs in this
+// directory. The headers in include/ stand in for the Wonderful toolchain
+// and libnile headers, with only what these modules need.
+//
+// The 20-bit address space is emulated as one 1 MB mapping, so that far
+// pointers keep their segment:offset arithmetic. The SRAM, ROM0 and ROM1
+// windows are remapped onto the cartridge SRAM or PSRAM on every bank port
+// write, so aliases between windows behave as on hardware.
+
+#ifndef HOST_H_
+#define HOST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_SRAM_SIZE (512UL * 1024)
+#define HOST_PSRAM_SIZE (16UL * 1024 * 1024)
+
+extern uint8_t *host_memory;
+extern uint8_t *host_sram;
+extern uint8_t *host_psram;
+
+// Number of writes to each bank port which changed the bank.
+extern unsigned long host_bank_switches;
+// Values last written to, and the number of writes to, other I/O ports.
+extern uint8_t host_io_ports[0x100];
+extern unsigned long host_io_writes[0x100];
+
+void host_init(void);
+// Whether the sector buffer in color mode IRAM is available.
+void host_set_color_active(bool value);
+// Monotonic time in microseconds.
+uint64_t host_time_us(void);
+
+#endif /* HOST_H_ */
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_fs.h"
+
+// fs.c reports mount errors through the UI; leave out the language and
+// dialog headers, which depend on generated assets.
+#define _LANG_H_
+#define UI_DIALOG_H__
+#define LK_ERROR_TITLE_FS_INIT 0
+static const char *const host_lang_keys[] = { "FS init" };
+static const char *const *lang_keys = host_lang_keys;
+
+static int16_t ui_dialog_error_check(int16_t error, const char *title, uint16_t flags) {
+    fprintf(stderr, "%s: error %d\n", title, error);
+    exit(1);
+}
+
+#include "fs.c"
+
+#define ROOT_ENTRIES 512
+
+unsigned long host_disk_reads;
+unsigned long host_disk_sectors;
+unsigned long host_disk_fat_sectors;
+
+static uint8_t *image;
+static uint32_t image_sectors;
+static uint32_t next_free_cluster;
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline void set_u16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    if (sector + count > image_sectors)
+        return RES_PARERR;
+    host_disk_reads++;
+    host_disk_sectors += count;
+    for (UINT i = 0; i < count; i++) {
+        if (sector + i >= fs.fatbase && sector + i < fs.dirbase)
+            host_disk_fat_sectors++;
+    }
+    memcpy(buff, image + ((size_t) sector << 9), (size_t) count << 9);
+    return RES_OK;
+}
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt) {
+    uint8_t boot[512];
+    if (disk_read(0, boot, 0, 1) != RES_OK)
+        return FR_DISK_ERR;
+
+    uint32_t total = get_u16(boot + 19);
+    uint32_t fat_size = get_u16(boot + 22);
+    uint32_t root_sectors;
+    memset(fs, 0, sizeof(FATFS));
+    fs->csize = boot[13];
+    fs->n_rootdir = get_u16(boot + 17);
+    fs->fatbase = get_u16(boot + 14);
+    fs->dirbase = fs->fatbase + boot[16] * fat_size;
+    root_sectors = fs->n_rootdir >> 4;
+    fs->database = fs->dirbase + root_sectors;
+    fs->n_fatent = (total - fs->database) / fs->csize + 2;
+    if (fs->n_fatent - 2 < 4085 || fs->n_fatent - 2 >= 65525)
+        return FR_NO_FILESYSTEM;
+    fs->fs_type = FS_FAT16;
+    fs->winsect = (LBA_t) -1;
+    return FR_OK;
+}
+
+void host_fs_format(uint32_t sectors, uint8_t csize) {
+    uint32_t fat_size = 1, clusters;
+
+    // FAT16 with one FAT and a fixed root directory.
+    while (1) {
+        clusters = (sectors - 1 - fat_size - (ROOT_ENTRIES >> 4)) / csize;
+        if ((clusters + 2) * 2 <= fat_size * 512)
+            break;
+        fat_size++;
+    }
+    if (sectors > 0xFFFF || clusters < 4085) {
+        fprintf(stderr, "host_fs_format: unsupported volume size\n");
+        exit(1);
+    }
+
+    free(image);
+    image = calloc(sectors, 512);
+    image_sectors = sectors;
+    set_u16(image + 11, 512);
+    image[13] = csize;
+    set_u16(image + 14, 1);
+    image[16] = 1;
+    set_u16(image + 17, ROOT_ENTRIES);
+    set_u16(image + 19, sectors);
+    set_u16(image + 22, fat_size);
+    image[510] = 0x55;
+    image[511] = 0xAA;
+    set_u16(image + 512, 0xFFF8);
+    set_u16(image + 514, 0xFFFF);
+    next_free_cluster = 2;
+
+    fs_init();
+}
+
+uint32_t host_fs_alloc(uint32_t clusters, uint16_t run, uint16_t gap) {
+    uint32_t first = next_free_cluster;
+    uint32_t cluster = first;
+    uint32_t span = clusters + (clusters + run - 1) / run * gap;
+    uint8_t *fat = image + ((size_t) fs.fatbase << 9);
+
+    if (first + span > fs.n_fatent) {
+        fprintf(stderr, "host_fs_alloc: volume full\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < clusters; i++) {
+        uint32_t next = cluster + ((i + 1) % run ? 1 : gap + 1);
+        set_u16(fat + cluster * 2, i + 1 < clusters ? next : 0xFFFF);
+        cluster = next;
+    }
+    next_free_cluster = first + span;
+    return first;
+}
+
+uint8_t *host_fs_cluster(uint32_t cluster) {
+    if (cluster == 0)
+        return image + ((size_t) fs.dirbase << 9);
+    return image + ((size_t) fs_cluster_to_sector(cluster) << 9);
+}
+
+uint16_t host_fs_next(uint32_t cluster) {
+    return get_u16(image + ((size_t) fs.fatbase << 9) + cluster * 2);
+}
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// FAT16 volume in host memory, mounted as the menu's FatFs volume through
+// src/menu/fs.c. Only disk_read() and the fields of FATFS used by fs.c are
+// provided; the images are built directly with the functions below.
+
+#ifndef HOST_FS_H_
+#define HOST_FS_H_
+
+#include <stdint.h>
+#include <nilefs.h>
+
+// Number of disk_read() calls, sectors read by them, and FAT sectors among those.
+extern unsigned long host_disk_reads;
+extern unsigned long host_disk_sectors;
+extern unsigned long host_disk_fat_sectors;
+
+/**
+ * @brief Create an empty FAT16 volume and mount it as fs.
+ *
+ * @param sectors Volume size, in 512-byte sectors.
+ * @param csize Sectors per cluster.
+ */
+void host_fs_format(uint32_t sectors, uint8_t csize);
+
+/**
+ * @brief Allocate a cluster chain.
+ *
+ * @param clusters Length of the chain.
+ * @param run Number of contiguous clusters in each fragment.
+ * @param gap Number of free clusters to leave after each fragment.
+ * @return uint32_t First cluster of the chain.
+ */
+uint32_t host_fs_alloc(uint32_t clusters, uint16_t run, uint16_t gap);
+
+/**
+ * @brief Get the data of a cluster, or of the root directory for cluster 0.
+ */
+uint8_t *host_fs_cluster(uint32_t cluster);
+
+/**
+ * @brief Get the FAT entry of a cluster.
+ */
+uint16_t host_fs_next(uint32_t cluster);
+
+#endif /* HOST_FS_H_ */
@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host stand-in for the libnile header; see host.h. The calls are
+// implemented by the programs which use them, usually as fakes which
+// count transactions.
+
+#ifndef NILE_H_
+#define NILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wonderful.h>
+
+#define NILE_SPI_CLOCK_CART 0x0000
+#define NILE_SPI_CLOCK_FAST 0x0800
+#define NILE_SPI_DEV_NONE 0x0000
+#define NILE_SPI_DEV_TF 0x0200
+#define NILE_SPI_DEV_MCU 0x0400
+#define NILE_SPI_DEV_MASK 0x0600
+
+bool nile_spi_set_control(uint16_t value);
+
+typedef struct {
+    uint16_t major, minor;
+    uint32_t flags;
+} nile_mcu_native_version_t;
+
+int16_t nile_mcu_native_mcu_get_version_sync(nile_mcu_native_version_t *version, uint16_t buflen);
+
+int16_t nile_mcu_native_eeprom_read_sync(void *buffer, uint16_t address, uint16_t words);
+int16_t nile_mcu_native_eeprom_write_sync(const void *buffer, uint16_t address, uint16_t words);
+
+bool nile_mcu_native_cdc_clear_sync(void);
+int16_t nile_mcu_native_cdc_read_sync(void *buffer, uint16_t buflen);
+int16_t nile_mcu_native_cdc_write_sync(const void *buffer, uint16_t buflen);
+bool nile_mcu_native_cdc_write_async_start(const void *buffer, uint16_t buflen);
+int16_t nile_mcu_native_cdc_write_async_finish(void);
+
+#endif /* NILE_H_ */
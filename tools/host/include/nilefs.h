@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host stand-in for the libnile FatFs header; see host.h.
+// Only the fields and calls used by the host-built modules are declared.
+
+#ifndef NILEFS_H_
+#define NILEFS_H_
+
+#include <wonderful.h>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef uint32_t LBA_t;
+typedef uint32_t FSIZE_t;
+typedef char TCHAR;
+
+#define FF_LFN_BUF 255
+#define FF_SFN_BUF 12
+
+typedef struct {
+    BYTE fs_type;
+    BYTE pdrv;
+    BYTE wflag;
+    WORD n_rootdir;
+    WORD csize;
+    DWORD n_fatent;
+    LBA_t fatbase;
+    LBA_t dirbase;
+    LBA_t database;
+    LBA_t winsect;
+    BYTE win[512];
+} FATFS;
+
+typedef struct {
+    FATFS *fs;
+    DWORD sclust;
+    FSIZE_t objsize;
+} FFOBJID;
+
+typedef struct {
+    FFOBJID obj;
+    FSIZE_t fptr;
+    DWORD *cltbl;
+} FIL;
+
+typedef struct {
+    FFOBJID obj;
+} DIR;
+
+typedef struct {
+    FSIZE_t fsize;
+    WORD fdate;
+    WORD ftime;
+    BYTE fattrib;
+    TCHAR altname[FF_SFN_BUF + 1];
+    TCHAR fname[FF_LFN_BUF + 1];
+} FILINFO;
+
+typedef enum {
+    FR_OK = 0, FR_DISK_ERR, FR_INT_ERR, FR_NOT_READY, FR_NO_FILE, FR_NO_PATH,
+    FR_INVALID_NAME, FR_DENIED, FR_EXIST, FR_INVALID_OBJECT, FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE, FR_NOT_ENABLED, FR_NO_FILESYSTEM, FR_MKFS_ABORTED,
+    FR_TIMEOUT, FR_LOCKED, FR_NOT_ENOUGH_CORE, FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER
+} FRESULT;
+
+typedef enum {
+    RES_OK = 0, RES_ERROR, RES_WRPRT, RES_NOTRDY, RES_PARERR
+} DRESULT;
+
+#define FS_FAT12 1
+#define FS_FAT16 2
+#define FS_FAT32 3
+
+#define AM_RDO 0x01
+#define AM_HID 0x02
+#define AM_SYS 0x04
+#define AM_DIR 0x10
+#define AM_ARC 0x20
+
+#define FA_READ 0x01
+#define FA_WRITE 0x02
+#define FA_OPEN_EXISTING 0x00
+#define FA_CREATE_NEW 0x04
+#define FA_CREATE_ALWAYS 0x08
+#define FA_OPEN_ALWAYS 0x10
+#define FA_OPEN_APPEND 0x30
+
+#define f_size(fp) ((fp)->obj.objsize)
+#define f_tell(fp) ((fp)->fptr)
+#define f_rewind(fp) f_lseek((fp), 0)
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt);
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_sync(FIL *fp);
+int f_printf(FIL *fp, const TCHAR *str, ...);
+FRESULT f_stat(const TCHAR *path, FILINFO *fno);
+FRESULT f_unlink(const TCHAR *path);
+FRESULT f_opendir(DIR *dp, const TCHAR *path);
+FRESULT f_closedir(DIR *dp);
+FRESULT f_readdir(DIR *dp, FILINFO *fno);
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count);
+
+#endif /* NILEFS_H_ */
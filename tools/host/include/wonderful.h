@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host stand-in for the Wonderful toolchain header; see host.h.
+
+#ifndef WONDERFUL_H_
+#define WONDERFUL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define __far
+#define __wf_iram
+#define __wf_cram
+#define __wf_rom
+#define ws_iram
+
+extern uint8_t *host_memory;
+
+#define MK_FP(seg, ofs) ((void*) (host_memory + ((uint32_t) (uint16_t) (seg) << 4) + (uint16_t) (ofs)))
+// Pointers outside of the emulated address space, such as host stack or
+// heap data, are treated as near pointers into segment 0.
+#define FP_SEG(ptr) ((uint16_t) ((uintptr_t) ((const uint8_t*) (ptr) - host_memory) < 0x100000 \
+    ? (((uintptr_t) ((const uint8_t*) (ptr) - host_memory)) >> 4) & 0xF000 : 0))
+#define FP_OFF(ptr) ((uint16_t) (uintptr_t) (ptr))
+
+#define _fmemcpy memcpy
+#define _fmemmove memmove
+#define _nmemmove memmove
+#define _fmemcmp memcmp
+#define _fmemset memset
+#define _fstrlen strlen
+#define _fstrcpy strcpy
+#define _fstrcmp strcmp
+
+#define ia16_disable_irq() do {} while (0)
+#define ia16_enable_irq() do {} while (0)
+
+#endif /* WONDERFUL_H_ */
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host stand-in for the libws header; see host.h.
+
+#ifndef WS_H_
+#define WS_H_
+
+#include <wonderful.h>
+
+#define WS_SRAM_SEGMENT 0x1000
+#define WS_ROM0_SEGMENT 0x2000
+#define WS_ROM1_SEGMENT 0x3000
+
+#define WS_CART_BANK_FLASH_PORT 0xCE
+#define WS_CART_BANK_FLASH_DISABLE 0x00
+#define WS_CART_BANK_FLASH_ENABLE 0x01
+#define WS_CART_EXTBANK_RAM_PORT 0xD0
+#define WS_CART_EXTBANK_ROM0_PORT 0xD2
+#define WS_CART_EXTBANK_ROM1_PORT 0xD4
+
+#define WS_DISPLAY_LINE_IRQ_PORT 0x03
+#define WS_DISPLAY_WIDTH_PIXELS 224
+#define WS_DISPLAY_HEIGHT_PIXELS 144
+
+#define WS_GDMA_SOURCE_L_PORT 0x40
+#define WS_GDMA_SOURCE_H_PORT 0x42
+#define WS_GDMA_DEST_PORT 0x44
+#define WS_GDMA_LENGTH_PORT 0x46
+#define WS_GDMA_CTRL_PORT 0x48
+#define WS_GDMA_CTRL_INC 0x00
+#define WS_GDMA_CTRL_DEC 0x40
+#define WS_GDMA_CTRL_START 0x80
+
+#define WS_SDMA_SOURCE_L_PORT 0x4A
+#define WS_SDMA_SOURCE_H_PORT 0x4C
+#define WS_SDMA_LENGTH_L_PORT 0x4E
+#define WS_SDMA_LENGTH_H_PORT 0x50
+#define WS_SDMA_CTRL_PORT 0x52
+#define WS_SDMA_CTRL_REPEAT 0x08
+#define WS_SDMA_CTRL_ENABLE 0x80
+
+#define WS_SOUND_NOISE_CTRL_PORT 0x8E
+#define WS_SOUND_NOISE_CTRL_LENGTH_32767 0x00
+#define WS_SOUND_NOISE_CTRL_LENGTH_1953 0x02
+#define WS_SOUND_NOISE_CTRL_LENGTH_254 0x03
+#define WS_SOUND_NOISE_CTRL_RESET 0x08
+#define WS_SOUND_NOISE_CTRL_ENABLE 0x10
+#define WS_SOUND_WAVE_BASE_PORT 0x8F
+#define WS_SOUND_CH_CTRL_PORT 0x90
+#define WS_SOUND_OUT_CTRL_PORT 0x91
+#define WS_SOUND_OUT_CTRL_SPEAKER_ENABLE 0x01
+#define WS_SOUND_OUT_CTRL_SPEAKER_VOLUME_100 0x06
+#define WS_SOUND_OUT_CTRL_HEADPHONE_ENABLE 0x08
+
+#define WS_INT_LINE_MATCH 4
+#define WS_INT_ENABLE_LINE_MATCH 0x10
+#define WS_INT_ACK_LINE_MATCH 0x10
+
+#define WS_MODEL_MONO 0x00
+#define WS_MODEL_PCV2 0x01
+#define WS_MODEL_COLOR 0x82
+
+uint8_t inportb(uint16_t port);
+uint16_t inportw(uint16_t port);
+void outportb(uint16_t port, uint8_t value);
+void outportw(uint16_t port, uint16_t value);
+
+uint16_t ws_bank_ram_save(uint16_t bank);
+uint16_t ws_bank_rom0_save(uint16_t bank);
+uint16_t ws_bank_rom1_save(uint16_t bank);
+#define ws_bank_ram_set(bank) ((void) ws_bank_ram_save(bank))
+#define ws_bank_rom0_set(bank) ((void) ws_bank_rom0_save(bank))
+#define ws_bank_rom1_set(bank) ((void) ws_bank_rom1_save(bank))
+#define ws_bank_ram_restore ws_bank_ram_set
+#define ws_bank_rom0_restore ws_bank_rom0_set
+#define ws_bank_rom1_restore ws_bank_rom1_set
+
+#define ws_bank_with_ram(bank, block) do { uint16_t __old = ws_bank_ram_save(bank); block; ws_bank_ram_restore(__old); } while (0)
+#define ws_bank_with_rom0(bank, block) do { uint16_t __old = ws_bank_rom0_save(bank); block; ws_bank_rom0_restore(__old); } while (0)
+#define ws_bank_with_rom1(bank, block) do { uint16_t __old = ws_bank_rom1_save(bank); block; ws_bank_rom1_restore(__old); } while (0)
+#define ws_bank_with_flash(value, block) do { uint8_t __old = inportb(WS_CART_BANK_FLASH_PORT); outportb(WS_CART_BANK_FLASH_PORT, value); block; outportb(WS_CART_BANK_FLASH_PORT, __old); } while (0)
+
+// The HBlank timer is implemented by the programs which use it.
+void ws_timer_hblank_start_once(uint16_t reload);
+uint16_t ws_timer_hblank_get_counter(void);
+void ws_timer_hblank_disable(void);
+
+bool ws_system_is_color_active(void);
+uint8_t ws_system_get_model(void);
+
+// Interrupts are not emulated.
+#define ws_int_set_handler(idx, handler) ((void) (idx), (void) (handler))
+#define ws_int_enable(mask) ((void) (mask))
+#define ws_int_ack(mask) ((void) (mask))
+
+#endif /* WS_H_ */
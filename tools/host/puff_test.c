@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Inflate (util/puff/puff.c) against zlib. Synthetic VGM, text and random
+// data is compressed by zlib with each strategy, then inflated by puff()
+// from the ROM0 window into SRAM, and by puff_ring() into a PSRAM ring
+// drained by a fake consumer. Both outputs must match, and truncated
+// streams must fail. Counts the symbols decoded through the lookup tables
+// and through the bit-by-bit fallback, and times puff() against zlib's
+// inflate() on the host.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "host.h"
+
+// The target's memcpy() copies forward a byte at a time, which puff relies
+// on for matches overlapping their own output.
+static void *forward_memcpy(void *dest, const void *src, size_t n) {
+    uint8_t *d = dest;
+    const uint8_t *s = src;
+    while (n--)
+        *(d++) = *(s++);
+    return dest;
+}
+
+#define memcpy forward_memcpy
+#include "util/puff/puff.c"
+#undef memcpy
+
+#define DATA_MAX_SIZE (256UL * 1024)
+#define SOURCE_BANK 0x80
+#define RING_BANK 0x40
+#define RING_BANKS 4
+
+static struct {
+    unsigned long symbols;
+    unsigned long slow_symbols;
+} stats;
+
+__attribute__((no_instrument_function))
+void __cyg_profile_func_enter(void *fn, void *call_site) {
+    if (fn == (void*) decode)
+        stats.symbols++;
+    else if (fn == (void*) decode_slow)
+        stats.slow_symbols++;
+}
+
+__attribute__((no_instrument_function))
+void __cyg_profile_func_exit(void *fn, void *call_site) {
+}
+
+static uint8_t data[DATA_MAX_SIZE];
+static uint8_t packed[DATA_MAX_SIZE + 1024];
+static uint8_t unpacked[DATA_MAX_SIZE];
+static uint32_t consumed;
+
+static uint32_t rand_state;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 8) & 0xFFFFFF;
+}
+
+// A VGM-like command stream: a few recurring register write patterns,
+// separated by short waits.
+static void make_vgm(uint32_t size) {
+    uint32_t i = 0;
+    rand_state = 1;
+    while (i + 8 <= size) {
+        uint8_t pattern = next_rand() % 24;
+        data[i++] = 0xBC;
+        data[i++] = pattern & 0x0F;
+        data[i++] = 0x80 + pattern * 3;
+        if (pattern & 1) {
+            data[i++] = 0x61;
+            data[i++] = 0xDF;
+            data[i++] = 0x02;
+        } else {
+            data[i++] = 0x70 + (pattern >> 1);
+        }
+    }
+    while (i < size)
+        data[i++] = 0x66;
+}
+
+static void make_text(uint32_t size) {
+    static const char *const words[] = {
+        "the ", "save ", "file ", "memory ", "bank ", "cartridge ", "of ",
+        "and ", "sector ", "to ", "is ", "a ", "WonderSwan ", "color ", "\n"
+    };
+    uint32_t i = 0;
+    rand_state = 2;
+    while (i < size) {
+        const char *w = words[next_rand() % 15];
+        while (*w && i < size)
+            data[i++] = *(w++);
+    }
+}
+
+static void make_random(uint32_t size) {
+    rand_state = 3;
+    for (uint32_t i = 0; i < size; i++)
+        data[i] = next_rand();
+}
+
+static unsigned long deflate_raw(uint32_t size, int level, int strategy) {
+    z_stream z = {0};
+    deflateInit2(&z, level, Z_DEFLATED, -15, 8, strategy);
+    z.next_in = data;
+    z.avail_in = size;
+    z.next_out = packed;
+    z.avail_out = sizeof(packed);
+    deflate(&z, Z_FINISH);
+    deflateEnd(&z);
+    return z.total_out;
+}
+
+static uint64_t inflate_zlib(unsigned long packed_size, uint32_t size) {
+    uint64_t start = host_time_us();
+    z_stream z = {0};
+    inflateInit2(&z, -15);
+    z.next_in = packed;
+    z.avail_in = packed_size;
+    z.next_out = unpacked;
+    z.avail_out = size;
+    inflate(&z, Z_FINISH);
+    inflateEnd(&z);
+    return host_time_us() - start;
+}
+
+static int puff_sram(unsigned long packed_size, uint32_t size) {
+    memcpy(host_psram + ((uint32_t) SOURCE_BANK << 16), packed, packed_size);
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    outportw(WS_CART_EXTBANK_RAM_PORT, 0);
+    outportw(WS_CART_EXTBANK_ROM0_PORT, SOURCE_BANK);
+    return puff(MK_FP(WS_SRAM_SEGMENT, 0x0000), size, MK_FP(WS_ROM0_SEGMENT, 0x0000), packed_size);
+}
+
+// Copy everything written to the ring so far into unpacked[].
+static void ring_consume(puff_ring_t *ring) {
+    uint32_t produced = ((uint32_t) ring->bank << 16) + ring->pos;
+    while (consumed < produced) {
+        uint32_t len = 0x10000 - (consumed & 0xFFFF);
+        if (len > produced - consumed)
+            len = produced - consumed;
+        const uint8_t *src = host_psram + ((uint32_t) (ring->bank_first + ((consumed >> 16) & ring->bank_mask)) << 16);
+        memcpy(unpacked + consumed, src + (consumed & 0xFFFF), len);
+        consumed += len;
+    }
+    ring->read_bank = consumed >> 16;
+}
+
+static bool consumer_poll(puff_ring_t *ring) {
+    ring_consume(ring);
+    return true;
+}
+
+static int puff_psram_ring(unsigned long packed_size) {
+    puff_ring_t ring = {0};
+    int err;
+
+    memcpy(host_psram + ((uint32_t) SOURCE_BANK << 16), packed, packed_size);
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_ENABLE);
+    outportw(WS_CART_EXTBANK_ROM0_PORT, SOURCE_BANK);
+    ring.bank_first = RING_BANK;
+    ring.bank_mask = RING_BANKS - 1;
+    ring.poll = consumer_poll;
+    consumed = 0;
+    err = puff_ring(&ring, MK_FP(WS_ROM0_SEGMENT, 0x0000), packed_size);
+    ring_consume(&ring);
+    outportb(WS_CART_BANK_FLASH_PORT, WS_CART_BANK_FLASH_DISABLE);
+    return err;
+}
+
+static int run(const char *name, uint32_t size, int level, int strategy, const char *strategy_name) {
+    unsigned long packed_size = deflate_raw(size, level, strategy);
+    uint64_t puff_time, zlib_time;
+    unsigned long bank_switches;
+    int err;
+
+    memset(host_sram, 0, size);
+    memset(&stats, 0, sizeof(stats));
+    host_bank_switches = 0;
+    puff_time = host_time_us();
+    err = puff_sram(packed_size, size);
+    puff_time = host_time_us() - puff_time;
+    bank_switches = host_bank_switches;
+    if (err || memcmp(host_sram, data, size)) {
+        printf("FAIL: %s, %s: puff() returned %d\n", name, strategy_name, err);
+        return 1;
+    }
+
+    memset(unpacked, 0, size);
+    err = puff_psram_ring(packed_size);
+    if (err || consumed != size || memcmp(unpacked, data, size)) {
+        printf("FAIL: %s, %s: puff_ring() returned %d, %lu bytes\n", name, strategy_name, err, (unsigned long) consumed);
+        return 1;
+    }
+
+    zlib_time = inflate_zlib(packed_size, size);
+    if (memcmp(unpacked, data, size)) {
+        printf("FAIL: %s, %s: zlib mismatch\n", name, strategy_name);
+        return 1;
+    }
+
+    if (packed_size > 16 && puff_sram(packed_size / 2, size) == 0) {
+        printf("FAIL: %s, %s: truncated stream accepted\n", name, strategy_name);
+        return 1;
+    }
+
+    printf("%-6s %-8s %6lu -> %6lu bytes: %6lu symbols, %5.2f%% bit by bit, %6lu bank sw; puff %6lu us, zlib %4lu us\n",
+        name, strategy_name, packed_size, (unsigned long) size, stats.symbols,
+        stats.symbols ? stats.slow_symbols * 100.0 / stats.symbols : 0.0,
+        bank_switches, (unsigned long) puff_time, (unsigned long) zlib_time);
+    return 0;
+}
+
+int main(void) {
+    static const struct {
+        int level;
+        int strategy;
+        const char *name;
+    } modes[] = {
+        {0, Z_DEFAULT_STRATEGY, "stored"},
+        {1, Z_DEFAULT_STRATEGY, "level 1"},
+        {6, Z_DEFAULT_STRATEGY, "level 6"},
+        {9, Z_DEFAULT_STRATEGY, "level 9"},
+        {6, Z_FIXED, "fixed"},
+        {6, Z_HUFFMAN_ONLY, "huffman"},
+        {6, Z_RLE, "rle"}
+    };
+    int failed = 0;
+
+    host_init();
+    // Bank switches remap the host's windows, and dominate the host time of
+    // matches which cross a bank; the single-bank runs time the decoder.
+    for (int banks = 0; banks < 2; banks++) {
+        uint32_t size = banks ? DATA_MAX_SIZE : 60000;
+        for (int kind = 0; kind < 3; kind++) {
+            for (size_t i = 0; i < sizeof(modes) / sizeof(*modes); i++) {
+                if (kind == 0) make_vgm(size);
+                else if (kind == 1) make_text(size);
+                else make_random(size);
+                failed |= run(kind == 0 ? "vgm" : kind == 1 ? "text" : "random",
+                    size, modes[i].level, modes[i].strategy, modes[i].name);
+            }
+        }
+    }
+
+    return failed;
+}
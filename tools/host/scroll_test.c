@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// One-row scrolling of the text viewer (plugin/ui_txtview.c) in both screen
+// orientations. A page of glyph rows is drawn with ui/bitmap.c, moved up by
+// one row with bitmap_scroll_rows() and the exposed last row drawn, as the
+// viewer does; the tiles must then match a full redraw of the next page,
+// pixel for pixel. Runs on 2bpp tiles moved by the CPU (mono) and 4bpp tiles
+// moved by general DMA (color), for 8 and 16 pixel rows.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ws.h>
+#include "host.h"
+
+#include "ui/bitmap.c"
+
+#define SCROLLS 40
+#define GLYPH_STRIDE 40
+
+static bitmap_t bitmap;
+static uint8_t saved[0x4000];
+
+void bitmapfont_update_active_font(void) {
+}
+
+// C versions of the row operations in ui/bitmap_asm.s.
+void __bitmap_bitop_fill_c(uint16_t value, void *dest, uint16_t _rows) {
+    uint8_t *d = dest;
+    for (uint16_t i = 0; i < _rows; i++, d += 2) {
+        d[0] = value;
+        d[1] = value >> 8;
+    }
+}
+
+void __bitmap_bitop_row_c(uint16_t _and, uint16_t _xor, uint16_t _rows, uint16_t _mask, bitmap_t *bitmap, void *dest) {
+    uint8_t *d = dest;
+    for (uint16_t i = 0; i < _rows; i++, d += bitmap->current_pitch) {
+        uint16_t r = d[0] | (d[1] << 8);
+        r = (r & ~_mask) | (((r & _and) ^ _xor) & _mask);
+        d[0] = r;
+        d[1] = r >> 8;
+    }
+}
+
+static uint32_t hash(uint32_t a, uint32_t b) {
+    uint32_t h = a * 0x9E3779B1 ^ (b + 0x7F4A7C15) * 0x85EBCA77;
+    return (h ^ (h >> 15)) * 0xC2B2AE3D;
+}
+
+static uint16_t bitmap_size(void) {
+    return bitmap.x_pitch * bitmap.width;
+}
+
+// Glyph data is read through the ROM0 window, as from the font. Glyphs of
+// the vertical font are stored rotated, as in bitmapfont.c.
+static void draw_glyphs(uint16_t y, uint16_t font_height, uint32_t content) {
+    uint16_t x = 2;
+    for (uint32_t i = 0; ; i++) {
+        uint32_t h = hash(content, i);
+        uint16_t w = 1 + (h & (font_height - 1));
+        if (x + w > screen_width - 2)
+            break;
+        uint16_t offset = ((h >> 8) % (0x10000 / GLYPH_STRIDE)) * GLYPH_STRIDE;
+        if (bitmap_rotation)
+            bitmap_draw_glyph(&bitmap, x, y, w, font_height, 0, MK_FP(WS_ROM0_SEGMENT, offset));
+        else
+            bitmap_draw_glyph(&bitmap, x, y, font_height, w, 0, MK_FP(WS_ROM0_SEGMENT, offset));
+        x += w + 1;
+    }
+}
+
+static void draw_row(uint16_t row, uint16_t font_height, uint32_t content) {
+    uint16_t y = 8 + row * font_height;
+    bitmap_rect_fill(&bitmap, 0, y, screen_width, font_height, BITMAP_COLOR_2BPP(2));
+    draw_glyphs(y, font_height, content);
+}
+
+static void draw_page(uint16_t rows, uint16_t font_height, uint32_t first) {
+    bitmap_clear(&bitmap);
+    bitmap_rect_fill(&bitmap, 0, 0, screen_width, 8, BITMAP_COLOR_2BPP(1));
+    draw_glyphs(0, 8, 0xFFFFFFFF);
+    bitmap_rect_fill(&bitmap, 0, screen_height - 8, screen_width, 8, BITMAP_COLOR_2BPP(3));
+    draw_glyphs(screen_height - 8, 8, 0xFFFFFFFE);
+    for (uint16_t i = 0; i < rows; i++)
+        draw_row(i, font_height, first + i);
+}
+
+static int run(bool vertical, bool color, uint16_t font_height) {
+    host_set_color_active(color);
+    bitmap = color
+        ? BITMAP(host_memory + 0x4000, WS_DISPLAY_WIDTH_PIXELS >> 3, WS_DISPLAY_HEIGHT_PIXELS >> 3, 4)
+        : BITMAP(host_memory + 0x2000, WS_DISPLAY_WIDTH_PIXELS >> 3, WS_DISPLAY_HEIGHT_PIXELS >> 3, 2);
+    bitmap_set_screen_force_horizontal(false);
+    bitmap_set_screen_rotation(vertical);
+
+    uint16_t text_height = screen_height - 16;
+    uint16_t rows = text_height / font_height;
+    const char *name = vertical ? "vertical" : "horizontal";
+
+    draw_page(rows, font_height, 0);
+    memcpy(saved, bitmap.start, bitmap_size());
+    draw_page(rows, font_height, 1);
+    if (!memcmp(saved, bitmap.start, bitmap_size())) {
+        printf("FAIL: %s, %ubpp, %upx: consecutive pages are identical\n", name, bitmap.bpp, font_height);
+        return 1;
+    }
+
+    draw_page(rows, font_height, 0);
+    for (uint32_t k = 0; k < SCROLLS; k++) {
+        // Mirrors the one-row scroll of ui_txtview().
+        bitmap_scroll_rows(&bitmap, 8 + font_height, 8, text_height - font_height);
+        bitmap_rect_fill(&bitmap, 0, 8 + text_height - font_height, screen_width, font_height, BITMAP_COLOR_2BPP(2));
+        draw_row(rows - 1, font_height, k + rows);
+
+        memcpy(saved, bitmap.start, bitmap_size());
+        draw_page(rows, font_height, k + 1);
+        for (uint16_t i = 0; i < bitmap_size(); i++) {
+            if (saved[i] != ((uint8_t*) bitmap.start)[i]) {
+                printf("FAIL: %s, %ubpp, %upx: scroll %lu differs from a redraw at tile byte %u\n",
+                    name, bitmap.bpp, font_height, (unsigned long) k + 1, i);
+                return 1;
+            }
+        }
+    }
+
+    printf("%-10s %ubpp %2upx rows: %2u rows, %u scrolls match a full redraw\n",
+        name, bitmap.bpp, font_height, rows, SCROLLS);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+
+    host_init();
+    for (uint32_t i = 0; i < 0x10000; i++)
+        host_psram[i] = hash(i, 0) >> 24;
+
+    for (int vertical = 0; vertical < 2; vertical++) {
+        for (int color = 0; color < 2; color++) {
+            failed |= run(vertical, color, 8);
+            failed |= run(vertical, color, 16);
+        }
+    }
+    return failed;
+}
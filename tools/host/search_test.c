@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Text search (util/search.c) over a generated 4 MB text file in PSRAM,
+// searched through the ROM0 window one 64 KB bank at a time, as the text
+// viewer does. Every match is checked against a byte-by-byte reference
+// search, with and without case folding. Reports the host throughput of
+// both searches.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ws.h>
+#include "host.h"
+
+#include "util/search.c"
+
+#define TEXT_SIZE (4UL * 1024 * 1024)
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 8) & 0xFFFFFF;
+}
+
+static void make_text(void) {
+    static const char *const words[] = {
+        "the ", "The ", "cartridge ", "WonderSwan ", "save ", "of ", "and ",
+        "memory ", "bank ", "Color ", "to ", "a ", "sector ", "file ", "is ",
+        "card ", "storage ", "in ", "SRAM ", "flash ", "menu ", ".\n", ", "
+    };
+    uint32_t i = 0;
+    while (i < TEXT_SIZE) {
+        const char *w = words[next_rand() % (sizeof(words) / sizeof(*words))];
+        while (*w && i < TEXT_SIZE)
+            host_psram[i++] = *(w++);
+    }
+    // Matches straddling bank edges.
+    for (uint32_t bank = 1; bank < 8; bank++)
+        memcpy(host_psram + (bank << 16) - bank * 2, "WonderSwan Color", 16);
+}
+
+static uint32_t reference_search(const uint8_t *pattern, uint8_t len, bool fold, uint32_t pos) {
+    for (; pos + len <= TEXT_SIZE; pos++) {
+        uint8_t i = 0;
+        while (i < len && (fold ? tolower(host_psram[pos + i]) : host_psram[pos + i]) == pattern[i])
+            i++;
+        if (i == len)
+            return pos;
+    }
+    return TEXT_SIZE;
+}
+
+// Search 64 KB banks through the ROM0 window, and the bytes around each
+// bank edge from a copy, as txtview_search() does.
+static uint32_t bank_search(const search_t *s, uint32_t pos) {
+    uint8_t edge[(SEARCH_PATTERN_MAX - 1) * 2];
+    uint8_t m1 = s->len - 1;
+
+    while (pos + s->len <= TEXT_SIZE) {
+        uint32_t bank_pos = pos & ~0xFFFFUL;
+        uint32_t next_bank_pos = bank_pos + 0x10000;
+        uint16_t last = (TEXT_SIZE - 1 - bank_pos) > 0xFFFF ? 0xFFFF : (TEXT_SIZE - 1 - bank_pos);
+        uint16_t offset;
+
+        outportw(WS_CART_EXTBANK_ROM0_PORT, bank_pos >> 16);
+        if (search_block(s, MK_FP(WS_ROM0_SEGMENT, 0), pos & 0xFFFF, last, &offset))
+            return bank_pos + offset;
+        if (next_bank_pos >= TEXT_SIZE)
+            break;
+
+        if (m1) {
+            uint32_t edge_pos = next_bank_pos - m1;
+            if (edge_pos < pos) edge_pos = pos;
+            uint8_t edge_len = 0;
+            while (edge_len < sizeof(edge) && (edge_pos + edge_len) < TEXT_SIZE && (edge_pos + edge_len) < (next_bank_pos + m1)) {
+                edge[edge_len] = host_psram[edge_pos + edge_len];
+                edge_len++;
+            }
+            if (edge_len && search_block(s, edge, 0, edge_len - 1, &offset))
+                return edge_pos + offset;
+        }
+        pos = next_bank_pos;
+    }
+    return TEXT_SIZE;
+}
+
+static int run(const char *text, bool fold) {
+    search_t s = {0};
+    uint8_t folded[SEARCH_PATTERN_MAX];
+    unsigned long matches = 0;
+    uint64_t time, ref_time = 0;
+
+    s.len = strlen(text);
+    s.fold = fold;
+    memcpy(s.pattern, text, s.len);
+    search_init(&s);
+    for (uint8_t i = 0; i < s.len; i++)
+        folded[i] = fold ? tolower((uint8_t) text[i]) : text[i];
+
+    time = host_time_us();
+    uint32_t pos = 0, expected = 0;
+    while (true) {
+        pos = bank_search(&s, pos);
+
+        uint64_t ref_start = host_time_us();
+        expected = reference_search(folded, s.len, fold, expected);
+        ref_time += host_time_us() - ref_start;
+
+        if (pos != expected) {
+            printf("FAIL: \"%s\"%s: match at %lu, expected %lu\n", text, fold ? " (-i)" : "",
+                (unsigned long) pos, (unsigned long) expected);
+            return 1;
+        }
+        if (pos >= TEXT_SIZE)
+            break;
+        matches++;
+        pos++;
+        expected++;
+    }
+    time = host_time_us() - time - ref_time;
+
+    printf("%-26s %-3s %6lu matches: %7.1f MB/s, byte by byte %6.1f MB/s\n",
+        text, fold ? "-i" : "", matches,
+        TEXT_SIZE / (double) (time ? time : 1), TEXT_SIZE / (double) (ref_time ? ref_time : 1));
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+
+    host_init();
+    make_text();
+    failed |= run("WonderSwan Color", false);
+    failed |= run("wonderswan color", true);
+    failed |= run("storage card", false);
+    failed |= run("not in the text", false);
+    failed |= run("cartridge SRAM flash menu", false);
+    failed |= run("of", false);
+    failed |= run("e", true);
+    return failed;
+}
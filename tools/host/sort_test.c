@@ -0,0 +1,321 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Directory listing sort (ui_file_selector_qsort.c) on synthetic 100, 500
+// and 1500-entry directories. Counts comparisons, comparisons which fall
+// back to the full names, bank switches and bytes copied, and compares them
+// with the previous layout: 256-byte records, each comparison opening both
+// records and copying one of them when they are in different banks.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "host.h"
+
+static unsigned long bytes_copied;
+
+static void *counted_memcpy(void *dest, const void *src, size_t n) {
+    bytes_copied += n;
+    return memcpy(dest, src, n);
+}
+
+#define memcpy counted_memcpy
+#include "ui/ui_file_selector_qsort.c"
+#undef memcpy
+
+#define OLD_ENTRY_SIZE 256
+
+typedef struct {
+    unsigned long comparisons;
+    unsigned long fallbacks;
+    unsigned long bank_switches;
+    unsigned long bytes_copied;
+    unsigned long bytes_compared;
+} sort_stats_t;
+
+static sort_stats_t stats;
+static bool count_keys;
+static FILINFO files[FILE_SELECTOR_MAX_FILES];
+static uint8_t sort_mode;
+
+static const char *const name_prefixes[] = {
+    "Super Robot Taisen", "SD Gundam", "Final Fantasy", "Digimon", "Pocket Fighter",
+    "Rockman EXE", "Kaze no Klonoa", "Gunpey", "Judgement Silversword", "Makaimura",
+    "Dicing Knight", "Tetris", "Wizardry", "Romancing SaGa", "Saint Seiya"
+};
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 8) & 0xFFFFFF;
+}
+
+static void make_directory(uint16_t count) {
+    rand_state = count;
+    for (uint16_t i = 0; i < count; i++) {
+        FILINFO *fno = &files[i];
+        memset(fno, 0, sizeof(FILINFO));
+        if (i < count / 20) {
+            fno->fattrib = AM_DIR;
+            snprintf(fno->fname, sizeof(fno->fname), "%s Collection %u",
+                name_prefixes[next_rand() % 15], i);
+        } else {
+            fno->fattrib = AM_ARC;
+            snprintf(fno->fname, sizeof(fno->fname), "%s %u (Japan) (Rev %u).%s",
+                name_prefixes[next_rand() % 15], i, next_rand() % 4,
+                (next_rand() & 1) ? "wsc" : "ws");
+            fno->fsize = 0x10000 << (next_rand() % 7);
+        }
+        fno->fdate = next_rand();
+        fno->ftime = next_rand();
+    }
+}
+
+static int compare_filenames(const file_selector_entry_t __far* a, const file_selector_entry_t __far* b, void *userdata) {
+    uint8_t mode = (uint8_t) (uintptr_t) userdata;
+    const char *na = a->fname, *nb = b->fname;
+    stats.fallbacks++;
+    for (; *na && tolower(*na) == tolower(*nb); na++, nb++)
+        stats.bytes_compared += 2;
+    stats.bytes_compared += 2;
+    if (mode == SETTING_FILE_SORT_NAME_DESC)
+        return strcasecmp(b->fname, a->fname);
+    else
+        return strcasecmp(a->fname, b->fname);
+}
+
+// Store the records and sort keys as ui_file_selector_scan_directory() does.
+// Returns the size of the record area, in bytes.
+static uint32_t store_directory(uint16_t count) {
+    uint16_t entry_pos = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        FILINFO *fno = &files[i];
+        uint8_t name_len = strlen(fno->fname);
+        uint16_t entry_units = (sizeof(file_selector_entry_t) + name_len + 1 + (1 << FILE_SELECTOR_ENTRY_SHIFT) - 1) >> FILE_SELECTOR_ENTRY_SHIFT;
+        if (((entry_pos & ((1 << FILE_SELECTOR_ENTRY_BANK_SHIFT) - 1)) + entry_units) > (1 << FILE_SELECTOR_ENTRY_BANK_SHIFT))
+            entry_pos = (entry_pos | ((1 << FILE_SELECTOR_ENTRY_BANK_SHIFT) - 1)) + 1;
+
+        file_selector_entry_t __far* entry = ui_file_selector_open_fno_direct(entry_pos);
+        entry->fsize = fno->fsize;
+        entry->fdate = fno->fdate;
+        entry->ftime = fno->ftime;
+        entry->fattrib = fno->fattrib;
+        entry->name_len = name_len;
+        memcpy(entry->fname, fno->fname, name_len + 1);
+
+        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+        ui_file_selector_sort_key_init(FILE_SELECTOR_SORT_KEYS + i, fno, entry_pos, i, sort_mode);
+        entry_pos += entry_units;
+    }
+    return (uint32_t) entry_pos << FILE_SELECTOR_ENTRY_SHIFT;
+}
+
+static int compare_reference(const void *a, const void *b) {
+    uint16_t i = *(const uint16_t*) a;
+    uint16_t j = *(const uint16_t*) b;
+    const FILINFO *fa = &files[i];
+    const FILINFO *fb = &files[j];
+    bool a_dir = fa->fattrib & AM_DIR;
+    bool b_dir = fb->fattrib & AM_DIR;
+    if (a_dir != b_dir)
+        return a_dir ? -1 : 1;
+    if (sort_mode == SETTING_FILE_SORT_NAME_ASC) {
+        int result = strcasecmp(fa->fname, fb->fname);
+        if (result)
+            return result;
+    } else {
+        uint32_t ka = ((uint32_t) fa->fdate << 16) | fa->ftime;
+        uint32_t kb = ((uint32_t) fb->fdate << 16) | fb->ftime;
+        if (ka != kb)
+            return ka < kb ? -1 : 1;
+    }
+    return i < j ? -1 : 1;
+}
+
+// Comparisons made by the sort, counted through -finstrument-functions.
+__attribute__((no_instrument_function))
+void __cyg_profile_func_enter(void *fn, void *call_site) {
+    if (fn == (void*) qsort_compare) {
+        stats.comparisons++;
+        // Both sort keys are read.
+        if (count_keys)
+            stats.bytes_compared += sizeof(file_selector_sort_key_t) * 2;
+    }
+}
+
+__attribute__((no_instrument_function))
+void __cyg_profile_func_exit(void *fn, void *call_site) {
+}
+
+// The comparison sequence of the previous sort; the quicksort is the same,
+// and so is the order it converges to, so only the per-comparison cost differs.
+static int old_compare(uint16_t i, uint16_t j) {
+    stats.comparisons++;
+    stats.bytes_compared += 4;
+    if ((i >> 8) == (j >> 8)) {
+        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_RAM_BANK_OFFSET + (i >> 8));
+        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+    } else {
+        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_RAM_BANK_OFFSET + (i >> 8));
+        stats.bytes_copied += OLD_ENTRY_SIZE;
+        outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_RAM_BANK_OFFSET + (j >> 8));
+    }
+    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+
+    // Directory flags, then the full names.
+    stats.bytes_compared += 2;
+    bool a_dir = files[i].fattrib & AM_DIR;
+    bool b_dir = files[j].fattrib & AM_DIR;
+    if (a_dir != b_dir)
+        return a_dir ? -1 : 1;
+    if (sort_mode != SETTING_FILE_SORT_NAME_ASC) {
+        uint32_t ka = ((uint32_t) files[i].fdate << 16) | files[i].ftime;
+        uint32_t kb = ((uint32_t) files[j].fdate << 16) | files[j].ftime;
+        stats.bytes_compared += 8;
+        return ka == kb ? 0 : (ka < kb ? -1 : 1);
+    }
+    stats.fallbacks++;
+    const char *na = files[i].fname, *nb = files[j].fname;
+    for (; *na && tolower(*na) == tolower(*nb); na++, nb++)
+        stats.bytes_compared += 2;
+    stats.bytes_compared += 2;
+    return strcasecmp(files[i].fname, files[j].fname);
+}
+
+static void old_sort(uint16_t *base, size_t nmemb) {
+    uint16_t *stack[48], **stackptr = stack;
+    uint16_t *i, *j, *limit = base + nmemb, tmp;
+#define OLD_SWAP(a, b) tmp = *(a); *(a) = *(b); *(b) = tmp
+
+    for (;;) {
+        if ((size_t) (limit - base) > T) {
+            i = base + 1;
+            j = limit - 1;
+            OLD_SWAP(((size_t) (limit - base)) / 2 + base, base);
+            if (old_compare(*i, *j) > 0) { OLD_SWAP(i, j); }
+            if (old_compare(*base, *j) > 0) { OLD_SWAP(base, j); }
+            if (old_compare(*i, *base) > 0) { OLD_SWAP(i, base); }
+            for (;;) {
+                do i += 1; while (old_compare(*i, *base) < 0);
+                do j -= 1; while (old_compare(*j, *base) > 0);
+                if (i > j) break;
+                OLD_SWAP(i, j);
+            }
+            OLD_SWAP(base, j);
+            if (j - base > limit - i) {
+                stackptr[0] = base; stackptr[1] = j; stackptr += 2;
+                base = i;
+            } else {
+                stackptr[0] = i; stackptr[1] = limit; stackptr += 2;
+                limit = j;
+            }
+        } else {
+            for (j = base, i = j + 1; i < limit; j = i, i += 1) {
+                for (; old_compare(*j, *(j + 1)) > 0; j -= 1) {
+                    OLD_SWAP(j, j + 1);
+                    if (j == base) break;
+                }
+            }
+            if (stackptr != stack) {
+                stackptr -= 2; base = stackptr[0]; limit = stackptr[1];
+            } else {
+                break;
+            }
+        }
+    }
+#undef OLD_SWAP
+}
+
+static void print_stats(const char *name) {
+    printf("  %-8s %6lu cmp %6lu by name %6lu bank sw %8lu copied %7lu read  %5.1f bytes/cmp\n",
+        name, stats.comparisons, stats.fallbacks, stats.bank_switches, stats.bytes_copied, stats.bytes_compared,
+        (double) (stats.bytes_copied + stats.bytes_compared) / stats.comparisons);
+}
+
+static bool run(uint16_t count, uint8_t mode) {
+    uint16_t reference[FILE_SELECTOR_MAX_FILES];
+    bool ok = true;
+
+    sort_mode = mode;
+    make_directory(count);
+    for (uint16_t i = 0; i < count; i++)
+        reference[i] = i;
+    qsort(reference, count, sizeof(uint16_t), compare_reference);
+
+    printf("%u entries, %s sort\n", count, mode == SETTING_FILE_SORT_NAME_ASC ? "name" : "date");
+    uint16_t old_indexes[FILE_SELECTOR_MAX_FILES];
+    memset(&stats, 0, sizeof(stats));
+    for (uint16_t i = 0; i < count; i++)
+        old_indexes[i] = i;
+    unsigned long switches = host_bank_switches;
+    old_sort(old_indexes, count);
+    stats.bank_switches = host_bank_switches - switches;
+    print_stats("before");
+
+    uint32_t records_size = store_directory(count);
+    memset(&stats, 0, sizeof(stats));
+    switches = host_bank_switches;
+    bytes_copied = 0;
+    count_keys = true;
+    ui_file_selector_qsort(count, ui_file_selector_sort_key_is_exact(mode) ? NULL : compare_filenames, (void*) (uintptr_t) mode);
+    stats.bank_switches = host_bank_switches - switches;
+    stats.bytes_copied = bytes_copied;
+    count_keys = false;
+    if (mode == SETTING_FILE_SORT_NAME_ASC)
+        printf("  records: %lu bytes, %lu before\n", (unsigned long) records_size, (unsigned long) count * OLD_ENTRY_SIZE);
+
+    outportw(WS_CART_EXTBANK_RAM_PORT, FILE_SELECTOR_INDEX_BANK);
+    for (uint16_t i = 0; i < count; i++) {
+        file_selector_entry_t __far *entry = ui_file_selector_open_fno(i);
+        if (strcmp(entry->fname, files[reference[i]].fname))
+            ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    static const uint16_t counts[] = {100, 500, 1500};
+    int failures = 0;
+
+    host_init();
+
+    // The scan stops at FILE_SELECTOR_MAX_FILES or at the end of the record area.
+    sort_mode = SETTING_FILE_SORT_NAME_ASC;
+    make_directory(FILE_SELECTOR_MAX_FILES);
+    uint32_t records_size = store_directory(FILE_SELECTOR_MAX_FILES);
+    bool fits = records_size <= ((uint32_t) FILE_SELECTOR_ENTRY_AREA_END << FILE_SELECTOR_ENTRY_SHIFT);
+    printf("%s: %u entries use %lu of %lu record bytes (1524 entries before)\n", fits ? "ok" : "FAIL",
+        FILE_SELECTOR_MAX_FILES, (unsigned long) records_size,
+        (unsigned long) FILE_SELECTOR_ENTRY_AREA_END << FILE_SELECTOR_ENTRY_SHIFT);
+    failures += !fits;
+
+    for (int i = 0; i < 3; i++) {
+        for (int m = 0; m < 2; m++) {
+            bool ok = run(counts[i], m ? SETTING_FILE_SORT_DATE_ASC : SETTING_FILE_SORT_NAME_ASC);
+            print_stats("after");
+            if (!ok) {
+                printf("FAIL: order differs from the reference sort\n");
+                failures++;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// VGM playback (plugin/vgm/) of generated SN76489 and Game Boy tracks in
+// PSRAM. After every vgm_play() call, the tone dividers in the sound ports
+// are checked against the exact quotient for the chip registers, and
+// compared with the signed 32-bit division the drivers used before, which
+// overflowed for low notes. Reports the divider writes per call and per
+// second of music, and the host time per call.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ws.h>
+#include "host.h"
+
+// The line interrupt handler of the DMG driver is not called on the host.
+#define assume_ss_data
+#define interrupt
+#include "plugin/vgm/core.c"
+#include "plugin/vgm/driver_dmg.c"
+#include "plugin/vgm/driver_sn76489.c"
+#include "plugin/vgm/driver_ws.c"
+#undef assume_ss_data
+#undef interrupt
+
+// Tracks fit in one 64 KB bank. Far pointers are normalized on the host,
+// so vgm_ptr_to_state() would not see a bank crossing.
+#define TRACK_SECONDS 60
+#define FRAME_SAMPLES 735
+
+#define SN76489_CLOCK 3579545
+#define DMG_CLOCK 4194304
+
+void dprint(const char __far* format, ...) {
+}
+
+void lcd_set_vtotal(uint8_t vtotal) {
+}
+
+void ui_hide(void) {
+}
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 8) & 0xFFFFFF;
+}
+
+static uint8_t *track;
+static uint32_t track_len;
+
+static void emit(uint8_t value) {
+    track[track_len++] = value;
+}
+
+static void put32(uint32_t ofs, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+        track[ofs + i] = value >> (i * 8);
+}
+
+static void begin_track(uint32_t psram_ofs, uint32_t version, uint32_t data_ofs) {
+    track = host_psram + psram_ofs;
+    memset(track, 0, data_ofs);
+    put32(0x00, 0x206d6756);
+    put32(0x08, version);
+    put32(0x18, TRACK_SECONDS * 60 * FRAME_SAMPLES);
+    put32(0x34, data_ofs - 0x34);
+    track_len = data_ofs;
+}
+
+static void end_track(void) {
+    emit(0x66);
+    put32(0x04, track_len - 4);
+}
+
+// Notes from MIDI key 45 (110 Hz) to 96 (2093 Hz), for the SN76489; the
+// Game Boy's period range reaches down to key 36 (65 Hz).
+static double note_freq(uint8_t lowest) {
+    uint8_t key = lowest + next_rand() % (97 - lowest);
+    return 440.0 * pow(2.0, (key - 69) / 12.0);
+}
+
+static void make_sn76489_track(uint32_t psram_ofs) {
+    uint16_t tone[3] = {0};
+
+    begin_track(psram_ofs, 0x150, 0x40);
+    put32(0x0C, SN76489_CLOCK);
+    track[0x28] = 0x09;
+    track[0x2A] = 16;
+
+    for (uint32_t frame = 0; frame < TRACK_SECONDS * 60; frame++) {
+        for (uint8_t ch = 0; ch < 3; ch++) {
+            if (!tone[ch] || !(next_rand() & 7)) {
+                // new note: both tone bytes and the volume
+                tone[ch] = SN76489_CLOCK / (32 * note_freq(45));
+                emit(0x50); emit(0x80 | (ch << 5) | (tone[ch] & 0xF));
+                emit(0x50); emit((tone[ch] >> 4) & 0x3F);
+                emit(0x50); emit(0x90 | (ch << 5) | (next_rand() & 7));
+            } else {
+                // vibrato: low tone bits only
+                emit(0x50); emit(0x80 | (ch << 5) | ((tone[ch] + (frame & 3)) & 0xF));
+            }
+        }
+        if (!(frame & 15)) {
+            emit(0x50); emit(0xE0 | (next_rand() & 7));
+            emit(0x50); emit(0xF0 | (next_rand() & 0xF));
+        }
+        emit(0x62);
+    }
+    end_track();
+}
+
+static void make_dmg_track(uint32_t psram_ofs) {
+    static const uint8_t nrx3[3] = {0x03, 0x08, 0x0D};
+    uint16_t period[3] = {0};
+
+    begin_track(psram_ofs, 0x161, 0x100);
+    put32(0x80, DMG_CLOCK);
+
+    emit(0xB3); emit(0x16); emit(0x80);
+    emit(0xB3); emit(0x14); emit(0x77);
+    emit(0xB3); emit(0x15); emit(0xFF);
+    emit(0xB3); emit(0x0A); emit(0x80);
+    emit(0xB3); emit(0x0C); emit(0x20);
+
+    for (uint32_t frame = 0; frame < TRACK_SECONDS * 60; frame++) {
+        for (uint8_t ch = 0; ch < 3; ch++) {
+            uint8_t reg = nrx3[ch];
+            if (!period[ch] || !(next_rand() & 7)) {
+                // new note: duty, envelope and a triggered period
+                period[ch] = 2048 - (uint16_t) (131072 / note_freq(36));
+                if (ch < 2) {
+                    emit(0xB3); emit(reg - 2); emit((next_rand() & 3) << 6);
+                    emit(0xB3); emit(reg - 1); emit(0xF3);
+                }
+                emit(0xB3); emit(reg); emit(period[ch]);
+                emit(0xB3); emit(reg + 1); emit(0x80 | (period[ch] >> 8));
+            } else {
+                // vibrato: low period bits only
+                emit(0xB3); emit(reg); emit(period[ch] + (frame & 3));
+            }
+        }
+        emit(0x62);
+    }
+    end_track();
+}
+
+static uint16_t port_divider(uint8_t ch) {
+    return -inportw(0x80 + (ch << 1));
+}
+
+// Exact and previous divider, for num * value / den.
+static uint16_t exact_divider(uint32_t num, uint16_t value, uint32_t den) {
+    return ((uint64_t) num * value) / den;
+}
+
+static uint16_t old_divider(uint32_t num, uint16_t value, uint32_t den) {
+    return (int32_t) (uint32_t) (num * value) / (int32_t) den;
+}
+
+typedef struct {
+    unsigned long checks;
+    unsigned long off_by_one;
+    unsigned long old_wrong;
+} divider_stats_t;
+
+static bool check_divider(divider_stats_t *st, uint8_t ch, uint32_t num, uint16_t value, uint32_t den) {
+    uint16_t actual = port_divider(ch);
+    uint16_t exact = exact_divider(num, value, den);
+    uint16_t old = old_divider(num, value, den);
+
+    st->checks++;
+    if (actual != exact) {
+        if (actual + 1 != exact) {
+            printf("FAIL: channel %u, value %u: divider %u, expected %u\n", ch, value, actual, exact);
+            return false;
+        }
+        st->off_by_one++;
+    }
+    if (old + 1 < exact || old > exact)
+        st->old_wrong++;
+    return true;
+}
+
+static bool check_sn76489(vgm_state_t *state, divider_stats_t *st) {
+    for (uint8_t ch = 0; ch < 3; ch++) {
+        if (!check_divider(st, ch, 3072000, state->sn76489.tone[ch], state->clock >> 1))
+            return false;
+    }
+    uint16_t noise_tone = (state->sn76489.noise & 3) == 3 ? state->sn76489.tone[2] : (0x10 << (state->sn76489.noise & 3));
+    return check_divider(st, 3, 3072000, noise_tone, state->clock >> 5);
+}
+
+static bool check_dmg(vgm_state_t *state, divider_stats_t *st) {
+    for (uint8_t ch = 0; ch < 3; ch++) {
+        if (!check_divider(st, ch, 1536000, 2048 - (state->dmg.period[ch] & 0x7FF), state->clock >> 2))
+            return false;
+    }
+    return true;
+}
+
+static int run(const char *name, uint8_t bank, bool (*check)(vgm_state_t*, divider_stats_t*)) {
+    vgm_state_t state;
+    divider_stats_t st = {0};
+    unsigned long calls = 0, divider_writes = 0, max_divider_writes = 0;
+    uint64_t time = 0;
+
+    // Keep the track's banks mapped, so that vgm_play() does not remap them
+    // on the host when it restores the previous banks.
+    ws_bank_rom0_set(bank);
+    ws_bank_rom1_set(bank + 1);
+    memset(host_io_writes, 0, sizeof(host_io_writes));
+    if (!vgm_init(&state, bank, 0)) {
+        printf("FAIL: %s: vgm_init() failed\n", name);
+        return 1;
+    }
+
+    while (true) {
+        unsigned long writes = host_io_writes[0x80] + host_io_writes[0x82] + host_io_writes[0x84] + host_io_writes[0x86];
+
+        uint64_t start = host_time_us();
+        uint16_t lines = vgm_play(&state);
+        time += host_time_us() - start;
+        calls++;
+
+        writes = host_io_writes[0x80] + host_io_writes[0x82] + host_io_writes[0x84] + host_io_writes[0x86] - writes;
+        divider_writes += writes;
+        if (writes > max_divider_writes)
+            max_divider_writes = writes;
+
+        if (!check(&state, &st))
+            return 1;
+        if (!lines)
+            break;
+    }
+
+    printf("%-8s %lu calls, %lu divider writes (%.1f per second, at most %lu per call), %.3f us per call\n",
+        name, calls, divider_writes, divider_writes / (double) TRACK_SECONDS, max_divider_writes,
+        time / (double) calls);
+    printf("%-8s %lu divider checks: %lu one below the exact quotient, %lu wrong with the previous division\n",
+        "", st.checks, st.off_by_one, st.old_wrong);
+    return 0;
+}
+
+int main(void) {
+    int failed = 0;
+
+    host_init();
+    host_set_color_active(false);
+    make_sn76489_track(0);
+    make_dmg_track(8UL << 16);
+
+    failed |= run("SN76489", 0, check_sn76489);
+    failed |= run("DMG", 8, check_dmg);
+    return failed;
+}
@@ -0,0 +1,314 @@
+/**
+ * Copyright (c) 2026 Adrian Siekierka
+ *
+ * swanshell is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * swanshell is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with swanshell. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// XMODEM uploads (xmodem.c) from a fake sender, through a fake MCU CDC
+// endpoint with a simulated clock. Checks the received data in PSRAM and
+// in the staged file, with CRC-16 and checksum senders, 1K and 128-byte
+// blocks, and corrupted blocks. Then compares the throughput of 1K and
+// 128-byte blocks for a 1 MB upload, at several USB round trip times.
+//
+// The link model is simple: every CDC command costs a fixed time plus a
+// time per byte, the sender answers a control byte after the round trip
+// time, and sends at the USB rate. The receiver's CRC-16 and checksum
+// kernels are charged their V30MZ clocks per byte.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include <nile.h>
+#include "xmodem.c"
+
+#define MCU_COMMAND_NS 100000
+#define MCU_BYTE_NS 1300
+#define USB_BYTE_NS 1000
+// 28 and 3 clocks per byte at 3.072 MHz
+#define CRC16_BYTE_NS 9115
+#define CHECKSUM_BYTE_NS 977
+#define VBLANK_NS 13250000
+
+#define BANK 4
+#define MAX_SIZE (2UL * 1024 * 1024)
+
+volatile uint16_t vbl_ticks;
+settings_t settings;
+bool mcu_native_mode = true;
+
+static uint64_t now_ns;
+
+static void advance(uint64_t ns) {
+    now_ns += ns;
+    vbl_ticks = now_ns / VBLANK_NS;
+}
+
+bool nile_spi_set_control(uint16_t value) {
+    return true;
+}
+
+void mcu_native_enter_speed(uint16_t speed) {
+}
+
+void mcu_native_exit_speed(void) {
+}
+
+void bootstub_resident_invalidate(uint16_t bank, uint16_t bank_end) {
+}
+
+uint8_t asset_heap_get_free_first_banks(void) {
+    return BANK + (MAX_SIZE >> 16) + 1;
+}
+
+uint8_t xmodem_checksum(uint8_t *data) {
+    uint8_t sum = 0;
+    for (int i = 0; i < CHUNK_SIZE; i++)
+        sum += data[i];
+    advance(CHUNK_SIZE * CHECKSUM_BYTE_NS);
+    return sum;
+}
+
+uint16_t xmodem_crc16(uint16_t crc, const uint8_t *data, uint16_t len) {
+    advance((uint64_t) len * CRC16_BYTE_NS);
+    while (len--) {
+        crc ^= *(data++) << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+    return crc;
+}
+
+// Staged file
+static uint8_t *file_out;
+static uint32_t file_out_len;
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    memcpy(file_out + file_out_len, buff, btw);
+    file_out_len += btw;
+    *bw = btw;
+    return FR_OK;
+}
+
+// Sender
+static struct {
+    const uint8_t *data;
+    uint32_t len, pos, block_len;
+    uint8_t idx;
+    int crc; // -1 until the receiver's first request
+    bool supports_crc, use_1k, eot_sent;
+    int corrupt_every;
+    uint64_t round_trip_ns;
+
+    // bytes in flight, and when each becomes available to the MCU
+    uint8_t queue[1100];
+    uint64_t queue_time[1100];
+    uint16_t head, tail;
+} tx;
+
+static struct {
+    unsigned long blocks, naks, round_trips, commands, wire_bytes;
+} stats;
+
+static void send_bytes(const uint8_t *buf, uint16_t len) {
+    uint64_t t = now_ns + tx.round_trip_ns;
+    tx.head = tx.tail = 0;
+    for (uint16_t i = 0; i < len; i++) {
+        tx.queue[tx.tail] = buf[i];
+        tx.queue_time[tx.tail++] = t + (uint64_t) i * USB_BYTE_NS;
+    }
+    stats.round_trips++;
+    stats.wire_bytes += len;
+}
+
+static void send_block(void) {
+    uint8_t buf[1029];
+    uint16_t n = 0;
+
+    if (tx.pos >= tx.len) {
+        buf[0] = EOT;
+        tx.eot_sent = true;
+        send_bytes(buf, 1);
+        return;
+    }
+
+    tx.block_len = (tx.use_1k && tx.len - tx.pos > 896) ? 1024 : 128;
+    buf[n++] = tx.block_len == 1024 ? STX : SOH;
+    buf[n++] = tx.idx;
+    buf[n++] = ~tx.idx;
+    for (uint32_t i = 0; i < tx.block_len; i++)
+        buf[n++] = tx.pos + i < tx.len ? tx.data[tx.pos + i] : 0x1A;
+    if (tx.crc) {
+        uint16_t crc = 0;
+        for (uint32_t i = 0; i < tx.block_len; i++) {
+            crc ^= buf[3 + i] << 8;
+            for (int j = 0; j < 8; j++)
+                crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+        buf[n++] = crc >> 8;
+        buf[n++] = crc;
+    } else {
+        uint8_t sum = 0;
+        for (uint32_t i = 0; i < tx.block_len; i++)
+            sum += buf[3 + i];
+        buf[n++] = sum;
+    }
+    stats.blocks++;
+    if (tx.corrupt_every && !(stats.blocks % tx.corrupt_every))
+        buf[3 + (stats.blocks % tx.block_len)] ^= 0x55;
+    send_bytes(buf, n);
+}
+
+static void sender_receive(uint8_t c) {
+    if (tx.crc < 0) {
+        if (c == CRC && !tx.supports_crc)
+            return;
+        tx.crc = c == CRC;
+        send_block();
+    } else if (c == ACK) {
+        if (tx.eot_sent) {
+            tx.head = tx.tail = 0;
+            return;
+        }
+        tx.pos += tx.block_len;
+        tx.idx++;
+        send_block();
+    } else if (c == NAK) {
+        stats.naks++;
+        if (tx.eot_sent) {
+            uint8_t eot = EOT;
+            send_bytes(&eot, 1);
+        } else {
+            send_block();
+        }
+    }
+}
+
+bool nile_mcu_native_cdc_clear_sync(void) {
+    return true;
+}
+
+int16_t nile_mcu_native_cdc_read_sync(void *buffer, uint16_t buflen) {
+    uint16_t n = 0;
+    stats.commands++;
+    advance(MCU_COMMAND_NS);
+    while (n < buflen && tx.head < tx.tail && tx.queue_time[tx.head] <= now_ns)
+        ((uint8_t*) buffer)[n++] = tx.queue[tx.head++];
+    advance((uint64_t) n * MCU_BYTE_NS);
+    return n;
+}
+
+int16_t nile_mcu_native_cdc_write_sync(const void *buffer, uint16_t buflen) {
+    stats.commands++;
+    advance(MCU_COMMAND_NS + (uint64_t) buflen * MCU_BYTE_NS);
+    for (uint16_t i = 0; i < buflen; i++)
+        sender_receive(((const uint8_t*) buffer)[i]);
+    return buflen;
+}
+
+static const void *async_buffer;
+static uint16_t async_buflen;
+
+bool nile_mcu_native_cdc_write_async_start(const void *buffer, uint16_t buflen) {
+    async_buffer = buffer;
+    async_buflen = buflen;
+    return true;
+}
+
+int16_t nile_mcu_native_cdc_write_async_finish(void) {
+    return nile_mcu_native_cdc_write_sync(async_buffer, async_buflen);
+}
+
+static uint8_t *source;
+
+static bool upload(uint32_t len, bool supports_crc, bool use_1k, int corrupt_every, bool to_file, uint64_t round_trip_ns) {
+    if (!to_file) {
+        // PSRAM uploads are trimmed to the ROM footer
+        memset(source + len - 16, 0, 16);
+        source[len - 16] = 0xEA;
+    }
+
+    memset(&tx, 0, sizeof(tx));
+    memset(&stats, 0, sizeof(stats));
+    tx.data = source;
+    tx.len = len;
+    tx.idx = 1;
+    tx.crc = -1;
+    tx.supports_crc = supports_crc;
+    tx.use_1k = use_1k;
+    tx.corrupt_every = corrupt_every;
+    tx.round_trip_ns = round_trip_ns;
+    memset(host_psram, 0, MAX_SIZE + (BANK << 16));
+    file_out_len = 0;
+    now_ns = 0;
+    advance(0);
+
+    uint32_t size;
+    FIL fp = {0};
+    int result = to_file ? xmodem_recv_to_file(&fp, BANK, len, &size) : xmodem_recv_to_psram(BANK, &size);
+    const uint8_t *received = to_file ? file_out : host_psram + (BANK << 16);
+    if (result || size != len || (to_file && file_out_len != len) || memcmp(received, source, len)
+        || tx.crc != supports_crc) {
+        printf("FAIL: %lu bytes, %s, %s blocks, %s: result %d, size %lu\n", (unsigned long) len,
+            supports_crc ? "CRC-16" : "checksum", use_1k ? "1K" : "128-byte", to_file ? "file" : "PSRAM",
+            result, (unsigned long) size);
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    bool ok = true;
+
+    host_init();
+    source = malloc(MAX_SIZE);
+    file_out = malloc(MAX_SIZE);
+    for (uint32_t i = 0; i < MAX_SIZE; i++)
+        source[i] = rand();
+
+    for (int to_file = 0; to_file < 2; to_file++) {
+        ok &= upload(131072, true, true, 0, to_file, 1000000);
+        ok &= upload(131072 - 1280, true, true, 0, to_file, 1000000);
+        ok &= upload(131072, true, false, 0, to_file, 1000000);
+        ok &= upload(131072, false, false, 0, to_file, 1000000);
+        ok &= upload(100000, false, true, 0, to_file, 1000000);
+        ok &= upload(200000, true, true, 7, to_file, 1000000);
+        ok &= upload(100000, false, true, 5, to_file, 1000000);
+    }
+    if (!ok)
+        return 1;
+    printf("PSRAM and file uploads: CRC-16 and checksum, 1K and 128-byte blocks, corrupted blocks\n");
+
+    static const struct {
+        const char *name;
+        bool crc, use_1k;
+    } modes[] = {
+        { "128-byte, checksum", false, false },
+        { "128-byte, CRC-16", true, false },
+        { "1K, CRC-16", true, true },
+    };
+    static const uint32_t round_trips_us[] = { 1000, 4000 };
+
+    for (int r = 0; r < 2; r++) {
+        printf("1 MB upload, %u ms round trip:\n", round_trips_us[r] / 1000);
+        for (int m = 0; m < 3; m++) {
+            if (!upload(1048576, modes[m].crc, modes[m].use_1k, 0, true, round_trips_us[r] * 1000ULL))
+                return 1;
+            printf("  %-20s %5lu round trips, %5lu MCU commands, %7lu bytes sent: %5.1f s, %5.1f KB/s\n",
+                modes[m].name, stats.round_trips, stats.commands, stats.wire_bytes,
+                now_ns / 1e9, 1048576 / 1024.0 / (now_ns / 1e9));
+        }
+    }
+    return 0;
+}
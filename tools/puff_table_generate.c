@@ -32,6 +32,9 @@
 #define MAXCODES (MAXLCODES+MAXDCODES)  /* maximum codes lengths to read */
 #define FIXLCODES 288           /* number of fixed literal/length codes */
 
+#define FASTLBITS 9             /* must match puff.c */
+#define FASTDBITS 7
+
 struct huffman {
     short *count;       /* number of symbols of each length */
     short *symbol;      /* canonically ordered symbols */
@@ -40,6 +43,7 @@ struct huffman {
 struct huffman_state {
     short lencnt[MAXBITS+1], lensym[FIXLCODES];
     short distcnt[MAXBITS+1], distsym[MAXDCODES];
+    unsigned short lenfast[1 << FASTLBITS], distfast[1 << FASTDBITS];
     struct huffman lencode, distcode;
 };
 
@@ -84,6 +88,44 @@ int construct(struct huffman *h, const short *length, int n)
     return left;
 }
 
+void construct_fast(struct huffman *h, unsigned short *fast, int fastbits)
+{
+    int len;            /* current code length */
+    int count;          /* codes of length len left to add */
+    int index;          /* index of current symbol in h->symbol[] */
+    int code;           /* current code */
+    int i;              /* bit index */
+    unsigned rev;       /* current code, reversed */
+    unsigned size;      /* number of entries in fast[] */
+
+    size = 1 << fastbits;
+    for (rev = 0; rev < size; rev++)
+        fast[rev] = 0;
+
+    code = index = 0;
+    for (len = 1; len <= fastbits; len++) {
+        for (count = h->count[len]; count > 0; count--) {
+            rev = 0;
+            for (i = 0; i < len; i++)
+                rev |= ((code >> i) & 1) << (len - 1 - i);
+            for (; rev < size; rev += 1 << len)
+                fast[rev] = (len << 12) | h->symbol[index];
+            index++;
+            code++;
+        }
+        code <<= 1;
+    }
+}
+
+static void print_ushort_array(const char *name, unsigned short *array, int length) {
+    printf("static const unsigned short __far fixed_%s[] = { ", name);
+    for (int i = 0; i < length; i++) {
+        if (i > 0) printf(", ");
+        printf("%u", array[i]);
+    }
+    printf(" };\n");
+}
+
 static void print_short_array(const char *name, short *array, int length) {
     printf("static const short __far fixed_%s[] = { ", name);
     for (int i = 0; i < length; i++) {
@@ -115,15 +157,19 @@ int main(void) {
     for (; symbol < FIXLCODES; symbol++)
         lengths[symbol] = 8;
     construct(&s.lencode, lengths, FIXLCODES);
+    construct_fast(&s.lencode, s.lenfast, FASTLBITS);
 
     /* distance table */
     for (symbol = 0; symbol < MAXDCODES; symbol++)
         lengths[symbol] = 5;
     construct(&s.distcode, lengths, MAXDCODES);
+    construct_fast(&s.distcode, s.distfast, FASTDBITS);
 
     /* print values */
     print_short_array("lencnt", s.lencnt, MAXBITS+1);
     print_short_array("lensym", s.lensym, FIXLCODES);
     print_short_array("distcnt", s.distcnt, MAXBITS+1);
     print_short_array("distsym", s.distsym, MAXDCODES);
+    print_ushort_array("lenfast", s.lenfast, 1 << FASTLBITS);
+    print_ushort_array("distfast", s.distfast, 1 << FASTDBITS);
 }
@@ -0,0 +1,201 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Helpers shared by the host-side USB shell tools: issuing commands, reading
+# their output, and XMODEM transfers.
+
+import re
+
+SOH = b"\x01"
+STX = b"\x02"
+EOT = b"\x04"
+ACK = b"\x06"
+NAK = b"\x15"
+CAN = b"\x18"
+CRC = b"C"
+
+# Block size of the "hash" and "sync" commands.
+BLOCK_SIZE = 65536
+
+def crc16(data):
+	crc = 0
+	for b in data:
+		crc ^= b << 8
+		for i in range(8):
+			crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+			crc &= 0xFFFF
+	return crc
+
+def is_numeric(line):
+	return re.match(r"\s*-?[0-9]", line) is not None
+
+def read_response(port, is_output=is_numeric):
+	# Output follows the echoed command line and ends with an empty line.
+	# Error messages are not followed by an empty line, so output ends after
+	# any first line which is_output() does not accept.
+	lines = []
+	line = b""
+	started = False
+	while True:
+		c = port.read(1)
+		if not c:
+			raise TimeoutError("no response from shell")
+		if c != b"\n":
+			line += c
+			continue
+		line = line.rstrip(b"\r").decode("utf-8", "replace")
+		if started and (not line or line.startswith(">")):
+			return lines
+		if started:
+			lines.append(line)
+			if len(lines) == 1 and not is_output(line):
+				return lines
+		started = True
+		line = b""
+
+def send_command(port, *args):
+	port.write((" ".join(args) + "\r").encode("utf-8"))
+
+def quote(path):
+	return '"' + path + '"'
+
+def read_line(port):
+	line = b""
+	while not line.endswith(b"\n"):
+		c = port.read(1)
+		if not c:
+			raise TimeoutError("no response from shell")
+		line += c
+	return line
+
+def xmodem_send(port, data, block_size=1024, checksum_only=False, cancel_after=None):
+	# A checksum_only sender ignores CRC-16 mode requests and waits for a NAK.
+	# With cancel_after, the transfer is cancelled after that many blocks.
+	while True:
+		c = port.read(1)
+		if not c:
+			raise TimeoutError("receiver did not start the transfer")
+		if c == NAK or (c == CRC and not checksum_only):
+			break
+	use_crc = c == CRC
+
+	idx = 1
+	pos = 0
+	while pos < len(data):
+		if cancel_after is not None and idx > cancel_after:
+			port.write(CAN + CAN)
+			return
+		size = 1024 if use_crc and block_size == 1024 and len(data) - pos > 896 else 128
+		block = data[pos:pos+size].ljust(size, b"\x1A")
+		packet = (STX if size == 1024 else SOH) + bytes([idx & 0xFF, 0xFF - (idx & 0xFF)]) + block
+		if use_crc:
+			packet += crc16(block).to_bytes(2, "big")
+		else:
+			packet += bytes([sum(block) & 0xFF])
+		while True:
+			port.write(packet)
+			c = port.read(1)
+			if c == ACK:
+				break
+			if c == CAN:
+				raise IOError("transfer cancelled by receiver")
+			if not c:
+				raise TimeoutError("block %d not acknowledged" % idx)
+		pos += size
+		idx += 1
+
+	while True:
+		port.write(EOT)
+		if port.read(1) == ACK:
+			break
+
+def xmodem_recv(port, use_crc=True, repeat_start=0):
+	# Receives 128-byte blocks. With repeat_start, the first block is dropped
+	# that many times, and the start request repeated, as by a receiver
+	# which missed it.
+	start = CRC if use_crc else NAK
+	port.write(start)
+	data = bytearray()
+	idx = 1
+	while True:
+		c = port.read(1)
+		if not c:
+			raise TimeoutError("sender did not respond")
+		if c == EOT:
+			port.write(ACK)
+			return bytes(data)
+		if c == CAN:
+			raise IOError("transfer cancelled by sender")
+		if c != SOH:
+			continue
+		packet = port.read(2 + 128 + (2 if use_crc else 1))
+		block = packet[2:130]
+		if use_crc:
+			valid = len(packet) == 132 and crc16(block) == int.from_bytes(packet[130:], "big")
+		else:
+			valid = len(packet) == 131 and sum(block) & 0xFF == packet[130]
+		if not valid or packet[0] != 0xFF - packet[1]:
+			port.write(NAK)
+		elif packet[0] == (idx - 1) & 0xFF:
+			# Our ACK was lost; the block was repeated.
+			port.write(ACK)
+		elif packet[0] != idx & 0xFF:
+			port.write(CAN)
+			raise IOError("expected block %d, got %d" % (idx & 0xFF, packet[0]))
+		elif idx == 1 and repeat_start:
+			repeat_start -= 1
+			port.write(start)
+		else:
+			data += block
+			idx += 1
+			port.write(ACK)
+
+def upload(port, data, remote_path, **kwargs):
+	send_command(port, "upload", quote(remote_path))
+	# Skip the echoed command line, which may contain a 'C'.
+	read_line(port)
+	xmodem_send(port, data, **kwargs)
+	errors = read_response(port)
+	if errors:
+		raise IOError(" ".join(errors))
+
+def sync_blocks(port, remote_path, size, start, data):
+	# Writes data from block number start onwards, then truncates the file
+	# to size.
+	count = (len(data) + BLOCK_SIZE - 1) // BLOCK_SIZE
+	send_command(port, "sync", quote(remote_path), str(size), str(start), str(count))
+	read_line(port)
+	xmodem_send(port, data)
+	errors = read_response(port)
+	if errors:
+		raise IOError(" ".join(errors))
+
+def put(port, data, remote_path):
+	# upload can only guess the end of the last XMODEM block from a ROM
+	# footer; sync truncates the file to its exact size instead.
+	if data:
+		sync_blocks(port, remote_path, len(data), 0, data)
+	else:
+		upload(port, data, remote_path)
+
+def download(port, remote_path, use_crc=True, repeat_start=0):
+	# The data is padded with zeroes to a multiple of 128 bytes.
+	send_command(port, "download", quote(remote_path))
+	data = xmodem_recv(port, use_crc, repeat_start)
+	# Only the prompt follows a successful transfer.
+	line = read_line(port)
+	if line.strip():
+		raise IOError(line.strip().decode("utf-8", "replace"))
+	return data
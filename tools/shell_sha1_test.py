@@ -0,0 +1,77 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Checks the USB shell's "sha1" command, and with it the V30 assembly
+# SHA1_Transform(), against the FIPS 180 test vectors and Python's hashlib.
+# Each message is uploaded to the storage card, then hashed on the device.
+#
+# Usage: shell_sha1_test.py <serial port> [remote directory]
+
+import argparse, hashlib, random, re, sys
+from shell_client import read_response, send_command, quote, put
+
+# FIPS 180-1 and 180-2 examples.
+FIPS_VECTORS = (
+	(b"", "da39a3ee5e6b4b0d3255bfef95601890afd80709"),
+	(b"abc", "a9993e364706816aba3e25717850c26c9cd0d89d"),
+	(b"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1"),
+	(b"a" * 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f"),
+)
+
+def is_digest(line):
+	return re.fullmatch(r"[0-9a-f]{40}", line) is not None
+
+def remote_sha1(port, path):
+	send_command(port, "sha1", quote(path))
+	lines = read_response(port, is_digest)
+	if not lines or not is_digest(lines[0]):
+		raise IOError(" ".join(lines))
+	return lines[0]
+
+def messages():
+	for data, digest in FIPS_VECTORS:
+		yield data, digest
+	# Lengths around the padding and block boundaries, and past the 64 KB
+	# blocks in which the shell reads files.
+	rng = random.Random(1)
+	for length in (55, 56, 63, 64, 65, 119, 120, 4095, 4096, 4097, 65535, 65536, 65537, 200000):
+		data = bytes(rng.getrandbits(8) for _ in range(length))
+		yield data, hashlib.sha1(data).hexdigest()
+
+if __name__ == "__main__":
+	import serial
+
+	parser = argparse.ArgumentParser(description="Check the swanshell USB shell's sha1 command against the FIPS 180 test vectors.")
+	parser.add_argument("port", help="serial port, such as /dev/ttyACM0")
+	parser.add_argument("remote", nargs="?", default="/", help="directory for the test files on the storage card")
+	args = parser.parse_args()
+
+	failures = 0
+	count = 0
+	with serial.Serial(args.port, timeout=60) as port:
+		for data, digest in messages():
+			assert hashlib.sha1(data).hexdigest() == digest
+			path = args.remote.rstrip("/") + "/SHA1TEST.BIN"
+			put(port, data, path)
+			got = remote_sha1(port, path)
+			count += 1
+			if got != digest:
+				failures += 1
+				print("FAIL %d bytes: got %s, expected %s" % (len(data), got, digest))
+		send_command(port, "rm", quote(path))
+		read_response(port)
+
+	print("%d of %d messages passed" % (count - failures, count))
+	sys.exit(1 if failures else 0)
@@ -0,0 +1,78 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Reference client for the USB shell's "hash" and "sync" commands: uploads
+# only the 64 KB blocks of a file which differ from the copy on the storage
+# card.
+#
+# Usage: shell_sync.py [--dry-run] <serial port> <local file> <remote path>
+
+import argparse, sys, zlib
+from shell_client import BLOCK_SIZE, is_numeric, read_response, send_command, quote, sync_blocks
+
+def block_checksum(data):
+	# Matches the "hash" command.
+	return zlib.crc32(data)
+
+def remote_hash(port, path):
+	send_command(port, "hash", quote(path))
+	lines = read_response(port)
+	if not lines or not is_numeric(lines[0]):
+		return None
+	return int(lines[0].split()[0]), [int(l, 16) for l in lines[1:]]
+
+def changed_runs(local_sums, local_size, remote):
+	remote_size, remote_sums = remote if remote else (0, [])
+	changed = [i >= len(remote_sums) or remote_sums[i] != s for i, s in enumerate(local_sums)]
+	# The final block also carries the new file size.
+	if local_size != remote_size and changed:
+		changed[-1] = True
+	runs = []
+	for i, c in enumerate(changed):
+		if not c:
+			continue
+		if runs and runs[-1][0] + runs[-1][1] == i:
+			runs[-1][1] += 1
+		else:
+			runs.append([i, 1])
+	return runs
+
+def sync(port, local_data, remote_path, dry_run=False):
+	local_sums = [block_checksum(local_data[i:i+BLOCK_SIZE]) for i in range(0, len(local_data), BLOCK_SIZE)]
+	runs = changed_runs(local_sums, len(local_data), remote_hash(port, remote_path))
+	for start, count in runs:
+		print("blocks %d-%d" % (start, start + count - 1), file=sys.stderr)
+		if dry_run:
+			continue
+		sync_blocks(port, remote_path, len(local_data), start, local_data[start*BLOCK_SIZE:(start+count)*BLOCK_SIZE])
+	return runs
+
+if __name__ == "__main__":
+	import serial
+
+	parser = argparse.ArgumentParser(description="Upload changed blocks of a file via the swanshell USB shell.")
+	parser.add_argument("--dry-run", action="store_true", help="only list the blocks which would be uploaded")
+	parser.add_argument("port", help="serial port, such as /dev/ttyACM0")
+	parser.add_argument("local", help="local file")
+	parser.add_argument("remote", help="path on the storage card")
+	args = parser.parse_args()
+
+	with open(args.local, "rb") as fp:
+		local_data = fp.read()
+	if not local_data:
+		sys.exit("empty files are not supported; use upload instead")
+	with serial.Serial(args.port, timeout=30) as port:
+		runs = sync(port, local_data, args.remote, args.dry_run)
+	print("%d of %d blocks uploaded" % (sum(c for s, c in runs), (len(local_data) + BLOCK_SIZE - 1) // BLOCK_SIZE), file=sys.stderr)
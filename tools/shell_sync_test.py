@@ -0,0 +1,88 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Tests the USB shell's "hash" and "sync" commands. Each case writes a file,
+# changes it with shell_sync.sync(), and checks that only the changed blocks
+# were sent, that the file's SHA-1 matches, and that "hash" prints the
+# zlib.crc32() of every block.
+#
+# Usage: shell_sync_test.py <serial port> [remote directory]
+
+import argparse, hashlib, random, sys
+from shell_client import BLOCK_SIZE, put, read_response, send_command, quote
+from shell_sha1_test import remote_sha1
+from shell_sync import block_checksum, remote_hash, sync
+
+def balanced_change(data, pos):
+	# Adds 1, -2 and 1 to three consecutive 16-bit words. This leaves both
+	# sums of a Fletcher checksum over words unchanged.
+	data = bytearray(data)
+	for i, delta in enumerate((1, -2, 1)):
+		word = (int.from_bytes(data[pos+i*2:pos+i*2+2], "little") + delta) & 0xFFFF
+		data[pos+i*2:pos+i*2+2] = word.to_bytes(2, "little")
+	return bytes(data)
+
+def flip(data, *positions):
+	data = bytearray(data)
+	for pos in positions:
+		data[pos] ^= 0xFF
+	return bytes(data)
+
+def cases(rng):
+	base = bytes(rng.getrandbits(8) for _ in range(5 * BLOCK_SIZE + 4321))
+	# description, old data, new data, expected runs
+	yield "unchanged", base, base, []
+	yield "one byte", base, flip(base, 2 * BLOCK_SIZE + 7), [[2, 1]]
+	yield "two runs", base, flip(base, 10, BLOCK_SIZE, 4 * BLOCK_SIZE + 99), [[0, 2], [4, 1]]
+	yield "balanced word change", base, balanced_change(base, 3 * BLOCK_SIZE + 100), [[3, 1]]
+	yield "truncated", base, base[:3 * BLOCK_SIZE + 1], [[3, 1]]
+	yield "truncated at a block boundary", base, base[:3 * BLOCK_SIZE], [[2, 1]]
+	yield "extended", base[:2 * BLOCK_SIZE + 5], base, [[2, 4]]
+	yield "odd length", base[:BLOCK_SIZE + 3], flip(base[:BLOCK_SIZE + 3], BLOCK_SIZE + 2), [[1, 1]]
+
+if __name__ == "__main__":
+	import serial
+
+	parser = argparse.ArgumentParser(description="Test the swanshell USB shell's hash and sync commands.")
+	parser.add_argument("port", help="serial port, such as /dev/ttyACM0")
+	parser.add_argument("remote", nargs="?", default="/", help="directory for the test file on the storage card")
+	args = parser.parse_args()
+
+	path = args.remote.rstrip("/") + "/SYNCTEST.BIN"
+	failures = 0
+	tests = 0
+	with serial.Serial(args.port, timeout=60) as port:
+		for description, old, new, expected in cases(random.Random(1)):
+			tests += 1
+			put(port, old, path)
+			runs = sync(port, new, path)
+			if runs != expected:
+				failures += 1
+				print("FAIL %s: sent blocks %s, expected %s" % (description, runs, expected))
+				continue
+			if remote_sha1(port, path) != hashlib.sha1(new).hexdigest():
+				failures += 1
+				print("FAIL %s: file differs" % description)
+				continue
+			sums = [block_checksum(new[i:i+BLOCK_SIZE]) for i in range(0, len(new), BLOCK_SIZE)]
+			if remote_hash(port, path) != (len(new), sums):
+				failures += 1
+				print("FAIL %s: hash output differs" % description)
+
+		send_command(port, "rm", quote(path))
+		read_response(port)
+
+	print("%d of %d cases passed" % (tests - failures, tests))
+	sys.exit(1 if failures else 0)
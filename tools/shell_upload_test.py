@@ -0,0 +1,92 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Tests that the USB shell's "upload" command only replaces a file once the
+# transfer has completed. A cancelled upload must leave the existing file,
+# or the absence of one, unchanged, and must not leave its temporary file
+# behind.
+#
+# Usage: shell_upload_test.py <serial port> [remote directory]
+
+import argparse, hashlib, random, sys
+from shell_client import put, read_response, send_command, quote, upload
+from shell_sha1_test import remote_sha1
+from shell_xmodem_test import make_data
+
+def remote_exists(port, path):
+	try:
+		remote_sha1(port, path)
+		return True
+	except IOError:
+		return False
+
+def remove(port, path):
+	send_command(port, "rm", quote(path))
+	read_response(port)
+
+def cancelled_upload(port, data, path):
+	try:
+		upload(port, data, path, cancel_after=3)
+	except IOError:
+		return True
+	return False
+
+if __name__ == "__main__":
+	import serial
+
+	parser = argparse.ArgumentParser(description="Test replacing files with the swanshell USB shell's upload command.")
+	parser.add_argument("port", help="serial port, such as /dev/ttyACM0")
+	parser.add_argument("remote", nargs="?", default="/", help="directory for the test file on the storage card")
+	args = parser.parse_args()
+
+	rng = random.Random(1)
+	path = args.remote.rstrip("/") + "/UPLDTEST.BIN"
+	tmp_path = path + ".TMP"
+	old = make_data(rng, 40 * 1024)
+	new = make_data(rng, 60 * 1024)
+	failures = []
+
+	with serial.Serial(args.port, timeout=60) as port:
+		remove(port, path)
+		if not cancelled_upload(port, new, path):
+			failures.append("cancelled upload of a new file reported success")
+		if remote_exists(port, path):
+			failures.append("cancelled upload of a new file created it")
+
+		put(port, old, path)
+		if not cancelled_upload(port, new, path):
+			failures.append("cancelled upload over a file reported success")
+		if not remote_exists(port, path) or remote_sha1(port, path) != hashlib.sha1(old).hexdigest():
+			failures.append("cancelled upload over a file changed it")
+		if remote_exists(port, tmp_path):
+			failures.append("cancelled upload left its temporary file")
+
+		upload(port, new, path)
+		if remote_sha1(port, path) != hashlib.sha1(new).hexdigest():
+			failures.append("upload over a file did not replace it")
+		if remote_exists(port, tmp_path):
+			failures.append("upload left its temporary file")
+
+		remove(port, path)
+		upload(port, old, path)
+		if remote_sha1(port, path) != hashlib.sha1(old).hexdigest():
+			failures.append("upload of a new file did not create it")
+
+		remove(port, path)
+
+	for failure in failures:
+		print("FAIL " + failure)
+	print("%d failures" % len(failures))
+	sys.exit(1 if failures else 0)
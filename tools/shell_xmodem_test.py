@@ -0,0 +1,110 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Loopback test of the XMODEM sender and receiver, through the USB shell's
+# "upload" and "download" commands. Uploads use 1024-byte blocks, 128-byte
+# blocks, a checksum-only sender, and corrupted blocks; each file is checked
+# with the "sha1" command. Downloads use CRC-16 and checksum mode, and a
+# receiver which repeats its CRC-16 request after missing the first block.
+#
+# Usage: shell_xmodem_test.py <serial port> [remote directory]
+
+import argparse, hashlib, random, sys
+from shell_client import download, put, read_response, send_command, quote, upload
+from shell_sha1_test import remote_sha1
+
+class CorruptingPort:
+	# Flips a byte of every nth block the first time it is sent.
+	def __init__(self, port, n):
+		self.port = port
+		self.n = n
+		self.count = 0
+		self.corrupted = set()
+
+	def read(self, size=1):
+		return self.port.read(size)
+
+	def write(self, data):
+		if len(data) > 128:
+			self.count += 1
+			if self.count % self.n == 0 and data not in self.corrupted:
+				self.corrupted.add(data)
+				data = bytearray(data)
+				data[3 + self.count % 128] ^= 0x55
+		return self.port.write(data)
+
+def make_data(rng, size):
+	data = bytearray(rng.getrandbits(8) for _ in range(size))
+	# upload trims the data after a ROM footer in its last 144 bytes, so
+	# avoid anything which looks like one.
+	for i in range(max(0, size - 144), size):
+		if data[i] == 0xEA:
+			data[i] = 0
+	return bytes(data)
+
+UPLOADS = (
+	# size, description, upload() arguments, corrupt every nth block
+	(300 * 1024, "1024-byte blocks", {}, 0),
+	(20 * 1024 + 256, "128-byte blocks", {"block_size": 128}, 0),
+	(4096, "checksum-only sender", {"checksum_only": True}, 0),
+	(100 * 1024 + 384, "1024-byte blocks, every 7th corrupted", {}, 7),
+	(10 * 1024, "128-byte blocks, every 5th corrupted", {"block_size": 128}, 5),
+)
+
+DOWNLOADS = (
+	# size, description, download() arguments
+	(300 * 1024 + 77, "CRC-16", {}),
+	(10 * 1024 + 1, "checksum", {"use_crc": False}),
+	(5000, "CRC-16, first block missed", {"repeat_start": 1}),
+	(128, "CRC-16, first block missed twice", {"repeat_start": 2}),
+	(0, "empty file", {}),
+)
+
+if __name__ == "__main__":
+	import serial
+
+	parser = argparse.ArgumentParser(description="Test XMODEM transfers through the swanshell USB shell.")
+	parser.add_argument("port", help="serial port, such as /dev/ttyACM0")
+	parser.add_argument("remote", nargs="?", default="/", help="directory for the test file on the storage card")
+	args = parser.parse_args()
+
+	rng = random.Random(1)
+	path = args.remote.rstrip("/") + "/XMODTEST.BIN"
+	failures = 0
+	tests = 0
+	with serial.Serial(args.port, timeout=60) as port:
+		for size, description, kwargs, corrupt in UPLOADS:
+			data = make_data(rng, size)
+			upload(CorruptingPort(port, corrupt) if corrupt else port, data, path, **kwargs)
+			got = remote_sha1(port, path)
+			tests += 1
+			if got != hashlib.sha1(data).hexdigest():
+				failures += 1
+				print("FAIL upload, %s, %d bytes" % (description, size))
+
+		for size, description, kwargs in DOWNLOADS:
+			data = make_data(rng, size)
+			put(port, data, path)
+			got = download(port, path, **kwargs)
+			tests += 1
+			if got != data.ljust((size + 127) & ~127, b"\0"):
+				failures += 1
+				print("FAIL download, %s, %d bytes: got %d bytes" % (description, size, len(got)))
+
+		send_command(port, "rm", quote(path))
+		read_response(port)
+
+	print("%d of %d transfers passed" % (tests - failures, tests))
+	sys.exit(1 if failures else 0)
@@ -0,0 +1,114 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2026 Adrian Siekierka
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+# CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+# CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+# Checks the 16.16 fixed-point frequency divider ratios used by the SN76489
+# and DMG VGM drivers (vgm_divider_ratio() and vgm_divider() in
+# src/menu/plugin/vgm) against the exact result, for every register value.
+# The old code's 32-bit signed division is also evaluated, to show where it
+# differed from the exact result.
+#
+# Chip clocks are taken from the headers of the given .vgm/.vgz files; a
+# set of common clocks is checked if no files are given.
+#
+# Usage: vgm_divider_check.py [file.vgm ...]
+
+import gzip, struct, sys
+
+SN76489_CLOCKS = (3579545, 3546893, 4000000, 1789772, 3072000)
+DMG_CLOCKS = (4194304, 8388608)
+
+def u16(x):
+	return x & 0xFFFF
+
+def u32(x):
+	return x & 0xFFFFFFFF
+
+def vgm_divider_ratio(num, den):
+	if not den:
+		return 0
+	result = num // den
+	rem = num % den
+	for i in range(2):
+		rem = u32(rem << 8)
+		result = u32((result << 8) | (rem // den))
+		rem %= den
+	return result
+
+def vgm_divider(ratio, value):
+	# 16-bit int arithmetic, as on the V30.
+	return u16(u16((ratio >> 16) * value) + u16(((ratio & 0xFFFF) * value) >> 16))
+
+def old_divider(num, value, den):
+	# (num##L * value) / den, with 32-bit signed long arithmetic.
+	product = u32(num * value)
+	if product & 0x80000000:
+		product -= 1 << 32
+	return u16(int(product / den)) if den else None
+
+def check(name, num, den, values):
+	ratio = vgm_divider_ratio(num, den)
+	worst_new = 0
+	worst_old = 0
+	for value in values:
+		exact = num * value // den
+		if exact > 0xFFFF:
+			continue
+		worst_new = max(worst_new, abs(vgm_divider(ratio, value) - exact))
+		worst_old = max(worst_old, abs(old_divider(num, value, den) - exact))
+	print("%-34s ratio %08x: max error %d (old 32-bit division: %d)" % (name, ratio, worst_new, worst_old))
+	return worst_new <= 1
+
+def check_sn76489(clock, flags):
+	ok = True
+	shifts = (4, 8) if flags & 0x08 else (1, 5)
+	# Tone 0 is played as 0x400; noise uses 0x10, 0x20, 0x40 or tone 2.
+	ok &= check("SN76489 %d flags %02x tone" % (clock, flags), 3072000, clock >> shifts[0], range(1, 0x401))
+	ok &= check("SN76489 %d flags %02x noise" % (clock, flags), 3072000, clock >> shifts[1], range(1, 0x401))
+	return ok
+
+def check_dmg(clock):
+	return check("DMG %d period" % clock, 1536000, clock >> 2, range(1, 2049))
+
+def read_header(path):
+	with open(path, "rb") as fp:
+		data = fp.read(0x100)
+	if data[:2] == b"\x1f\x8b":
+		with gzip.open(path, "rb") as fp:
+			data = fp.read(0x100)
+	if data[:4] != b"Vgm ":
+		raise ValueError("%s: not a VGM file" % path)
+	return data.ljust(0x100, b"\0")
+
+if __name__ == "__main__":
+	ok = True
+	if len(sys.argv) > 1:
+		for path in sys.argv[1:]:
+			header = read_header(path)
+			version, sn76489_clock = struct.unpack_from("<II", header, 8)
+			offset = struct.unpack_from("<I", header, 0x34)[0] + 0x34 if version >= 0x150 else 0x40
+			if sn76489_clock:
+				flags = header[0x2B] if version >= 0x151 else 0
+				ok &= check_sn76489(sn76489_clock & 0x3FFFFFFF, flags)
+			if version >= 0x161 and offset > 0x80:
+				dmg_clock = struct.unpack_from("<I", header, 0x80)[0]
+				if dmg_clock:
+					ok &= check_dmg(dmg_clock & 0x3FFFFFFF)
+	else:
+		for clock in SN76489_CLOCKS:
+			for flags in (0x00, 0x08):
+				ok &= check_sn76489(clock, flags)
+		for clock in DMG_CLOCKS:
+			ok &= check_dmg(clock)
+	sys.exit(0 if ok else 1)